@@ -55,6 +55,30 @@ JNIEXPORT jbyteArray JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_ReadRegister
 JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_WriteRegister
   (JNIEnv *, jobject, jint, jbyteArray);
 
+/*
+ * Class:     com_atmel_Maxtouch_MaxtouchJni
+ * Method:    ReadRegisterDirect
+ * Signature: (ILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_ReadRegisterDirect
+  (JNIEnv *, jobject, jint, jobject, jint, jint);
+
+/*
+ * Class:     com_atmel_Maxtouch_MaxtouchJni
+ * Method:    WriteRegisterDirect
+ * Signature: (ILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_WriteRegisterDirect
+  (JNIEnv *, jobject, jint, jobject, jint, jint);
+
+/*
+ * Class:     com_atmel_Maxtouch_MaxtouchJni
+ * Method:    DrainMessages
+ * Signature: (Ljava/nio/ByteBuffer;I)I
+ */
+JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_DrainMessages
+  (JNIEnv *, jobject, jobject, jint);
+
 /*
  * Class:     com_atmel_Maxtouch_MaxtouchJni
  * Method:    SetDebugEnable
@@ -34,6 +34,8 @@
 #include "com_atmel_Maxtouch_MaxtouchJni.h"
 #include "jni.h"
 #include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/info_block.h"
+#include "libmaxtouch/stats.h"
 #include <android/log.h>
 
 struct libmaxtouch_ctx *ctx;
@@ -146,6 +148,63 @@ JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_WriteRegister
   return ret;
 }
 
+//******************************************************************************
+/// \brief  Get address of count bytes at offset in a direct ByteBuffer
+/// \return pointer into buffer, or NULL if not direct or out of range
+static uint8_t *get_direct_buffer(JNIEnv *env, jobject buffer,
+                                  jint offset, jint count)
+{
+  uint8_t *base;
+  jlong capacity;
+
+  base = (uint8_t *)(*env)->GetDirectBufferAddress(env, buffer);
+  if (base == NULL) {
+    mxt_err(ctx, "ByteBuffer is not direct");
+    return NULL;
+  }
+
+  capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+  if (offset < 0 || count < 0 || (jlong)offset + count > capacity) {
+    mxt_err(ctx, "ByteBuffer range %d+%d outside capacity %lld",
+            offset, count, (long long)capacity);
+    return NULL;
+  }
+
+  return base + offset;
+}
+
+//******************************************************************************
+/// \brief  Read registers from MXT chip into a direct ByteBuffer
+/// \return #mxt_rc
+JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_ReadRegisterDirect
+  (JNIEnv *env, jobject this, jint start_register, jobject buffer,
+   jint offset, jint count)
+{
+  uint8_t *buf;
+
+  buf = get_direct_buffer(env, buffer, offset, count);
+  if (buf == NULL)
+    return MXT_ERROR_BAD_INPUT;
+
+  return mxt_read_register(mxt, buf, start_register, count);
+}
+
+//******************************************************************************
+/// \brief  Write registers to MXT chip from a direct ByteBuffer
+/// \return #mxt_rc
+JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_WriteRegisterDirect
+  (JNIEnv *env, jobject this, jint start_register, jobject buffer,
+   jint offset, jint count)
+{
+  uint8_t *buf;
+
+  buf = get_direct_buffer(env, buffer, offset, count);
+  if (buf == NULL)
+    return MXT_ERROR_BAD_INPUT;
+
+  return mxt_write_register(mxt, buf, start_register, count);
+}
+
 //******************************************************************************
 /// \brief Enable/disable debug output
 JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_SetDebugEnable
@@ -212,6 +271,8 @@ JNIEXPORT jobjectArray JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_GetDebugMessa
   jclass stringClass;
   char *szMessage;
 
+  mxt_lock_device(mxt);
+
   ret = mxt_get_msg_count(mxt, &count);
   /* suppress error and return empty array */
   if (ret)
@@ -232,9 +293,79 @@ JNIEXPORT jobjectArray JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_GetDebugMessa
     }
   }
 
+  mxt_unlock_device(mxt);
+
   return stringarray;
 }
 
+//******************************************************************************
+/// \brief  Drain pending messages into a direct ByteBuffer
+/// \details Each record is a native order uint64_t timestamp in
+///          microseconds (monotonic clock), a uint8_t length, then length
+///          message bytes starting with the report ID. Draining stops when
+///          there is no room for a message of the largest size, T5 less its
+///          CRC byte, so that no message is cut short. Messages not drained
+///          are left pending for the next call. With the dmesg interface at
+///          most 500 messages are taken from the kernel log per call, and
+///          newer ones are returned by later calls.
+/// \return number of records written, or negative #mxt_rc on error
+JNIEXPORT jint JNICALL Java_com_atmel_Maxtouch_MaxtouchJni_DrainMessages
+  (JNIEnv *env, jobject this, jobject buffer, jint offset)
+{
+  uint8_t *buf;
+  uint64_t timestamp;
+  jlong capacity;
+  size_t pos, msg_max;
+  int count, len, i, ret;
+  jint records = 0;
+
+  buf = get_direct_buffer(env, buffer, offset, 0);
+  if (buf == NULL)
+    return -MXT_ERROR_BAD_INPUT;
+
+  capacity = (*env)->GetDirectBufferCapacity(env, buffer) - offset;
+
+  mxt_lock_device(mxt);
+
+  msg_max = mxt_get_object_size(mxt, GEN_MESSAGEPROCESSOR_T5) - 1;
+  if (msg_max == 0 || msg_max > UINT8_MAX)
+    msg_max = UINT8_MAX;
+
+  ret = mxt_get_msg_count(mxt, &count);
+  if (ret) {
+    mxt_unlock_device(mxt);
+    return -ret;
+  }
+
+  pos = 0;
+  for (i = 0; i < count; i++) {
+    /* Leave the message pending rather than cut it short */
+    if ((size_t)capacity - pos < sizeof(timestamp) + 1 + msg_max)
+      break;
+
+    ret = mxt_get_msg_bytes(mxt, buf + pos + sizeof(timestamp) + 1,
+                            msg_max, &len);
+    if (ret == MXT_ERROR_NO_MESSAGE)
+      continue;
+    else if (ret)
+      break;
+
+    /* dmesg lines without a message */
+    if (len == 0)
+      continue;
+
+    timestamp = mxt_stats_now_us();
+    memcpy(buf + pos, &timestamp, sizeof(timestamp));
+    buf[pos + sizeof(timestamp)] = (uint8_t)len;
+    pos += sizeof(timestamp) + 1 + len;
+    records++;
+  }
+
+  mxt_unlock_device(mxt);
+
+  return records;
+}
+
 //******************************************************************************
 /// \brief  Get location of interface in sysfs
 /// \return directory path
@@ -9,9 +9,14 @@ LOCAL_SRC_FILES := \
   msg.c \
   config.c \
   utilfuncs.c \
+  hex.c \
+  stats.c \
+  trace.c \
+  frame.c \
   info_block.c \
   sysfs/sysfs_device.c \
   sysfs/dmesg.c \
+  sysfs/v4l2_touch.c \
   i2c_dev/i2c_dev_device.c \
   hidraw/hidraw_device.c \
   usb/usb_device.c
@@ -34,6 +34,7 @@
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <unistd.h>
 
 #include "libmaxtouch.h"
 #include "info_block.h"
@@ -850,6 +851,66 @@ int mxt_load_config_file(struct mxt_device *mxt, const char *filename)
   return ret;
 }
 
+//******************************************************************************
+/// \brief  Have the kernel driver load configuration from .xcfg or RAW file
+///
+/// The configuration is staged in OBP_RAW format in the firmware directory
+/// and applied through the update_cfg attribute. The driver writes it, backs
+/// it up to NVRAM and resets the device. If the file cannot be staged or the
+/// driver rejects it, nothing has been changed and the caller writes the
+/// configuration directly instead.
+/// \return #mxt_rc, MXT_ERROR_NOT_SUPPORTED if the driver cannot do this
+int mxt_kernel_load_config(struct mxt_device *mxt, const char *filename)
+{
+  struct mxt_config cfg = {{0}};
+  char path[PATH_MAX];
+  char staged[PATH_MAX + 4];
+  int ret;
+
+  if (mxt->conn->type != E_SYSFS || !sysfs_has_attr(mxt, "update_cfg"))
+    return MXT_ERROR_NOT_SUPPORTED;
+
+  ret = mxt_get_config_from_file(mxt->ctx, filename, &cfg);
+  if (ret)
+    return ret;
+
+  ret = sysfs_firmware_path(mxt, SYSFS_CFG_NAME, path, sizeof(path));
+  if (ret)
+    goto fallback;
+
+  /* The driver must never see a partly written file */
+  snprintf(staged, sizeof(staged), "%s.new", path);
+
+  ret = mxt_save_raw_file(mxt->ctx, staged, &cfg);
+  if (ret) {
+    unlink(staged);
+    goto fallback;
+  }
+
+  if (rename(staged, path)) {
+    mxt_warn(mxt->ctx, "Could not stage %s, error %s (%d)",
+             path, strerror(errno), errno);
+    unlink(staged);
+    goto fallback;
+  }
+
+  mxt_info(mxt->ctx, "Staged configuration at %s", path);
+
+  /* Only waiting for the device afterwards is past the point of return */
+  ret = sysfs_update(mxt, "update_cfg", SYSFS_CFG_NAME);
+  if (ret && ret != MXT_ERROR_TIMEOUT)
+    goto fallback;
+
+  goto free;
+
+fallback:
+  mxt_warn(mxt->ctx, "Kernel driver cannot load configuration, writing it directly");
+  ret = MXT_ERROR_NOT_SUPPORTED;
+free:
+  mxt_free_config(&cfg);
+  return ret;
+}
+
 //******************************************************************************
 /// \brief  Save configuration to file
 /// \return #mxt_rc
@@ -957,7 +1018,7 @@ int mxt_checkcrc(struct libmaxtouch_ctx *ctx, struct mxt_device *mxt, char *file
         if (start_pos > sp)
           start_pos = sp;
 
-        int obj_size = mxt_get_object_size(mxt, object->type);
+        int obj_size = MXT_SIZE(*object) * MXT_INSTANCES(*object);
         if (end_pos < (sp + obj_size))
           end_pos = sp + obj_size;
       }
@@ -982,6 +1043,13 @@ int mxt_checkcrc(struct libmaxtouch_ctx *ctx, struct mxt_device *mxt, char *file
       if (cfg.config_type != CONFIG_XCFG)
         off = mxt_get_object_address(mxt, objcfg->type, objcfg->instance);
 
+      if (off + objcfg->size > end_pos) {
+        mxt_warn(ctx, "T%u instance %u outside CRC region",
+                 objcfg->type, objcfg->instance);
+        objcfg = objcfg->next;
+        continue;
+      }
+
       memcpy(buffer + off, objcfg->data, objcfg->size);
     }
 
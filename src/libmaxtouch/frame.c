@@ -0,0 +1,469 @@
+//------------------------------------------------------------------------------
+/// \file   frame.c
+/// \brief  Diagnostic frame acquisition through T37 or V4L2
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+
+#include "libmaxtouch.h"
+#include "info_block.h"
+#include "probe.h"
+
+//******************************************************************************
+/// \brief Retrieve a single page of diagnostic data into buf
+/// \return #mxt_rc
+static int frame_get_page(struct mxt_device *mxt, int pass, int page,
+                          uint8_t *buf)
+{
+  struct mxt_frame_state *fs = &mxt->frame;
+  const struct mxt_frame_layout *l = &fs->layout;
+  int failures;
+  int ret;
+  uint8_t read_command = 1;
+  uint8_t page_up_cmd = PAGE_UP;
+
+  if (pass == 0 && page == 0) {
+    mxt_dbg(mxt->ctx, "Writing mode command %02X", l->mode);
+    ret = mxt_write_register(mxt, &l->mode, fs->diag_cmd_addr, 1);
+    if (ret)
+      return ret;
+  } else {
+    ret = mxt_write_register(mxt, &page_up_cmd, fs->diag_cmd_addr, 1);
+    if (ret)
+      return ret;
+  }
+
+  /* Read back diagnostic register in T6 command processor until it has been
+   * cleared. This means that the chip has actioned the command */
+  failures = 0;
+
+  while (read_command) {
+    usleep(500);
+    ret = mxt_read_register(mxt, &read_command, fs->diag_cmd_addr, 1);
+    if (ret) {
+      mxt_err(mxt->ctx, "Failed to read the status of diagnostic mode command");
+      return ret;
+    }
+
+    if (read_command) {
+      failures++;
+
+      if (failures > 500) {
+        mxt_err(mxt->ctx, "Timeout waiting for command to be actioned");
+        return MXT_ERROR_TIMEOUT;
+      }
+    }
+  }
+
+  ret = mxt_read_register(mxt, buf, fs->t37_addr, fs->t37_size);
+  if (ret) {
+    mxt_err(mxt->ctx, "Failed to read page");
+    return ret;
+  }
+
+  /* First two bytes of T37 are the mode and page */
+  if (buf[0] != l->mode) {
+    mxt_err(mxt->ctx, "Bad mode in diagnostic data read");
+    return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
+  }
+
+  if (buf[1] != (l->pages_per_pass * pass + page)) {
+    mxt_err(mxt->ctx, "Bad page in diagnostic data read");
+    return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
+  }
+
+  MXT_PROBE3(t37__page, l->mode, buf[1], buf + 2);
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Insert self cap or active stylus page at its position in the pass
+static void frame_insert_self_cap(const struct mxt_frame_layout *l,
+                                  const uint8_t *data, int pass, int page,
+                                  int16_t *dst)
+{
+  int values_per_pass = l->y_size + l->x_size;
+  int data_pos;
+  int i;
+
+  for (i = 0; i < l->page_size; i += 2) {
+    data_pos = page * l->page_size/2 + i/2;
+
+    /* The last page may overlap the end of the pass */
+    if (data_pos >= values_per_pass)
+      return;
+
+    dst[values_per_pass * pass + data_pos] = (int16_t)((data[i+1] << 8) | data[i]);
+  }
+}
+
+//******************************************************************************
+/// \brief Insert mutual cap page at the current stripe co-ordinates
+/// \return #mxt_rc
+static int frame_insert_mutual(struct mxt_device *mxt,
+                               const struct mxt_frame_layout *l,
+                               const uint8_t *data, int pass,
+                               int *x_ptr, int *y_ptr, int16_t *dst)
+{
+  int stripe_starty = l->stripe_width * pass;
+  int stripe_endy = stripe_starty + l->stripe_width - 1;
+  int ofs;
+  int i;
+
+  for (i = 0; i < l->page_size; i += 2) {
+    if (*x_ptr > l->x_size) {
+      mxt_err(mxt->ctx, "x pointer overrun");
+      return MXT_INTERNAL_ERROR;
+    }
+
+    ofs = *y_ptr + *x_ptr * l->y_size;
+
+    /* The last page may overlap the end of the matrix */
+    if (ofs >= l->data_values)
+      return MXT_SUCCESS;
+
+    dst[ofs] = (int16_t)((data[i+1] << 8) | data[i]);
+
+    (*y_ptr)++;
+
+    if (*y_ptr > stripe_endy) {
+      *y_ptr = stripe_starty;
+      (*x_ptr)++;
+    }
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief  Start capture through the V4L2 touch device of the kernel driver
+///
+/// Only mutual deltas and references are available this way, and only when
+/// a node has been chosen with mxt_frame_set_v4l2_node(), since the frames
+/// are in touchscreen rather than matrix orientation.
+/// \return #mxt_rc
+static int frame_init_v4l2(struct mxt_device *mxt, uint8_t mode)
+{
+  struct mxt_frame_state *fs = &mxt->frame;
+  char node[PATH_MAX];
+  int ret;
+
+  if (mode != DELTAS_MODE && mode != REFS_MODE)
+    return MXT_ERROR_NOT_SUPPORTED;
+
+  if (!fs->v4l2_node || !fs->v4l2_node[0])
+    return MXT_ERROR_NOT_SUPPORTED;
+
+  if (!strcmp(fs->v4l2_node, MXT_FRAME_V4L2_AUTO)) {
+    ret = v4l2_touch_find(mxt, node, sizeof(node));
+    if (ret)
+      return ret;
+  } else {
+    snprintf(node, sizeof(node), "%s", fs->v4l2_node);
+  }
+
+  ret = v4l2_touch_open(mxt, node, mode, &fs->layout);
+  if (ret)
+    mxt_warn(mxt->ctx, "Unable to capture from %s, using T37", node);
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Look up diagnostic objects and calculate frame layout for mode
+/// \return #mxt_rc
+static int frame_init(struct mxt_device *mxt, uint8_t mode,
+                      struct mxt_frame_layout *layout)
+{
+  struct mxt_frame_state *fs = &mxt->frame;
+  struct mxt_frame_layout *l = &fs->layout;
+  struct mxt_id_info *id = mxt->info.id;
+  uint16_t t6_addr;
+  uint8_t t111_instances;
+  uint8_t t107_instances;
+
+  char *v4l2_node = fs->v4l2_node;
+
+  v4l2_touch_close(mxt);
+  memset(fs, 0, sizeof(*fs));
+  fs->v4l2_node = v4l2_node;
+  l->mode = mode;
+
+  /* Prefer the kernel driver, which does the T37 paging itself */
+  if (frame_init_v4l2(mxt, mode) == MXT_SUCCESS)
+    goto done;
+
+  /* Obtain command processor's address */
+  t6_addr = mxt_get_object_address(mxt, GEN_COMMANDPROCESSOR_T6, 0);
+  if (t6_addr == OBJECT_NOT_FOUND)
+    goto not_found;
+
+  /* T37 commands address */
+  fs->diag_cmd_addr = t6_addr + MXT_T6_DIAGNOSTIC_OFFSET;
+
+  /* Obtain Debug Diagnostic object's address */
+  fs->t37_addr = mxt_get_object_address(mxt, DEBUG_DIAGNOSTIC_T37, 0);
+  if (fs->t37_addr == OBJECT_NOT_FOUND)
+    goto not_found;
+
+  /* Obtain Debug Diagnostic object's size */
+  fs->t37_size = mxt_get_object_size(mxt, DEBUG_DIAGNOSTIC_T37);
+  if (fs->t37_size <= 2 || fs->t37_size > MXT_FRAME_MAX_T37_SIZE)
+    goto not_found;
+
+  t111_instances = mxt_get_object_instances(mxt, SPT_SELFCAPCONFIG_T111);
+  t107_instances = mxt_get_object_instances(mxt, PROCI_ACTIVESTYLUS_T107);
+
+  mxt_dbg(mxt->ctx, "t37_size: %d", fs->t37_size);
+  l->page_size = fs->t37_size - 2;
+  mxt_dbg(mxt->ctx, "page_size: %d", l->page_size);
+
+  switch (mode) {
+  case DELTAS_MODE:
+  case REFS_MODE:
+    if (id->family == 0xA0 && id->variant == 0x00) {
+      /* mXT1386 data is formatted into stripes */
+      l->x_size = 27;
+      l->y_size = id->matrix_y_size;
+      l->data_values = 27 * l->y_size;
+      l->passes = 3;
+      l->pages_per_pass = 8;
+    } else {
+      l->x_size = id->matrix_x_size;
+      l->y_size = id->matrix_y_size;
+      l->data_values = l->x_size * l->y_size;
+      l->passes = 1;
+      l->pages_per_pass = (l->data_values*2 + (l->page_size - 1)) /
+                          l->page_size;
+    }
+
+    l->stripe_width = l->y_size / l->passes;
+    mxt_dbg(mxt->ctx, "stripe_width: %d", l->stripe_width);
+    break;
+
+  case SELF_CAP_SIGNALS:
+  case SELF_CAP_DELTAS:
+  case SELF_CAP_REFS:
+    l->self_cap = true;
+
+    if (id->family != 164) {
+      mxt_err(mxt->ctx, "Self cap data not available");
+      return MXT_ERROR_NOT_SUPPORTED;
+    }
+
+    if (t111_instances == 0) {
+      mxt_err(mxt->ctx, "T111 not found");
+      return MXT_ERROR_OBJECT_NOT_FOUND;
+    }
+
+    // Read Ymax Y values, plus Ymax or 2Ymax X values
+    l->passes = t111_instances;
+    l->y_size = id->matrix_y_size;
+    l->x_size = l->y_size * ((id->matrix_x_size > l->y_size) ? 2 : 1);
+    l->data_values = (l->y_size + l->x_size) * l->passes;
+    l->pages_per_pass = ((l->y_size + l->x_size)*sizeof(uint16_t) + (l->page_size - 1)) /
+                        l->page_size;
+    break;
+
+  case AST_DELTAS:
+  case AST_REFS:
+    l->active_stylus = true;
+
+    if (id->family != 164) {
+      mxt_err(mxt->ctx, "active stylus data not available");
+      return MXT_ERROR_NOT_SUPPORTED;
+    }
+
+    if (t107_instances == 0) {
+      mxt_err(mxt->ctx, "T107 not found");
+      return MXT_ERROR_OBJECT_NOT_FOUND;
+    }
+
+    // Read Ymax Y values, plus Ymax or 2Ymax X values
+    l->passes = t107_instances;
+    l->y_size = 2 * id->matrix_y_size;    // Two scans per axis
+    l->x_size = l->y_size * ((id->matrix_x_size > l->y_size) ? 2 : 1);
+    l->data_values = (l->y_size + l->x_size) * l->passes;
+    l->pages_per_pass = ((l->y_size + l->x_size)*sizeof(uint16_t) + (l->page_size - 1)) /
+                        l->page_size;
+    break;
+
+  default:
+    mxt_err(mxt->ctx, "Unsupported mode %02X", mode);
+    return MXT_ERROR_BAD_INPUT;
+  }
+
+done:
+  mxt_dbg(mxt->ctx, "passes: %d", l->passes);
+  mxt_dbg(mxt->ctx, "pages_per_pass: %d", l->pages_per_pass);
+  mxt_dbg(mxt->ctx, "x_size: %d", l->x_size);
+  mxt_dbg(mxt->ctx, "y_size: %d", l->y_size);
+  mxt_dbg(mxt->ctx, "data_values: %d", l->data_values);
+
+  fs->valid = true;
+
+  if (layout)
+    *layout = *l;
+
+  return MXT_SUCCESS;
+
+not_found:
+  mxt_err(mxt->ctx, "Failed to get object information");
+  return MXT_ERROR_OBJECT_NOT_FOUND;
+}
+
+//******************************************************************************
+/// \brief  Read all pages of one frame into dst
+/// \return #mxt_rc
+static int frame_read(struct mxt_device *mxt, uint8_t mode, int16_t *dst)
+{
+  const struct mxt_frame_layout *l = &mxt->frame.layout;
+  uint8_t buf[MXT_FRAME_MAX_T37_SIZE];
+  int pass;
+  int page;
+  int x_ptr;
+  int y_ptr;
+  int span;
+  int ret;
+
+  if (!mxt->frame.valid || l->mode != mode) {
+    ret = frame_init(mxt, mode, NULL);
+    if (ret)
+      return ret;
+  }
+
+  if (mxt->frame.v4l2.open)
+    return v4l2_touch_read(mxt, dst);
+
+  for (pass = 0; pass < l->passes; pass++) {
+    x_ptr = 0;
+    y_ptr = l->stripe_width * pass;
+
+    for (page = 0; page < l->pages_per_pass; page++) {
+      mxt_dbg(mxt->ctx, "Pass %d Page %d", pass, page);
+
+      span = mxt_trace_begin(mxt->ctx, "t37 page",
+                             l->pages_per_pass * pass + page);
+      ret = frame_get_page(mxt, pass, page, buf);
+      mxt_trace_end(mxt->ctx, span);
+      if (ret)
+        return ret;
+
+      if (l->self_cap || l->active_stylus) {
+        frame_insert_self_cap(l, buf + 2, pass, page, dst);
+      } else {
+        ret = frame_insert_mutual(mxt, l, buf + 2, pass, &x_ptr, &y_ptr, dst);
+        if (ret)
+          return ret;
+      }
+    }
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief  Look up diagnostic objects and calculate frame layout for mode
+///
+/// The layout is kept in the device so that mxt_frame_acquire() does no
+/// further lookups. It is recalculated when the information block is read.
+/// \param  layout  Returns layout, may be NULL
+/// \return #mxt_rc
+int mxt_frame_acquire_init(struct mxt_device *mxt, uint8_t mode,
+                           struct mxt_frame_layout *layout)
+{
+  int ret;
+
+  mxt_lock_device(mxt);
+  ret = frame_init(mxt, mode, layout);
+  mxt_unlock_device(mxt);
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Read one frame of diagnostic data into a caller-owned buffer
+///
+/// dst must hold data_values from the layout returned by
+/// mxt_frame_acquire_init(). Changing mode recalculates the layout. The
+/// device is locked for the whole frame.
+/// \return #mxt_rc
+int mxt_frame_acquire(struct mxt_device *mxt, uint8_t mode, int16_t *dst)
+{
+  int ret;
+
+  mxt_lock_device(mxt);
+  ret = frame_read(mxt, mode, dst);
+  mxt_unlock_device(mxt);
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Choose the V4L2 touch device used for mutual frames
+///
+/// By default frames are read through T37. V4L2 frames are in touchscreen
+/// orientation with the size reported by the driver, so only callers which
+/// do not index them in matrix coordinates should choose a node.
+/// \param  node  Device node, MXT_FRAME_V4L2_AUTO to find the node of the
+///                kernel driver, or NULL or empty string for T37 only
+/// \return #mxt_rc
+int mxt_frame_set_v4l2_node(struct mxt_device *mxt, const char *node)
+{
+  char *copy = NULL;
+
+  if (node) {
+    copy = strdup(node);
+    if (!copy)
+      return MXT_ERROR_NO_MEM;
+  }
+
+  mxt_lock_device(mxt);
+  v4l2_touch_close(mxt);
+  free(mxt->frame.v4l2_node);
+  mxt->frame.v4l2_node = copy;
+  mxt->frame.valid = false;
+  mxt_unlock_device(mxt);
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief  Release frame acquisition resources held by the device
+void mxt_frame_release(struct mxt_device *mxt)
+{
+  v4l2_touch_close(mxt);
+  free(mxt->frame.v4l2_node);
+  mxt->frame.v4l2_node = NULL;
+  mxt->frame.valid = false;
+}
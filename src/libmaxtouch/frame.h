@@ -0,0 +1,89 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   frame.h
+/// \brief  Diagnostic frame acquisition through T37 or V4L2
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sysfs/v4l2_touch.h"
+
+/* T6 Debug Diagnostics Commands */
+#define PAGE_UP           0x01
+#define PAGE_DOWN         0x02
+#define DELTAS_MODE       0x10
+#define REFS_MODE         0x11
+#define SELF_CAP_SIGNALS  0xF5
+#define SELF_CAP_DELTAS   0xF7
+#define SELF_CAP_REFS     0xF8
+#define AST_DELTAS        0xFB
+#define AST_REFS          0xFC
+
+/* V4L2 node which finds the device of the kernel driver */
+#define MXT_FRAME_V4L2_AUTO "auto"
+
+/* Largest object size the object table can describe */
+#define MXT_FRAME_MAX_T37_SIZE 256
+
+struct mxt_device;
+
+//******************************************************************************
+/// \brief Layout of one frame of diagnostic data
+///
+/// Mutual capacitance values are stored X major, so value (x, y) is at
+/// x * y_size + y. Self capacitance and active stylus frames hold y_size Y
+/// values followed by x_size X values for each pass.
+struct mxt_frame_layout {
+  uint8_t mode;                 /*!< T6 diagnostic command */
+  bool self_cap;
+  bool active_stylus;
+  int x_size;
+  int y_size;
+  int passes;                   /*!< Stripes, or T111/T107 instances */
+  int pages_per_pass;
+  int page_size;                /*!< Data bytes in each T37 page */
+  int stripe_width;
+  int data_values;              /*!< int16_t values in one frame */
+};
+
+//******************************************************************************
+/// \brief Acquisition state kept in the device between frames
+struct mxt_frame_state {
+  bool valid;
+  struct mxt_frame_layout layout;
+  uint16_t diag_cmd_addr;
+  uint16_t t37_addr;
+  uint16_t t37_size;
+  struct v4l2_touch v4l2;       /*!< Open when the kernel driver captures */
+  char *v4l2_node;              /*!< NULL or empty for T37 only */
+};
+
+int mxt_frame_acquire_init(struct mxt_device *mxt, uint8_t mode, struct mxt_frame_layout *layout);
+int mxt_frame_acquire(struct mxt_device *mxt, uint8_t mode, int16_t *dst);
+int mxt_frame_set_v4l2_node(struct mxt_device *mxt, const char *node);
+void mxt_frame_release(struct mxt_device *mxt);
@@ -0,0 +1,265 @@
+//------------------------------------------------------------------------------
+/// \file   hex.c
+/// \brief  Hex encoding and decoding of register data
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "libmaxtouch.h"
+#include "hex.h"
+
+static const char hex_chars[16] = "0123456789ABCDEF";
+
+/* Value of each hex digit, X for any other character */
+#define X -1
+static const int8_t hex_values[256] = {
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  X,  X,  X,  X,  X,  X,
+   X, 10, 11, 12, 13, 14, 15,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X, 10, 11, 12, 13, 14, 15,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+};
+#undef X
+
+#if defined(__SSE2__)
+//******************************************************************************
+/// \brief Convert 16 nibbles to upper case hex digits
+static inline __m128i hex_ascii_sse2(__m128i n)
+{
+  __m128i letter = _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+
+  return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')),
+                      _mm_and_si128(letter, _mm_set1_epi8('A' - '0' - 10)));
+}
+
+//******************************************************************************
+/// \brief Encode 16 bytes as 32 hex digits
+static inline void hex_encode16(char *out, const uint8_t *in)
+{
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  __m128i v = _mm_loadu_si128((const __m128i *)in);
+  __m128i hi = hex_ascii_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+  __m128i lo = hex_ascii_sse2(_mm_and_si128(v, mask));
+
+  _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi8(hi, lo));
+  _mm_storeu_si128((__m128i *)(out + 16), _mm_unpackhi_epi8(hi, lo));
+}
+
+//******************************************************************************
+/// \brief Convert 16 hex digits to their values
+/// \return mask with 0xFF in every byte that was a valid digit
+static inline __m128i hex_value_sse2(__m128i c, __m128i *value)
+{
+  const __m128i minus_one = _mm_set1_epi8(-1);
+  __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)),
+                                _mm_set1_epi8('a'));
+  __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(digit, minus_one),
+                                   _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+  __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(letter, minus_one),
+                                    _mm_cmplt_epi8(letter, _mm_set1_epi8(6)));
+
+  *value = _mm_or_si128(
+             _mm_and_si128(is_digit, digit),
+             _mm_and_si128(is_letter,
+                           _mm_add_epi8(letter, _mm_set1_epi8(10))));
+
+  return _mm_or_si128(is_digit, is_letter);
+}
+
+//******************************************************************************
+/// \brief Decode 32 hex digits to 16 bytes
+/// \return false if any character is not a hex digit
+static inline bool hex_decode16(uint8_t *out, const char *in)
+{
+  const __m128i low_byte = _mm_set1_epi16(0x00FF);
+  __m128i a, b, valid_a, valid_b;
+
+  valid_a = hex_value_sse2(_mm_loadu_si128((const __m128i *)in), &a);
+  valid_b = hex_value_sse2(_mm_loadu_si128((const __m128i *)(in + 16)), &b);
+
+  if (_mm_movemask_epi8(_mm_and_si128(valid_a, valid_b)) != 0xFFFF)
+    return false;
+
+  /* Each 16 bit lane holds the high nibble in its low byte */
+  a = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, low_byte), 4),
+                   _mm_srli_epi16(a, 8));
+  b = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, low_byte), 4),
+                   _mm_srli_epi16(b, 8));
+
+  _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(a, b));
+  return true;
+}
+#define HEX_SIMD 1
+
+#elif defined(__ARM_NEON)
+//******************************************************************************
+/// \brief Convert 16 nibbles to upper case hex digits
+static inline uint8x16_t hex_ascii_neon(uint8x16_t n)
+{
+  uint8x16_t letter = vcgtq_u8(n, vdupq_n_u8(9));
+
+  return vaddq_u8(vaddq_u8(n, vdupq_n_u8('0')),
+                  vandq_u8(letter, vdupq_n_u8('A' - '0' - 10)));
+}
+
+//******************************************************************************
+/// \brief Encode 16 bytes as 32 hex digits
+static inline void hex_encode16(char *out, const uint8_t *in)
+{
+  uint8x16_t v = vld1q_u8(in);
+  uint8x16x2_t digits;
+
+  digits.val[0] = hex_ascii_neon(vshrq_n_u8(v, 4));
+  digits.val[1] = hex_ascii_neon(vandq_u8(v, vdupq_n_u8(0x0F)));
+
+  vst2q_u8((uint8_t *)out, digits);
+}
+
+//******************************************************************************
+/// \brief Convert 16 hex digits to their values
+/// \return mask with 0xFF in every byte that was a valid digit
+static inline uint8x16_t hex_value_neon(uint8x16_t c, uint8x16_t *value)
+{
+  uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+  uint8x16_t letter = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)),
+                               vdupq_n_u8('a'));
+  uint8x16_t is_digit = vcltq_u8(digit, vdupq_n_u8(10));
+
+  *value = vbslq_u8(is_digit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+
+  return vorrq_u8(is_digit, vcltq_u8(letter, vdupq_n_u8(6)));
+}
+
+//******************************************************************************
+/// \brief Decode 32 hex digits to 16 bytes
+/// \return false if any character is not a hex digit
+static inline bool hex_decode16(uint8_t *out, const char *in)
+{
+  uint8x16x2_t c = vld2q_u8((const uint8_t *)in);
+  uint8x16_t hi, lo, valid;
+  uint8x8_t folded;
+
+  valid = vandq_u8(hex_value_neon(c.val[0], &hi),
+                   hex_value_neon(c.val[1], &lo));
+  folded = vand_u8(vget_low_u8(valid), vget_high_u8(valid));
+
+  if (vget_lane_u64(vreinterpret_u64_u8(folded), 0) != UINT64_MAX)
+    return false;
+
+  vst1q_u8(out, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+  return true;
+}
+#define HEX_SIMD 1
+#endif
+
+//******************************************************************************
+/// \brief Encode bytes as upper case hex digits, two per byte
+///
+/// The output is not terminated.
+/// \return pointer to end of output
+char *mxt_hex_encode(char *out, const uint8_t *in, size_t len)
+{
+  size_t i = 0;
+
+#ifdef HEX_SIMD
+  for (; i + 16 <= len; i += 16) {
+    hex_encode16(out, in + i);
+    out += 32;
+  }
+#endif
+
+  for (; i < len; i++) {
+    *out++ = hex_chars[in[i] >> 4];
+    *out++ = hex_chars[in[i] & 0x0F];
+  }
+
+  return out;
+}
+
+//******************************************************************************
+/// \brief Encode bytes as upper case hex digits, each byte followed by a space
+///
+/// The output is not terminated.
+/// \return pointer to end of output
+char *mxt_hex_encode_spaced(char *out, const uint8_t *in, size_t len)
+{
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    *out++ = hex_chars[in[i] >> 4];
+    *out++ = hex_chars[in[i] & 0x0F];
+    *out++ = ' ';
+  }
+
+  return out;
+}
+
+//******************************************************************************
+/// \brief Decode len bytes from 2 * len hex digits of either case
+/// \return #mxt_rc
+int mxt_hex_decode(uint8_t *out, const char *in, size_t len)
+{
+  size_t i = 0;
+  int hi, lo;
+
+#ifdef HEX_SIMD
+  for (; i + 16 <= len; i += 16) {
+    if (!hex_decode16(out + i, in + 2 * i))
+      return MXT_ERROR_BAD_INPUT;
+  }
+#endif
+
+  for (; i < len; i++) {
+    hi = hex_values[(uint8_t)in[2 * i]];
+    lo = hex_values[(uint8_t)in[2 * i + 1]];
+    if (hi < 0 || lo < 0)
+      return MXT_ERROR_BAD_INPUT;
+
+    out[i] = (hi << 4) | lo;
+  }
+
+  return MXT_SUCCESS;
+}
@@ -124,10 +124,15 @@ static int hidraw_write_packet(struct mxt_device *mxt, struct hid_packet *write_
   int ret;
   uint8_t pkt_size = write_pkt->rx_bytes + 4; /* allowing for header */
 
+  mxt->stats.syscalls++;
   if ((ret = write(mxt->conn->hidraw.fd, write_pkt, pkt_size)) != pkt_size) {
+    mxt_stats_errno(&mxt->stats, errno);
     mxt_verb(mxt->ctx, "HIDRAW retry");
     usleep(HIDRAW_WRITE_RETRY_DELAY_US);
+    mxt->stats.retries++;
+    mxt->stats.syscalls++;
     if ((ret = write(mxt->conn->hidraw.fd, &write_pkt, pkt_size)) != pkt_size) {
+      mxt_stats_errno(&mxt->stats, errno);
       mxt_err(mxt->ctx, "Error %s (%d) writing to hidraw",
               strerror(errno), errno);
       ret = mxt_errno_to_rc(errno);
@@ -175,7 +180,10 @@ static int hidraw_read_response(struct mxt_device *mxt, struct hid_packet *read_
 
   do {
     ret = read(mxt->conn->hidraw.fd, read_pkt + t_count, count);
+    mxt->stats.syscalls++;
     if ((size_t)ret != count) {
+      mxt_stats_errno(&mxt->stats, errno);
+      mxt->stats.retries++;
       mxt_dbg(mxt->ctx, "Error %s (%d) reading from hidraw",
               strerror(errno), errno);
       ret = mxt_errno_to_rc(errno);
@@ -35,15 +35,22 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 
 struct mxt_device;
 struct mxt_conn_info;
+struct libmaxtouch_ctx;
 
 #include "i2c_dev_device.h"
 #include "libmaxtouch/libmaxtouch.h"
 
+#define I2C_SLAVE       0x0703
 #define I2C_SLAVE_FORCE 0x0706
 
+/* Addresses probed by i2c_dev_scan() */
+#define I2C_DEV_SCAN_FIRST 0x4a
+#define I2C_DEV_SCAN_LAST  0x4d
+
 /* Deep sleep retry delay 25 ms */
 #define I2C_RETRY_DELAY 25000
 
@@ -78,12 +85,14 @@ static int open_and_set_slave_address(struct mxt_device *mxt, int *fd_out)
 
   snprintf(filename, 19, "/dev/i2c-%d", mxt->conn->i2c_dev.adapter);
   fd = open(filename, O_RDWR);
+  mxt->stats.syscalls++;
   if (fd < 0) {
     mxt_err(mxt->ctx, "Could not open %s, error %s (%d)", filename, strerror(errno), errno);
     return mxt_errno_to_rc(errno);
   }
 
   ret = ioctl(fd, I2C_SLAVE_FORCE, mxt->conn->i2c_dev.address);
+  mxt->stats.syscalls++;
   if (ret < 0) {
     mxt_err(mxt->ctx, "Error setting slave address, error %s (%d)", strerror(errno), errno);
     close(fd);
@@ -114,10 +123,15 @@ int i2c_dev_read_register(struct mxt_device *mxt, unsigned char *buf,
   register_buf[0] = start_register & 0xff;
   register_buf[1] = (start_register >> 8) & 0xff;
 
+  mxt->stats.syscalls++;
   if (write(fd, &register_buf, 2) != 2) {
+    mxt_stats_errno(&mxt->stats, errno);
     mxt_verb(mxt->ctx, "I2C retry");
     usleep(I2C_RETRY_DELAY);
+    mxt->stats.retries++;
+    mxt->stats.syscalls++;
     if (write(fd, &register_buf, 2) != 2) {
+      mxt_stats_errno(&mxt->stats, errno);
       mxt_err(mxt->ctx, "Error %s (%d) writing to i2c", strerror(errno), errno);
       ret = mxt_errno_to_rc(errno);
       goto close;
@@ -126,7 +140,9 @@ int i2c_dev_read_register(struct mxt_device *mxt, unsigned char *buf,
 
   ssize_t read_rc;
   read_rc = read(fd, buf, count);
+  mxt->stats.syscalls++;
   if (read_rc < 0) {
+    mxt_stats_errno(&mxt->stats, errno);
     mxt_err(mxt->ctx, "Error %s (%d) reading from i2c", strerror(errno), errno);
     ret = mxt_errno_to_rc(errno);
     goto close;
@@ -141,6 +157,7 @@ int i2c_dev_read_register(struct mxt_device *mxt, unsigned char *buf,
 
 close:
   close(fd);
+  mxt->stats.syscalls++;
   return ret;
 }
 
@@ -166,10 +183,15 @@ int i2c_dev_write_register(struct mxt_device *mxt, unsigned char const *val,
   buf[1] = (start_register >> 8) & 0xff;
   memcpy(buf + 2, val, datalength);
 
+  mxt->stats.syscalls++;
   if (write(fd, buf, count) != count) {
+    mxt_stats_errno(&mxt->stats, errno);
     mxt_verb(mxt->ctx, "I2C retry");
     usleep(I2C_RETRY_DELAY);
+    mxt->stats.retries++;
+    mxt->stats.syscalls++;
     if (write(fd, buf, count) != count) {
+      mxt_stats_errno(&mxt->stats, errno);
       mxt_err(mxt->ctx, "Error %s (%d) writing to i2c", strerror(errno), errno);
       ret = mxt_errno_to_rc(errno);
     } else {
@@ -181,6 +203,7 @@ int i2c_dev_write_register(struct mxt_device *mxt, unsigned char const *val,
 
   free(buf);
   close(fd);
+  mxt->stats.syscalls++;
   return ret;
 }
 
@@ -198,7 +221,9 @@ int i2c_dev_bootloader_read(struct mxt_device *mxt, unsigned char *buf, int coun
 
   mxt_dbg(mxt->ctx, "Reading %d bytes", count);
 
+  mxt->stats.syscalls++;
   if (read(fd, buf, count) != count) {
+    mxt_stats_errno(&mxt->stats, errno);
     mxt_err(mxt->ctx, "Error %s (%d) reading from i2c", strerror(errno), errno);
     ret = mxt_errno_to_rc(errno);
   } else {
@@ -206,6 +231,7 @@ int i2c_dev_bootloader_read(struct mxt_device *mxt, unsigned char *buf, int coun
   }
 
   close(fd);
+  mxt->stats.syscalls++;
   return ret;
 }
 
@@ -227,7 +253,9 @@ int i2c_dev_bootloader_write(struct mxt_device *mxt, unsigned char const *buf,
 
   mxt_dbg(mxt->ctx, "Writing %d bytes", count);
 
+  mxt->stats.syscalls++;
   if (write(fd, buf, count) != count) {
+    mxt_stats_errno(&mxt->stats, errno);
     mxt_err(mxt->ctx, "Error %s (%d) writing to i2c", strerror(errno), errno);
     ret = mxt_errno_to_rc(errno);
   } else {
@@ -236,5 +264,111 @@ int i2c_dev_bootloader_write(struct mxt_device *mxt, unsigned char const *buf,
 
   *bytes_read = count;
   close(fd);
+  mxt->stats.syscalls++;
   return ret;
 }
+
+//******************************************************************************
+/// \brief  Read the ID information of a device on an i2c-dev adapter
+/// \note   Uses I2C_SLAVE rather than I2C_SLAVE_FORCE so that addresses
+///         claimed by a kernel driver are left alone. A single byte is read
+///         first, so that the address pointer is only written to a device
+///         which acknowledges a read transfer.
+/// \return true if a maXTouch device answered
+static bool i2c_dev_probe(struct libmaxtouch_ctx *ctx, int adapter,
+                          int address, struct mxt_id_info *id)
+{
+  char filename[20];
+  unsigned char register_buf[2] = { 0, 0 };
+  unsigned char byte;
+  bool found = false;
+  int fd;
+
+  snprintf(filename, sizeof(filename), "/dev/i2c-%d", adapter);
+  fd = open(filename, O_RDWR);
+  if (fd < 0) {
+    mxt_verb(ctx, "Could not open %s, error %s (%d)",
+             filename, strerror(errno), errno);
+    return false;
+  }
+
+  if (ioctl(fd, I2C_SLAVE, address) < 0) {
+    mxt_verb(ctx, "Skipping %d-%04x, error %s (%d)",
+             adapter, address, strerror(errno), errno);
+    goto close;
+  }
+
+  if (read(fd, &byte, 1) != 1)
+    goto close;
+
+  if (write(fd, register_buf, sizeof(register_buf)) != sizeof(register_buf))
+    goto close;
+
+  if (read(fd, id, sizeof(*id)) != sizeof(*id))
+    goto close;
+
+  found = (id->family != 0x00 && id->family != 0xff);
+
+close:
+  close(fd);
+  return found;
+}
+
+//******************************************************************************
+/// \brief  Probe the i2c-dev adapters named in ctx->i2c_dev_adapters
+/// \note   Probing writes the address pointer of anything which answers at
+///         the standard maXTouch addresses, which unrelated hardware may
+///         not tolerate, so no adapter is probed unless it has been named
+/// \return #mxt_rc
+int i2c_dev_scan(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn)
+{
+  struct mxt_id_info id;
+  struct mxt_conn_info *new_conn;
+  const char *list = ctx->i2c_dev_adapters;
+  char *end;
+  long adapter;
+  int address;
+  int ret;
+
+  if (!list)
+    return MXT_ERROR_NO_DEVICE;
+
+  while (*list) {
+    adapter = strtol(list, &end, 10);
+    if (end == list || adapter < 0 || adapter > INT_MAX
+        || (*end != ',' && *end != '\0')) {
+      mxt_err(ctx, "Invalid i2c-dev adapter list %s", ctx->i2c_dev_adapters);
+      return MXT_ERROR_BAD_INPUT;
+    }
+
+    list = (*end == ',') ? end + 1 : end;
+
+    for (address = I2C_DEV_SCAN_FIRST; address <= I2C_DEV_SCAN_LAST; address++) {
+      if (!i2c_dev_probe(ctx, adapter, address, &id))
+        continue;
+
+      ctx->scan_count++;
+
+      if (ctx->query) {
+        printf("i2c-dev:%ld-%04x Atmel maXTouch family 0x%02X variant 0x%02X\n",
+               adapter, address, id.family, id.variant);
+        continue;
+      }
+
+      ret = mxt_new_conn(&new_conn, E_I2C_DEV);
+      if (ret)
+        return ret;
+
+      new_conn->i2c_dev.adapter = adapter;
+      new_conn->i2c_dev.address = address;
+
+      mxt_dbg(ctx, "Found i2c-dev:%ld-%04x", adapter, address);
+
+      ret = mxt_scan_found(ctx, conn, new_conn);
+      if (ret != MXT_ERROR_NO_DEVICE)
+        return ret;
+    }
+  }
+
+  return MXT_ERROR_NO_DEVICE;
+}
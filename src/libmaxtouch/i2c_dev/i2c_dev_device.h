@@ -42,6 +42,7 @@ struct i2c_dev_conn_info {
 struct i2c_dev_device {
 };
 
+int i2c_dev_scan(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn);
 int i2c_dev_open(struct mxt_device *mxt);
 void i2c_dev_release(struct mxt_device *mxt);
 int i2c_dev_read_register(struct mxt_device *mxt, unsigned char *buf, int start_register, int count, size_t *bytes_transferred);
@@ -37,6 +37,8 @@
 #include "libmaxtouch.h"
 #include "libmaxtouch/sysfs/dmesg.h"
 #include "msg.h"
+#include "hex.h"
+#include "probe.h"
 
 //******************************************************************************
 /// \brief  Initialise libmaxtouch library
@@ -53,6 +55,9 @@ int mxt_new(struct libmaxtouch_ctx **ctx)
   new_ctx->query = false;
   new_ctx->log_fn = mxt_log_stderr;
   new_ctx->i2c_block_size = I2C_DEV_MAX_BLOCK;
+  new_ctx->sysfs_root = SYSFS_I2C_ROOT;
+  new_ctx->firmware_dir = SYSFS_FIRMWARE_DIR;
+  pthread_mutex_init(&new_ctx->lock, NULL);
 
   *ctx = new_ctx;
 
@@ -67,6 +72,9 @@ int mxt_free(struct libmaxtouch_ctx *ctx)
 #ifdef HAVE_LIBUSB
   usb_close(ctx);
 #endif
+  mxt_trace_stop(ctx);
+  mxt_log_async_stop(ctx);
+  pthread_mutex_destroy(&ctx->lock);
   free(ctx);
   return MXT_SUCCESS;
 }
@@ -114,6 +122,141 @@ int mxt_scan(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn,
   return ret;
 }
 
+//******************************************************************************
+/// \brief  Scan for every device on sysfs, i2c-dev and USB
+/// \note   Only the i2c-dev adapters named in ctx->i2c_dev_adapters are
+///         probed, at the standard maXTouch addresses, skipping addresses
+///         claimed by a kernel driver
+/// \return #mxt_rc, MXT_ERROR_NO_DEVICE if nothing was found
+int mxt_scan_all(struct libmaxtouch_ctx *ctx, struct mxt_conn_info ***conns,
+                 int *count)
+{
+  int ret;
+  int (*scan_fn[])(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn) = {
+    sysfs_scan,
+    i2c_dev_scan,
+#ifdef HAVE_LIBUSB
+    usb_scan,
+#endif
+  };
+  size_t i;
+
+  ctx->query = false;
+  ctx->scan_count = 0;
+  ctx->scan_all = true;
+  ctx->scan_list = NULL;
+  ctx->scan_list_len = 0;
+
+  for (i = 0; i < sizeof(scan_fn) / sizeof(scan_fn[0]); i++) {
+    ret = scan_fn[i](ctx, NULL);
+    if (ret == MXT_ERROR_NO_MEM || ret == MXT_ERROR_BAD_INPUT)
+      goto free;
+
+    /* A missing bus does not stop the others being scanned */
+    if (ret != MXT_ERROR_NO_DEVICE)
+      mxt_verb(ctx, "Scan returned %d", ret);
+  }
+
+  if (ctx->scan_list_len == 0) {
+    ret = MXT_ERROR_NO_DEVICE;
+    goto free;
+  }
+
+  *conns = ctx->scan_list;
+  *count = ctx->scan_list_len;
+  ret = MXT_SUCCESS;
+  goto done;
+
+free:
+  mxt_free_conn_list(ctx->scan_list, ctx->scan_list_len);
+done:
+  ctx->scan_all = false;
+  ctx->scan_list = NULL;
+  ctx->scan_list_len = 0;
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Hand a connection found by a scanner back to the caller
+/// \note   Called by the bus scanners. While mxt_scan_all() is running the
+///         connection is added to the list and scanning carries on.
+/// \return MXT_SUCCESS to stop scanning, MXT_ERROR_NO_DEVICE to continue
+int mxt_scan_found(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn,
+                   struct mxt_conn_info *new_conn)
+{
+  struct mxt_conn_info **list;
+
+  if (!ctx->scan_all) {
+    *conn = new_conn;
+    return MXT_SUCCESS;
+  }
+
+  list = realloc(ctx->scan_list,
+                 (ctx->scan_list_len + 1) * sizeof(struct mxt_conn_info *));
+  if (!list) {
+    mxt_unref_conn(new_conn);
+    return MXT_ERROR_NO_MEM;
+  }
+
+  list[ctx->scan_list_len++] = new_conn;
+  ctx->scan_list = list;
+
+  return MXT_ERROR_NO_DEVICE;
+}
+
+//******************************************************************************
+/// \brief  Release a list of connections returned by mxt_scan_all()
+void mxt_free_conn_list(struct mxt_conn_info **conns, int count)
+{
+  int i;
+
+  if (!conns)
+    return;
+
+  for (i = 0; i < count; i++)
+    mxt_unref_conn(conns[i]);
+
+  free(conns);
+}
+
+//******************************************************************************
+/// \brief  Format connection as a device string accepted by mxt-app -d
+/// \return #mxt_rc
+int mxt_conn_name(struct mxt_conn_info *conn, char *buf, size_t buflen)
+{
+  int len;
+
+  switch (conn->type) {
+  case E_SYSFS:
+    len = snprintf(buf, buflen, "sysfs:%s", conn->sysfs.path);
+    break;
+
+#ifdef HAVE_LIBUSB
+  case E_USB:
+    len = snprintf(buf, buflen, "usb:%03d-%03d",
+                   conn->usb.bus, conn->usb.device);
+    break;
+#endif
+
+  case E_I2C_DEV:
+    len = snprintf(buf, buflen, "i2c-dev:%d-%04x",
+                   conn->i2c_dev.adapter, conn->i2c_dev.address);
+    break;
+
+  case E_HIDRAW:
+    len = snprintf(buf, buflen, "hidraw:%s", conn->hidraw.node);
+    break;
+
+  default:
+    return MXT_ERROR_NO_DEVICE;
+  }
+
+  if (len < 0 || (size_t)len >= buflen)
+    return MXT_ERROR_NO_MEM;
+
+  return MXT_SUCCESS;
+}
+
 //******************************************************************************
 /// \brief Create connection object
 /// \return #mxt_rc
@@ -137,7 +280,7 @@ struct mxt_conn_info *mxt_ref_conn(struct mxt_conn_info *conn)
   if (conn == NULL)
     return NULL;
 
-  conn->refcount++;
+  __atomic_add_fetch(&conn->refcount, 1, __ATOMIC_RELAXED);
   return conn;
 }
 
@@ -148,9 +291,7 @@ struct mxt_conn_info *mxt_unref_conn(struct mxt_conn_info *conn)
   if (conn == NULL)
     return NULL;
 
-  conn->refcount--;
-
-  if (conn->refcount > 0)
+  if (__atomic_sub_fetch(&conn->refcount, 1, __ATOMIC_ACQ_REL) > 0)
     return conn;
 
   switch (conn->type) {
@@ -174,19 +315,30 @@ int mxt_new_device(struct libmaxtouch_ctx *ctx, struct mxt_conn_info *conn,
 {
   int ret;
   struct mxt_device *new_dev;
+  pthread_mutexattr_t attr;
+
+  if (conn == NULL) {
+    mxt_err(ctx, "New device connection parameters not valid");
+    return MXT_ERROR_NO_DEVICE;
+  }
 
   new_dev = calloc(1, sizeof(struct mxt_device));
   if (!new_dev)
     return MXT_ERROR_NO_MEM;
 
+  /* Functions holding the lock call each other */
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  ret = pthread_mutex_init(&new_dev->lock, &attr);
+  pthread_mutexattr_destroy(&attr);
+  if (ret) {
+    free(new_dev);
+    return MXT_ERROR_NO_MEM;
+  }
+
   new_dev->ctx = ctx;
   new_dev->conn = mxt_ref_conn(conn);
 
-  if (conn == NULL) {
-    mxt_err(ctx, "New device connection parameters not valid");
-    return MXT_ERROR_NO_DEVICE;
-  }
-
   switch (conn->type) {
   case E_SYSFS:
     ret = sysfs_open(new_dev);
@@ -220,10 +372,44 @@ int mxt_new_device(struct libmaxtouch_ctx *ctx, struct mxt_conn_info *conn,
 
 failure:
   mxt_unref_conn(conn);
+  pthread_mutex_destroy(&new_dev->lock);
   free(new_dev);
   return ret;
 }
 
+//******************************************************************************
+/// \brief Copy transport statistics of device
+void mxt_get_transport_stats(struct mxt_device *mxt,
+                             struct mxt_transport_stats *stats)
+{
+  mxt_lock_device(mxt);
+  *stats = mxt->stats;
+  mxt_unlock_device(mxt);
+}
+
+//******************************************************************************
+/// \brief Clear transport statistics of device
+void mxt_reset_transport_stats(struct mxt_device *mxt)
+{
+  mxt_lock_device(mxt);
+  memset(&mxt->stats, 0, sizeof(mxt->stats));
+  mxt_unlock_device(mxt);
+}
+
+//******************************************************************************
+/// \brief Take device lock to make a sequence of calls one transaction
+void mxt_lock_device(struct mxt_device *mxt)
+{
+  pthread_mutex_lock(&mxt->lock);
+}
+
+//******************************************************************************
+/// \brief Release device lock taken by mxt_lock_device()
+void mxt_unlock_device(struct mxt_device *mxt)
+{
+  pthread_mutex_unlock(&mxt->lock);
+}
+
 //******************************************************************************
 /// \brief Read information block
 /// \return #mxt_rc
@@ -231,25 +417,34 @@ int mxt_get_info(struct mxt_device *mxt)
 {
   int ret;
 
+  mxt_lock_device(mxt);
+  mxt->frame.valid = false;
+
   ret = mxt_read_info_block(mxt);
   if (ret)
-    return ret;
+    goto unlock;
 
   ret = mxt_calc_report_ids(mxt);
   if (ret) {
     mxt_err(mxt->ctx, "Failed to generate report ID look-up table");
-    return ret;
+    goto unlock;
   }
 
   mxt_display_chip_info(mxt);
 
-  return MXT_SUCCESS;
+  ret = MXT_SUCCESS;
+
+unlock:
+  mxt_unlock_device(mxt);
+  return ret;
 }
 
 //******************************************************************************
 /// \brief  Close device
 void mxt_free_device(struct mxt_device *mxt)
 {
+  mxt_frame_release(mxt);
+
   switch (mxt->conn->type) {
   case E_SYSFS:
     sysfs_release(mxt);
@@ -273,9 +468,13 @@ void mxt_free_device(struct mxt_device *mxt)
     mxt_err(mxt->ctx, "Device type not supported");
   }
 
+  pthread_mutex_lock(&mxt->ctx->lock);
+  mxt_stats_merge(&mxt->ctx->transport_stats, &mxt->stats);
+  pthread_mutex_unlock(&mxt->ctx->lock);
 
   mxt->conn = mxt_unref_conn(mxt->conn);
 
+  pthread_mutex_destroy(&mxt->lock);
   free(mxt->info.raw_info);
   free(mxt->report_id_map);
   free(mxt);
@@ -326,7 +525,14 @@ int mxt_read_register(struct mxt_device *mxt, uint8_t *buf,
   int ret;
   size_t received;
   size_t off = 0;
+  uint64_t start_us;
+  int span;
+
+  mxt_lock_device(mxt);
+  start_us = mxt_stats_now_us();
+  span = mxt_trace_begin(mxt->ctx, "read", count);
 
+  MXT_PROBE2(read__start, start_register, count);
   mxt_verb(mxt->ctx, "%s start_register:%d count:%zu", __func__,
            start_register, count);
 
@@ -334,14 +540,21 @@ int mxt_read_register(struct mxt_device *mxt, uint8_t *buf,
     ret = mxt_read_register_block(mxt, buf + off, start_register + off,
                                   count - off, &received);
     if (ret)
-      return ret;
+      goto stats;
 
     off += received;
   }
 
   mxt_log_buffer(mxt->ctx, LOG_VERBOSE, "RX:", buf, count);
-
-  return MXT_SUCCESS;
+  ret = MXT_SUCCESS;
+
+stats:
+  mxt->stats.bytes_read += off;
+  mxt_stats_record(&mxt->stats, MXT_STATS_READ, start_us, ret);
+  mxt_trace_end(mxt->ctx, span);
+  MXT_PROBE3(read__end, start_register, count, ret);
+  mxt_unlock_device(mxt);
+  return ret;
 }
 
 //******************************************************************************
@@ -351,7 +564,14 @@ int mxt_write_register(struct mxt_device *mxt, uint8_t const *buf,
                        int start_register, size_t count)
 {
   int ret;
+  uint64_t start_us;
+  int span;
+
+  mxt_lock_device(mxt);
+  start_us = mxt_stats_now_us();
+  span = mxt_trace_begin(mxt->ctx, "write", count);
 
+  MXT_PROBE2(write__start, start_register, count);
   mxt_verb(mxt->ctx, "%s start_register:%d count:%zu", __func__,
            start_register, count);
 
@@ -379,9 +599,15 @@ int mxt_write_register(struct mxt_device *mxt, uint8_t const *buf,
     ret = MXT_ERROR_NOT_SUPPORTED;
   }
 
-  if (ret == MXT_SUCCESS)
+  if (ret == MXT_SUCCESS) {
     mxt_log_buffer(mxt->ctx, LOG_VERBOSE, "TX:", buf, count);
+    mxt->stats.bytes_written += count;
+  }
 
+  mxt_stats_record(&mxt->stats, MXT_STATS_WRITE, start_us, ret);
+  mxt_trace_end(mxt->ctx, span);
+  MXT_PROBE3(write__end, start_register, count, ret);
+  mxt_unlock_device(mxt);
   return ret;
 }
 
@@ -392,6 +618,8 @@ int mxt_set_debug(struct mxt_device *mxt, bool debug_state)
 {
   int ret;
 
+  mxt_lock_device(mxt);
+
   switch (mxt->conn->type) {
   case E_SYSFS:
     ret = sysfs_set_debug(mxt, debug_state);
@@ -411,6 +639,7 @@ int mxt_set_debug(struct mxt_device *mxt, bool debug_state)
     ret = MXT_ERROR_NOT_SUPPORTED;
   }
 
+  mxt_unlock_device(mxt);
   return ret;
 }
 
@@ -424,6 +653,8 @@ int mxt_get_debug(struct mxt_device *mxt, bool *value)
 {
   int ret;
 
+  mxt_lock_device(mxt);
+
   switch (mxt->conn->type) {
   case E_SYSFS:
     ret = sysfs_get_debug(mxt, value);
@@ -443,6 +674,7 @@ int mxt_get_debug(struct mxt_device *mxt, bool *value)
     mxt_err(mxt->ctx, "Device type not supported");
   }
 
+  mxt_unlock_device(mxt);
   return ret;
 }
 
@@ -630,6 +862,10 @@ int mxt_report_all(struct mxt_device *mxt)
 int mxt_get_msg_count(struct mxt_device *mxt, int *count)
 {
   int ret;
+  uint64_t start_us;
+
+  mxt_lock_device(mxt);
+  start_us = mxt_stats_now_us();
 
   switch (mxt->conn->type) {
   case E_SYSFS:
@@ -654,41 +890,70 @@ int mxt_get_msg_count(struct mxt_device *mxt, int *count)
     break;
   }
 
+  mxt_stats_record(&mxt->stats, MXT_STATS_MSG, start_us, ret);
+  mxt_unlock_device(mxt);
   return ret;
 }
 
 //******************************************************************************
-/// \brief  Get T5 message as string
-/// \return Message string (null for no message)
-char *mxt_get_msg_string(struct mxt_device *mxt)
+/// \brief  Get T5 message as string into caller's buffer
+/// \return #mxt_rc
+int mxt_get_msg_string_r(struct mxt_device *mxt, char *buf, size_t buflen)
 {
-  char *msg_string = NULL;
+  uint8_t databuf[255];
+  size_t prefix_len = strlen(MSG_PREFIX);
+  char *msg;
+  int size;
+  int ret;
 
-  switch (mxt->conn->type) {
-  case E_SYSFS:
-    if (sysfs_has_debug_v2(mxt))
-      msg_string = sysfs_get_msg_string_v2(mxt);
-    else
-      msg_string = dmesg_get_msg_string(mxt);
-    break;
+  mxt_lock_device(mxt);
 
-#ifdef HAVE_LIBUSB
-  case E_USB:
-#endif /* HAVE_LIBUSB */
-  case E_I2C_DEV:
-  case E_HIDRAW:
-    msg_string = t44_get_msg_string(mxt);
-    break;
+  if (mxt->conn->type == E_SYSFS && !sysfs_has_debug_v2(mxt)) {
+    /* Kernel log line is already formatted */
+    msg = dmesg_get_msg_string(mxt);
+    if (!msg) {
+      ret = MXT_ERROR_NO_MESSAGE;
+      goto unlock;
+    }
 
-  default:
-    mxt_err(mxt->ctx, "Device type not supported");
-    break;
+    if (snprintf(buf, buflen, "%s", msg) >= (int)buflen) {
+      ret = MXT_ERROR_NO_MEM;
+      goto unlock;
+    }
+  } else {
+    ret = mxt_get_msg_bytes(mxt, databuf, sizeof(databuf), &size);
+    if (ret)
+      goto unlock;
+
+    /* Two hex digits and a space for each byte */
+    if (buflen < prefix_len + size * 3 + 1) {
+      ret = MXT_ERROR_NO_MEM;
+      goto unlock;
+    }
+
+    strcpy(buf, MSG_PREFIX);
+    *mxt_hex_encode_spaced(buf + prefix_len, databuf, size) = '\0';
   }
 
-  if (msg_string)
-    mxt_dbg(mxt->ctx, "%s", msg_string);
+  mxt_dbg(mxt->ctx, "%s", buf);
+  ret = MXT_SUCCESS;
 
-  return msg_string;
+unlock:
+  mxt_unlock_device(mxt);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Get T5 message as string
+/// \note   Returns the device's message buffer, use mxt_get_msg_string_r()
+///         when several threads read messages
+/// \return Message string (null for no message)
+char *mxt_get_msg_string(struct mxt_device *mxt)
+{
+  if (mxt_get_msg_string_r(mxt, mxt->msg_string, sizeof(mxt->msg_string)))
+    return NULL;
+
+  return mxt->msg_string;
 }
 
 //******************************************************************************
@@ -703,6 +968,8 @@ int mxt_get_msg_bytes(struct mxt_device *mxt, unsigned char *buf,
 {
   int ret;
 
+  mxt_lock_device(mxt);
+
   switch (mxt->conn->type) {
   case E_SYSFS:
     if (sysfs_has_debug_v2(mxt))
@@ -728,6 +995,7 @@ int mxt_get_msg_bytes(struct mxt_device *mxt, unsigned char *buf,
   if (ret == MXT_SUCCESS)
     mxt_log_buffer(mxt->ctx, LOG_DEBUG, MSG_PREFIX, buf, *count);
 
+  mxt_unlock_device(mxt);
   return ret;
 }
 
@@ -738,6 +1006,8 @@ int mxt_msg_reset(struct mxt_device *mxt)
 {
   int ret;
 
+  mxt_lock_device(mxt);
+
   switch (mxt->conn->type) {
   case E_SYSFS:
     if (sysfs_has_debug_v2(mxt))
@@ -761,6 +1031,7 @@ int mxt_msg_reset(struct mxt_device *mxt)
     break;
   }
 
+  mxt_unlock_device(mxt);
   return ret;
 }
 
@@ -782,6 +1053,7 @@ int mxt_msg_wait(struct mxt_device *mxt, int timeout_ms)
   int fd = 0;
   int numfds = 0;
   struct pollfd fds[1];
+  int span;
 
   fd = mxt_get_msg_poll_fd(mxt);
   if (fd) {
@@ -790,7 +1062,9 @@ int mxt_msg_wait(struct mxt_device *mxt, int timeout_ms)
     numfds = 1;
   }
 
+  span = mxt_trace_begin(mxt->ctx, "message wait", timeout_ms);
   ret = poll(fds, numfds, timeout_ms);
+  mxt_trace_end(mxt->ctx, span);
   if (ret == -1 && errno == EINTR) {
     mxt_dbg(mxt->ctx, "Interrupted");
     return MXT_ERROR_INTERRUPTED;
@@ -808,6 +1082,10 @@ int mxt_msg_wait(struct mxt_device *mxt, int timeout_ms)
 int mxt_bootloader_read(struct mxt_device *mxt, unsigned char *buf, int count)
 {
   int ret;
+  uint64_t start_us;
+
+  mxt_lock_device(mxt);
+  start_us = mxt_stats_now_us();
 
   switch (mxt->conn->type) {
 #ifdef HAVE_LIBUSB
@@ -827,6 +1105,11 @@ int mxt_bootloader_read(struct mxt_device *mxt, unsigned char *buf, int count)
     break;
   }
 
+  if (ret == MXT_SUCCESS)
+    mxt->stats.bytes_read += count;
+
+  mxt_stats_record(&mxt->stats, MXT_STATS_BOOTLOADER, start_us, ret);
+  mxt_unlock_device(mxt);
   return ret;
 }
 
@@ -856,6 +1139,10 @@ static int i2c_dev_bootloader_write_blks(struct mxt_device *mxt, unsigned char c
 int mxt_bootloader_write(struct mxt_device *mxt, unsigned char const *buf, int count)
 {
   int ret;
+  uint64_t start_us;
+
+  mxt_lock_device(mxt);
+  start_us = mxt_stats_now_us();
 
   switch (mxt->conn->type) {
 #ifdef HAVE_LIBUSB
@@ -875,6 +1162,11 @@ int mxt_bootloader_write(struct mxt_device *mxt, unsigned char const *buf, int c
     break;
   }
 
+  if (ret == MXT_SUCCESS)
+    mxt->stats.bytes_written += count;
+
+  mxt_stats_record(&mxt->stats, MXT_STATS_BOOTLOADER, start_us, ret);
+  mxt_unlock_device(mxt);
   return ret;
 }
 
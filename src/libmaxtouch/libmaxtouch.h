@@ -35,6 +35,7 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include <signal.h>
+#include <pthread.h>
 
 struct libmaxtouch_ctx;
 struct mxt_device;
@@ -48,6 +49,9 @@ struct mxt_conn_info;
 #endif
 #include "hidraw/hidraw_device.h"
 #include "info_block.h"
+#include "stats.h"
+#include "trace.h"
+#include "frame.h"
 
 /* GEN_COMMANDPROCESSOR_T6 Register offsets from T6 base address */
 #define MXT_T6_RESET_OFFSET      0x00
@@ -130,11 +134,22 @@ enum mxt_device_type {
 struct libmaxtouch_ctx {
   bool query;
   int scan_count;
+  bool scan_all;                  /* Collect every device found */
+  struct mxt_conn_info **scan_list; /* Devices found by mxt_scan_all() */
+  int scan_list_len;
   enum mxt_log_level log_level;
   int i2c_block_size;
+  const char *sysfs_root;         /* Directory of I2C drivers to scan */
+  const char *firmware_dir;       /* Directory kernel loads files from */
+  const char *i2c_dev_adapters;   /* Comma separated i2c-dev adapters to scan,
+                                     NULL to scan none */
 
   void (*log_fn)(struct libmaxtouch_ctx *ctx, enum mxt_log_level level,
                  const char *format, va_list args);
+  struct mxt_log_ring *log_ring;  /* Asynchronous logging state or NULL */
+  struct mxt_transport_stats transport_stats; /* Totals of freed devices */
+  struct mxt_trace *trace;        /* Span recorder or NULL */
+  pthread_mutex_t lock;           /* Protects transport_stats */
 
   union {
 #ifdef HAVE_LIBUSB
@@ -147,7 +162,7 @@ struct libmaxtouch_ctx {
 /// \brief Device connection parameters
 struct mxt_conn_info {
   enum mxt_device_type type;
-  int refcount;
+  int refcount;                   /* Updated atomically */
 
   union {
     struct i2c_dev_conn_info i2c_dev;
@@ -161,12 +176,24 @@ struct mxt_conn_info {
 
 //******************************************************************************
 /// \brief Device context
+///
+/// Device functions may be called from several threads at once. Each call
+/// holds the device lock for the whole transaction, such as a register
+/// access, a message read or a diagnostic frame. A sequence which must not
+/// be interleaved, for example mxt_get_msg_count() followed by reading the
+/// messages, is bracketed with mxt_lock_device() and mxt_unlock_device(),
+/// which nest. Use mxt_get_msg_string_r() rather than mxt_get_msg_string()
+/// from threads. Context set up (logging, tracing) and mxt_free_device() are
+/// not thread safe and are done while only one thread uses the context.
 struct mxt_device {
   struct mxt_conn_info *conn;
   struct libmaxtouch_ctx *ctx;
   struct mxt_info info;
   struct mxt_report_id_map *report_id_map;
   char msg_string[255];
+  struct mxt_transport_stats stats;
+  struct mxt_frame_state frame;
+  pthread_mutex_t lock;           /* Recursive, see mxt_lock_device() */
 
   union {
     struct sysfs_device sysfs;
@@ -180,13 +207,21 @@ struct mxt_device {
 int mxt_new(struct libmaxtouch_ctx **ctx);
 int mxt_free(struct libmaxtouch_ctx *ctx);
 int mxt_scan(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn, bool query);
+int mxt_scan_all(struct libmaxtouch_ctx *ctx, struct mxt_conn_info ***conns, int *count);
+int mxt_scan_found(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn, struct mxt_conn_info *new_conn);
+void mxt_free_conn_list(struct mxt_conn_info **conns, int count);
+int mxt_conn_name(struct mxt_conn_info *conn, char *buf, size_t buflen);
 int mxt_new_conn(struct mxt_conn_info **conn, enum mxt_device_type type);
 struct mxt_conn_info *mxt_ref_conn(struct mxt_conn_info *conn);
 struct mxt_conn_info *mxt_unref_conn(struct mxt_conn_info *conn);
 int mxt_new_device(struct libmaxtouch_ctx *ctx, struct mxt_conn_info *conn, struct mxt_device **mxt);
 void mxt_set_log_fn(struct libmaxtouch_ctx *ctx, void (*log_fn)(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *format, va_list args));
 void mxt_free_device(struct mxt_device *mxt);
+void mxt_lock_device(struct mxt_device *mxt);
+void mxt_unlock_device(struct mxt_device *mxt);
 int mxt_get_info(struct mxt_device *mxt);
+void mxt_get_transport_stats(struct mxt_device *mxt, struct mxt_transport_stats *stats);
+void mxt_reset_transport_stats(struct mxt_device *mxt);
 int mxt_read_register(struct mxt_device *mxt, uint8_t *buf, int start_register, size_t count);
 int mxt_write_register(struct mxt_device *mxt, uint8_t const *buf, int start_register, size_t count);
 int mxt_set_debug(struct mxt_device *mxt, bool debug_state);
@@ -195,10 +230,12 @@ int mxt_reset_chip(struct mxt_device *mxt, bool bootloader_mode);
 int mxt_calibrate_chip(struct mxt_device *mxt);
 int mxt_backup_config(struct mxt_device *mxt, uint8_t backup_command);
 int mxt_load_config_file(struct mxt_device *mxt, const char *cfg_file);
+int mxt_kernel_load_config(struct mxt_device *mxt, const char *filename);
 int mxt_save_config_file(struct mxt_device *mxt, const char *filename);
 int mxt_zero_config(struct mxt_device *mxt);
 int mxt_get_msg_count(struct mxt_device *mxt, int *count);
 char *mxt_get_msg_string(struct mxt_device *mxt);
+int mxt_get_msg_string_r(struct mxt_device *mxt, char *buf, size_t buflen);
 int mxt_get_msg_bytes(struct mxt_device *mxt, unsigned char *buf, size_t buflen, int *count);
 int mxt_msg_reset(struct mxt_device *mxt);
 int mxt_get_msg_poll_fd(struct mxt_device *mxt);
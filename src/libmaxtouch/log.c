@@ -30,9 +30,17 @@
 #include "stdio.h"
 #include "stdint.h"
 #include "malloc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "libmaxtouch.h"
 #include "libmaxtouch/utilfuncs.h"
+#include "libmaxtouch/hex.h"
 
 #if ANDROID
 #include <android/log.h>
@@ -98,28 +106,748 @@ void mxt_set_log_level(struct libmaxtouch_ctx *ctx, uint8_t verbose)
   }
 }
 
+/* Number of records in asynchronous log ring, a power of two */
+#define LOG_RING_SLOTS      4096
+
+/* Bytes of arguments, text or buffer data in one record */
+#define LOG_RECORD_DATA     472
+
+/* Longest single conversion specification, eg "%-08.3lld" */
+#define LOG_SPEC_MAX        16
+
+/* Output collected by the log thread before it is written */
+#define LOG_OUT_SIZE        (64 * 1024)
+
+/* Log thread sleep when the ring is empty */
+#define LOG_IDLE_NS         (1000 * 1000)
+
+enum log_record_kind {
+  LOG_RECORD_FORMAT,      /* format string and packed arguments */
+  LOG_RECORD_TEXT,        /* message formatted by caller */
+  LOG_RECORD_BUFFER,      /* prefix and raw bytes */
+};
+
+enum log_arg {
+  LOG_ARG_NONE,
+  LOG_ARG_INT,
+  LOG_ARG_LONG,
+  LOG_ARG_LLONG,
+  LOG_ARG_SIZE,
+  LOG_ARG_INTMAX,
+  LOG_ARG_PTRDIFF,
+  LOG_ARG_DOUBLE,
+  LOG_ARG_LDOUBLE,
+  LOG_ARG_STR,
+  LOG_ARG_PTR,
+  LOG_ARG_BAD,
+};
+
+//******************************************************************************
+/// \brief Conversion specification within a format string
+struct log_conv {
+  const char *start;      /* The '%' */
+  size_t len;
+  int stars;              /* Width and precision taken from arguments */
+  enum log_arg arg;
+};
+
+//******************************************************************************
+/// \brief Log message as queued by the caller
+///
+/// The format string or buffer prefix is kept by pointer, so callers must
+/// pass string literals, as all callers of the log macros do.
+struct log_record {
+  struct timespec time;
+  const char *format;     /* Format, or prefix of a buffer */
+  uint16_t length;        /* Bytes used in data */
+  uint8_t level;
+  uint8_t kind;
+  uint8_t data[LOG_RECORD_DATA];
+};
+
+//******************************************************************************
+/// \brief Ring slot, seq tells producers and the log thread who owns it
+struct log_slot {
+  uint64_t seq;
+  struct log_record rec;
+};
+
+//******************************************************************************
+/// \brief Asynchronous logging state
+///
+/// Any thread may add records without locking: a slot is claimed by
+/// advancing head with compare and swap, filled, then handed to the log
+/// thread by setting its sequence number. When the ring is full the record
+/// is dropped and counted rather than waiting for the log thread.
+struct mxt_log_ring {
+  struct libmaxtouch_ctx *ctx;
+  struct log_slot *slots;
+  uint64_t head;          /* Next slot to claim */
+  uint64_t tail;          /* Next slot to output, log thread only */
+  unsigned long dropped;
+  unsigned long dropped_reported;
+  bool stop;
+  int fd;
+  pthread_t thread;
+  void (*prev_log_fn)(struct libmaxtouch_ctx *ctx, enum mxt_log_level level,
+                      const char *format, va_list args);
+  char out[LOG_OUT_SIZE];
+  size_t out_len;
+  time_t stamp_sec;       /* Second of cached stamp */
+  char stamp[16];         /* "HH:MM:SS" */
+};
+
+//******************************************************************************
+/// \brief Parse conversion specification starting at '%'
+/// \return pointer after specification
+static const char *log_parse_conv(const char *p, struct log_conv *conv)
+{
+  int longs = 0;
+  char mod = 0;
+
+  conv->start = p++;
+  conv->stars = 0;
+  conv->arg = LOG_ARG_BAD;
+
+  if (*p == '%') {
+    conv->arg = LOG_ARG_NONE;
+    conv->len = 2;
+    return p + 1;
+  }
+
+  while (*p && strchr("-+ #0'", *p))
+    p++;
+
+  if (*p == '*') {
+    conv->stars++;
+    p++;
+  } else {
+    while (isdigit((unsigned char)*p))
+      p++;
+  }
+
+  if (*p == '.') {
+    p++;
+    if (*p == '*') {
+      conv->stars++;
+      p++;
+    } else {
+      while (isdigit((unsigned char)*p))
+        p++;
+    }
+  }
+
+  if (*p == 'h') {
+    p++;
+    if (*p == 'h')
+      p++;
+  } else if (*p == 'l') {
+    longs++;
+    p++;
+    if (*p == 'l') {
+      longs++;
+      p++;
+    }
+  } else if (*p && strchr("Lqzjt", *p)) {
+    mod = *p++;
+  }
+
+  switch (*p) {
+  case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+    if (mod == 'z')
+      conv->arg = LOG_ARG_SIZE;
+    else if (mod == 'j')
+      conv->arg = LOG_ARG_INTMAX;
+    else if (mod == 't')
+      conv->arg = LOG_ARG_PTRDIFF;
+    else if (mod || longs == 2)
+      conv->arg = LOG_ARG_LLONG;
+    else if (longs == 1)
+      conv->arg = LOG_ARG_LONG;
+    else
+      conv->arg = LOG_ARG_INT;
+    break;
+
+  case 'c':
+    if (!longs && !mod)
+      conv->arg = LOG_ARG_INT;
+    break;
+
+  case 'e': case 'E': case 'f': case 'F':
+  case 'g': case 'G': case 'a': case 'A':
+    if (mod == 'L')
+      conv->arg = LOG_ARG_LDOUBLE;
+    else if (!mod && longs < 2)
+      conv->arg = LOG_ARG_DOUBLE;
+    break;
+
+  case 's':
+    if (!longs && !mod)
+      conv->arg = LOG_ARG_STR;
+    break;
+
+  case 'p':
+    conv->arg = LOG_ARG_PTR;
+    break;
+
+  default:
+    /* %n, %m, wide strings and anything unknown */
+    return p;
+  }
+
+  p++;
+  conv->len = p - conv->start;
+  if (conv->len > LOG_SPEC_MAX)
+    conv->arg = LOG_ARG_BAD;
+
+  return p;
+}
+
+#define LOG_PACK(type, value) \
+  do { \
+    type v_ = (value); \
+    if (pos + sizeof(v_) > LOG_RECORD_DATA) \
+      return false; \
+    memcpy(rec->data + pos, &v_, sizeof(v_)); \
+    pos += sizeof(v_); \
+  } while (0)
+
+//******************************************************************************
+/// \brief Copy arguments for format into record
+/// \return false if they do not fit or a conversion is not supported
+static bool log_pack_args(struct log_record *rec, const char *format,
+                          va_list args)
+{
+  struct log_conv conv;
+  const char *p = format;
+  const char *str;
+  size_t pos = 0;
+  size_t len;
+  int i;
+
+  while ((p = strchr(p, '%'))) {
+    p = log_parse_conv(p, &conv);
+
+    for (i = 0; i < conv.stars; i++)
+      LOG_PACK(int, va_arg(args, int));
+
+    switch (conv.arg) {
+    case LOG_ARG_NONE:
+      break;
+    case LOG_ARG_INT:
+      LOG_PACK(int, va_arg(args, int));
+      break;
+    case LOG_ARG_LONG:
+      LOG_PACK(long, va_arg(args, long));
+      break;
+    case LOG_ARG_LLONG:
+      LOG_PACK(long long, va_arg(args, long long));
+      break;
+    case LOG_ARG_SIZE:
+      LOG_PACK(size_t, va_arg(args, size_t));
+      break;
+    case LOG_ARG_INTMAX:
+      LOG_PACK(intmax_t, va_arg(args, intmax_t));
+      break;
+    case LOG_ARG_PTRDIFF:
+      LOG_PACK(ptrdiff_t, va_arg(args, ptrdiff_t));
+      break;
+    case LOG_ARG_DOUBLE:
+      LOG_PACK(double, va_arg(args, double));
+      break;
+    case LOG_ARG_LDOUBLE:
+      LOG_PACK(long double, va_arg(args, long double));
+      break;
+    case LOG_ARG_PTR:
+      LOG_PACK(void *, va_arg(args, void *));
+      break;
+    case LOG_ARG_STR:
+      /* Strings are copied, truncated to the space left */
+      str = va_arg(args, const char *);
+      if (!str)
+        str = "(null)";
+
+      if (pos >= LOG_RECORD_DATA)
+        return false;
+
+      len = strnlen(str, LOG_RECORD_DATA - pos - 1);
+      memcpy(rec->data + pos, str, len);
+      rec->data[pos + len] = '\0';
+      pos += len + 1;
+      break;
+    case LOG_ARG_BAD:
+    default:
+      return false;
+    }
+  }
+
+  rec->length = pos;
+  return true;
+}
+
+#define LOG_UNPACK(type, value) \
+  do { \
+    if (pos + sizeof(type) > rec->length) \
+      return len; \
+    memcpy(&(value), rec->data + pos, sizeof(type)); \
+    pos += sizeof(type); \
+  } while (0)
+
+#define LOG_FORMAT(type) \
+  do { \
+    type v_; \
+    LOG_UNPACK(type, v_); \
+    if (conv.stars == 2) \
+      n = snprintf(out + len, size - len, spec, stars[0], stars[1], v_); \
+    else if (conv.stars == 1) \
+      n = snprintf(out + len, size - len, spec, stars[0], v_); \
+    else \
+      n = snprintf(out + len, size - len, spec, v_); \
+  } while (0)
+
+//******************************************************************************
+/// \brief Format record of packed arguments
+/// \return length of output, which is always terminated
+static size_t log_unpack(const struct log_record *rec, char *out, size_t size)
+{
+  struct log_conv conv;
+  const char *p = rec->format;
+  const char *next;
+  char spec[LOG_SPEC_MAX + 1];
+  int stars[2];
+  size_t pos = 0;
+  size_t len = 0;
+  size_t text;
+  int n;
+  int i;
+
+  out[0] = '\0';
+
+  while (*p && len < size - 1) {
+    next = strchr(p, '%');
+    text = next ? (size_t)(next - p) : strlen(p);
+    if (text > size - 1 - len)
+      text = size - 1 - len;
+
+    memcpy(out + len, p, text);
+    len += text;
+    out[len] = '\0';
+    if (!next)
+      break;
+
+    p = log_parse_conv(next, &conv);
+    memcpy(spec, conv.start, conv.len);
+    spec[conv.len] = '\0';
+
+    for (i = 0; i < conv.stars; i++)
+      LOG_UNPACK(int, stars[i]);
+
+    n = 0;
+    switch (conv.arg) {
+    case LOG_ARG_NONE:
+      n = snprintf(out + len, size - len, "%%");
+      break;
+    case LOG_ARG_INT:
+      LOG_FORMAT(int);
+      break;
+    case LOG_ARG_LONG:
+      LOG_FORMAT(long);
+      break;
+    case LOG_ARG_LLONG:
+      LOG_FORMAT(long long);
+      break;
+    case LOG_ARG_SIZE:
+      LOG_FORMAT(size_t);
+      break;
+    case LOG_ARG_INTMAX:
+      LOG_FORMAT(intmax_t);
+      break;
+    case LOG_ARG_PTRDIFF:
+      LOG_FORMAT(ptrdiff_t);
+      break;
+    case LOG_ARG_DOUBLE:
+      LOG_FORMAT(double);
+      break;
+    case LOG_ARG_LDOUBLE:
+      LOG_FORMAT(long double);
+      break;
+    case LOG_ARG_PTR:
+      LOG_FORMAT(void *);
+      break;
+    case LOG_ARG_STR:
+      if (pos >= rec->length)
+        return len;
+
+      if (conv.stars == 2)
+        n = snprintf(out + len, size - len, spec, stars[0], stars[1],
+                     (const char *)rec->data + pos);
+      else if (conv.stars == 1)
+        n = snprintf(out + len, size - len, spec, stars[0],
+                     (const char *)rec->data + pos);
+      else
+        n = snprintf(out + len, size - len, spec,
+                     (const char *)rec->data + pos);
+
+      pos += strlen((const char *)rec->data + pos) + 1;
+      break;
+    case LOG_ARG_BAD:
+    default:
+      return len;
+    }
+
+    if (n > 0)
+      len += ((size_t)n < size - len) ? (size_t)n : size - 1 - len;
+  }
+
+  return len;
+}
+
+//******************************************************************************
+/// \brief Claim next free slot in ring
+/// \return record to fill, or NULL if the ring is full
+static struct log_slot *log_ring_claim(struct mxt_log_ring *ring)
+{
+  struct log_slot *slot;
+  uint64_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  uint64_t seq;
+
+  for (;;) {
+    slot = &ring->slots[pos & (LOG_RING_SLOTS - 1)];
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+    if (seq == pos) {
+      if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return slot;
+    } else if ((int64_t)(seq - pos) < 0) {
+      __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+      return NULL;
+    } else {
+      pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+//******************************************************************************
+/// \brief Hand filled slot to the log thread
+static void log_ring_publish(struct log_slot *slot)
+{
+  uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+
+  __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+//******************************************************************************
+/// \brief Queue log message without formatting it
+void mxt_log_async(struct libmaxtouch_ctx *ctx, enum mxt_log_level level,
+                   const char *format, va_list args)
+{
+  struct mxt_log_ring *ring = ctx->log_ring;
+  struct log_slot *slot;
+  struct log_record *rec;
+  va_list copy;
+  int len;
+
+  if (!ring) {
+    mxt_log_stderr(ctx, level, format, args);
+    return;
+  }
+
+  slot = log_ring_claim(ring);
+  if (!slot)
+    return;
+
+  rec = &slot->rec;
+  clock_gettime(CLOCK_REALTIME, &rec->time);
+  rec->format = format;
+  rec->level = level;
+  rec->kind = LOG_RECORD_FORMAT;
+
+  va_copy(copy, args);
+  if (!log_pack_args(rec, format, copy)) {
+    /* Unsupported conversion or too long, format it now */
+    len = vsnprintf((char *)rec->data, LOG_RECORD_DATA, format, args);
+    rec->kind = LOG_RECORD_TEXT;
+    rec->length = (len < 0) ? 0
+                  : (len < LOG_RECORD_DATA) ? len : LOG_RECORD_DATA - 1;
+  }
+  va_end(copy);
+
+  log_ring_publish(slot);
+}
+
+#if ENABLE_DEBUG
+//******************************************************************************
+/// \brief Queue raw buffer to be logged as hex
+///
+/// Buffers larger than one record are split across several lines. Only the
+/// prefix pointer is queued, so it must be a string literal.
+static void log_async_buffer(struct libmaxtouch_ctx *ctx,
+                             enum mxt_log_level level, const char *prefix,
+                             const unsigned char *data, size_t count)
+{
+  struct log_slot *slot;
+  struct log_record *rec;
+  size_t len;
+
+  do {
+    len = (count > LOG_RECORD_DATA) ? LOG_RECORD_DATA : count;
+
+    slot = log_ring_claim(ctx->log_ring);
+    if (!slot)
+      return;
+
+    rec = &slot->rec;
+    clock_gettime(CLOCK_REALTIME, &rec->time);
+    rec->format = prefix;
+    rec->level = level;
+    rec->kind = LOG_RECORD_BUFFER;
+    rec->length = len;
+    memcpy(rec->data, data, len);
+
+    log_ring_publish(slot);
+
+    data += len;
+    count -= len;
+  } while (count > 0);
+}
+#endif
+
+//******************************************************************************
+/// \brief Write output collected by the log thread
+static void log_ring_write(struct mxt_log_ring *ring)
+{
+  size_t pos = 0;
+  ssize_t ret;
+
+  while (pos < ring->out_len) {
+    ret = write(ring->fd, ring->out + pos, ring->out_len - pos);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    else if (ret <= 0)
+      break;
+
+    pos += ret;
+  }
+
+  ring->out_len = 0;
+}
+
+//******************************************************************************
+/// \brief Start output line in the style of mxt_log_stderr()
+/// \return pointer to rest of line
+static char *log_line_start(struct mxt_log_ring *ring, char *line,
+                            const struct timespec *time,
+                            enum mxt_log_level level)
+{
+  struct tm tm;
+
+  if (mxt_get_log_level(ring->ctx) >= LOG_INFO)
+    return line;
+
+  if (time->tv_sec != ring->stamp_sec) {
+    localtime_r(&time->tv_sec, &tm);
+    strftime(ring->stamp, sizeof(ring->stamp), "%H:%M:%S", &tm);
+    ring->stamp_sec = time->tv_sec;
+  }
+
+  return line + sprintf(line, "%s.%06ld %c: ", ring->stamp,
+                        time->tv_nsec / 1000, get_log_level_string(level));
+}
+
+//******************************************************************************
+/// \brief Format and output all queued records
+/// \return number of records output
+static unsigned long log_ring_drain(struct mxt_log_ring *ring)
+{
+  /* Time stamp, buffer prefix, largest hex dump and newline */
+  char line[128 + LOG_RECORD_DATA * 3];
+  struct log_slot *slot;
+  struct log_record *rec;
+  struct timespec now;
+  unsigned long dropped;
+  unsigned long count = 0;
+  size_t room;
+  int len;
+  char *p;
+
+  for (;;) {
+    slot = &ring->slots[ring->tail & (LOG_RING_SLOTS - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ring->tail + 1)
+      break;
+
+    rec = &slot->rec;
+    p = log_line_start(ring, line, &rec->time, rec->level);
+
+    switch (rec->kind) {
+    case LOG_RECORD_FORMAT:
+      p += log_unpack(rec, p, line + sizeof(line) - 1 - p);
+      break;
+    case LOG_RECORD_TEXT:
+      memcpy(p, rec->data, rec->length);
+      p += rec->length;
+      break;
+    case LOG_RECORD_BUFFER:
+      /* Prefix is cut short if it leaves no room for the hex dump */
+      room = line + sizeof(line) - 1 - p - rec->length * 3;
+      len = snprintf(p, room, "%s ", rec->format);
+      p += ((size_t)len < room) ? (size_t)len : room - 1;
+      p = mxt_hex_encode_spaced(p, rec->data, rec->length);
+      break;
+    }
+
+    *p++ = '\n';
+
+    /* Slot may be reused once its contents are copied */
+    __atomic_store_n(&slot->seq, ring->tail + LOG_RING_SLOTS,
+                     __ATOMIC_RELEASE);
+    ring->tail++;
+    count++;
+
+    if (ring->out_len + (p - line) > sizeof(ring->out))
+      log_ring_write(ring);
+
+    memcpy(ring->out + ring->out_len, line, p - line);
+    ring->out_len += p - line;
+  }
+
+  dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+  if (dropped != ring->dropped_reported) {
+    clock_gettime(CLOCK_REALTIME, &now);
+    p = log_line_start(ring, line, &now, LOG_WARN);
+    p += sprintf(p, "Log: %lu messages dropped\n",
+                 dropped - ring->dropped_reported);
+    ring->dropped_reported = dropped;
+
+    if (ring->out_len + (p - line) > sizeof(ring->out))
+      log_ring_write(ring);
+
+    memcpy(ring->out + ring->out_len, line, p - line);
+    ring->out_len += p - line;
+  }
+
+  log_ring_write(ring);
+
+  return count;
+}
+
+//******************************************************************************
+/// \brief Log thread, outputs records until asked to stop
+static void *log_ring_thread(void *arg)
+{
+  struct mxt_log_ring *ring = arg;
+  const struct timespec idle = { 0, LOG_IDLE_NS };
+
+  while (!__atomic_load_n(&ring->stop, __ATOMIC_ACQUIRE)) {
+    if (log_ring_drain(ring) == 0)
+      nanosleep(&idle, NULL);
+  }
+
+  log_ring_drain(ring);
+  return NULL;
+}
+
+//******************************************************************************
+/// \brief Send log messages through a ring buffer to a thread writing to fd
+///
+/// Callers only copy the format string pointer and arguments, and buffers
+/// logged by mxt_log_buffer() are converted to hex by the log thread.
+/// \return #mxt_rc
+int mxt_log_async_start(struct libmaxtouch_ctx *ctx, int fd)
+{
+  struct mxt_log_ring *ring;
+  int i;
+
+  if (ctx->log_ring)
+    return MXT_SUCCESS;
+
+  ring = calloc(1, sizeof(struct mxt_log_ring));
+  if (!ring)
+    return MXT_ERROR_NO_MEM;
+
+  ring->slots = calloc(LOG_RING_SLOTS, sizeof(struct log_slot));
+  if (!ring->slots) {
+    free(ring);
+    return MXT_ERROR_NO_MEM;
+  }
+
+  for (i = 0; i < LOG_RING_SLOTS; i++)
+    ring->slots[i].seq = i;
+
+  ring->ctx = ctx;
+  ring->fd = fd;
+  ring->stamp_sec = -1;
+  ring->prev_log_fn = ctx->log_fn;
+
+  if (pthread_create(&ring->thread, NULL, log_ring_thread, ring)) {
+    free(ring->slots);
+    free(ring);
+    return MXT_ERROR_NO_MEM;
+  }
+
+  ctx->log_ring = ring;
+  ctx->log_fn = mxt_log_async;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Output queued log messages and return to synchronous logging
+void mxt_log_async_stop(struct libmaxtouch_ctx *ctx)
+{
+  struct mxt_log_ring *ring = ctx->log_ring;
+
+  if (!ring)
+    return;
+
+  __atomic_store_n(&ring->stop, true, __ATOMIC_RELEASE);
+  pthread_join(ring->thread, NULL);
+
+  if (ctx->log_fn == mxt_log_async)
+    ctx->log_fn = ring->prev_log_fn;
+
+  ctx->log_ring = NULL;
+  free(ring->slots);
+  free(ring);
+}
+
+//******************************************************************************
+/// \brief Number of log messages dropped because the ring was full
+unsigned long mxt_log_async_dropped(struct libmaxtouch_ctx *ctx)
+{
+  if (!ctx->log_ring)
+    return 0;
+
+  return __atomic_load_n(&ctx->log_ring->dropped, __ATOMIC_RELAXED);
+}
+
 //*****************************************************************************
 /// \brief Output buffer to debug as hex
-void mxt_log_buffer(struct libmaxtouch_ctx *ctx, enum mxt_log_level level,
-                    const char *prefix,
-                    const unsigned char *data, size_t count)
+///
+/// Called through the mxt_log_buffer() macro once the level has been checked.
+/// The prefix must be a string literal, since the asynchronous logger formats
+/// the line after this returns.
+void mxt_log_buffer_output(struct libmaxtouch_ctx *ctx,
+                           enum mxt_log_level level, const char *prefix,
+                           const unsigned char *data, size_t count)
 {
 #if ENABLE_DEBUG
-  unsigned int i;
   char *hexbuf;
   size_t strsize = count*3 + 1;
 
-  if (mxt_get_log_level(ctx) > level)
+  /* Leave formatting to the log thread */
+  if (ctx->log_ring && ctx->log_fn == mxt_log_async) {
+    log_async_buffer(ctx, LOG_VERBOSE, prefix, data, count);
     return;
+  }
 
-  hexbuf = (char *)calloc(strsize, sizeof(char));
+  hexbuf = (char *)malloc(strsize);
   if (hexbuf == NULL) {
-    mxt_err(ctx, "%s: calloc failure", __func__);
+    mxt_err(ctx, "%s: malloc failure", __func__);
     return;
   }
 
-  for (i = 0; i < count; i++)
-    sprintf(&hexbuf[3 * i], "%02X ", data[i]);
+  *mxt_hex_encode_spaced(hexbuf, data, count) = '\0';
 
   mxt_log(ctx, LOG_VERBOSE, "%s %s", prefix, hexbuf);
 
@@ -39,6 +39,12 @@
 #define ENABLE_DEBUG     0
 #endif
 
+/* Messages below this level are compiled out, see --with-log-level. By
+ * default every level is built in (subject to ENABLE_DEBUG) */
+#ifndef MXT_LOG_MIN_LEVEL
+#define MXT_LOG_MIN_LEVEL LOG_UNKNOWN
+#endif
+
 
 /* Log levels - designed to match Android's log levels */
 enum mxt_log_level {
@@ -54,23 +60,45 @@ enum mxt_log_level {
 };
 
 struct libmaxtouch_ctx;
+struct mxt_log_ring;
 
 enum mxt_log_level mxt_get_log_level(struct libmaxtouch_ctx *ctx);
 void mxt_set_log_level(struct libmaxtouch_ctx *ctx, uint8_t verbose);
 void mxt_log_stdout(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *format, va_list va_args);
 void mxt_log_stderr(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *format, va_list args);
 void mxt_log_android(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *format, va_list args);
-void mxt_log_buffer(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *prefix, const unsigned char *data, size_t count);
+void mxt_log_buffer_output(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *prefix, const unsigned char *data, size_t count);
+void mxt_log_async(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *format, va_list args);
+int mxt_log_async_start(struct libmaxtouch_ctx *ctx, int fd);
+void mxt_log_async_stop(struct libmaxtouch_ctx *ctx);
+unsigned long mxt_log_async_dropped(struct libmaxtouch_ctx *ctx);
 
 static inline void __attribute__((always_inline, format(printf, 2, 3)))
 mxt_log_null(struct libmaxtouch_ctx *ctx, const char *format, ...) {}
 
 void mxt_log(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *format, ...);
 
+/* Constant false below MXT_LOG_MIN_LEVEL, otherwise an inline check of the
+ * runtime level. Needs struct libmaxtouch_ctx from libmaxtouch.h */
+#define mxt_log_enabled(ctx, level) \
+  ((level) >= MXT_LOG_MIN_LEVEL \
+   && __builtin_expect((level) >= (ctx)->log_level, 0))
+
+/* Arguments are only evaluated if the message will be output. The dead
+ * branch keeps printf format checking for compiled out messages */
 #define mxt_log_cond(ctx, level, arg...) \
   do { \
-  if (level >= mxt_get_log_level(ctx)) \
+  if (mxt_log_enabled(ctx, level)) \
     mxt_log(ctx, level, ## arg); \
+  else if (0) \
+    mxt_log_null(ctx, ## arg); \
+  } while (0)
+
+/* Hex dumps are only built into debug builds */
+#define mxt_log_buffer(ctx, level, prefix, data, count) \
+  do { \
+  if (ENABLE_DEBUG && mxt_log_enabled(ctx, level)) \
+    mxt_log_buffer_output(ctx, level, prefix, data, count); \
   } while (0)
 
 #if ENABLE_LOGGING
@@ -79,8 +107,8 @@ void mxt_log(struct libmaxtouch_ctx *ctx, enum mxt_log_level level, const char *
 #define mxt_verb(ctx, arg...) mxt_log_cond(ctx, LOG_VERBOSE, ## arg)
 #define mxt_dbg(ctx, arg...) mxt_log_cond(ctx, LOG_DEBUG, ## arg)
 #else
-#define mxt_verb(ctx, arg...) mxt_log_null(ctx, ## arg)
-#define mxt_dbg(ctx, arg...) mxt_log_null(ctx, ## arg)
+#define mxt_verb(ctx, arg...) do { if (0) mxt_log_null(ctx, ## arg); } while (0)
+#define mxt_dbg(ctx, arg...) do { if (0) mxt_log_null(ctx, ## arg); } while (0)
 #endif
 
 #define mxt_info(ctx, arg...) mxt_log_cond(ctx, LOG_INFO, ## arg)
@@ -34,6 +34,7 @@
 
 #include "libmaxtouch.h"
 #include "msg.h"
+#include "probe.h"
 
 //******************************************************************************
 /// \brief  Get number of messages
@@ -57,29 +58,6 @@ int t44_get_msg_count(struct mxt_device *mxt, int *count_out)
   return MXT_SUCCESS;
 }
 
-//******************************************************************************
-/// \brief  Get next MSG as a string
-/// \return String or NULL for error
-char *t44_get_msg_string(struct mxt_device *mxt)
-{
-  int ret, i;
-  int size;
-  size_t length;
-  unsigned char databuf[20];
-
-  ret = t44_get_msg_bytes(mxt, databuf, sizeof(databuf), &size);
-  if (ret)
-    return NULL;
-
-  length = snprintf(mxt->msg_string, sizeof(mxt->msg_string), MSG_PREFIX);
-  for (i = 0; i < size; i++) {
-    length += snprintf(mxt->msg_string + length, sizeof(mxt->msg_string) - length,
-                       "%02X ", databuf[i]);
-  }
-
-  return &mxt->msg_string[0];
-}
-
 //******************************************************************************
 /// \brief  Get next MSG into byte buffer
 /// \return #mxt_rc
@@ -140,6 +118,38 @@ int t44_msg_reset(struct mxt_device *mxt)
   return MXT_SUCCESS;
 }
 
+//******************************************************************************
+/// \brief  Read messages already pending and pass them to msg_func
+/// \return #MXT_MSG_CONTINUE when all read, otherwise #mxt_rc
+static int read_pending_messages(struct mxt_device *mxt, void *context,
+                                 int (*msg_func)(struct mxt_device *mxt, uint8_t *msg,
+                                                 void *context, uint8_t size))
+{
+  int count, len;
+  uint8_t buf[10];
+  int ret;
+
+  ret = mxt_get_msg_count(mxt, &count);
+  if (ret)
+    return ret;
+
+  while (count--) {
+    len = 0;
+    ret = mxt_get_msg_bytes(mxt, buf, sizeof(buf), &len);
+    if (ret && ret != MXT_ERROR_NO_MESSAGE)
+      return ret;
+
+    if (len > 0) {
+      MXT_PROBE3(message, buf[0], len, buf);
+      ret = ((*msg_func)(mxt, buf, context, len));
+      if (ret != MXT_MSG_CONTINUE)
+        return ret;
+    }
+  }
+
+  return MXT_MSG_CONTINUE;
+}
+
 //******************************************************************************
 /// \brief Get messages from device and display to user
 /// \param timeout_seconds Represent the time in seconds to continuously
@@ -156,32 +166,19 @@ int mxt_read_messages(struct mxt_device *mxt, int timeout_seconds, void *context
                       int (*msg_func)(struct mxt_device *mxt, uint8_t *msg,
                                       void *context, uint8_t size), int *flag)
 {
-  int count, len;
   time_t now;
   time_t start_time = time(NULL);
-  uint8_t buf[10];
   int ret;
 
   while (!*flag) {
     mxt_msg_wait(mxt, MXT_MSG_POLL_DELAY_MS);
 
-    ret = mxt_get_msg_count(mxt, &count);
-    if (ret)
+    mxt_lock_device(mxt);
+    ret = read_pending_messages(mxt, context, msg_func);
+    mxt_unlock_device(mxt);
+    if (ret != MXT_MSG_CONTINUE)
       return ret;
 
-    while (count--) {
-      len = 0;
-      ret = mxt_get_msg_bytes(mxt, buf, sizeof(buf), &len);
-      if (ret && ret != MXT_ERROR_NO_MESSAGE)
-        return ret;
-
-      if (len > 0) {
-        ret = ((*msg_func)(mxt, buf, context, len));
-        if (ret != MXT_MSG_CONTINUE)
-          return ret;
-      }
-    }
-
     if (timeout_seconds == 0) {
       return MXT_SUCCESS;
     } else if (timeout_seconds > 0) {
@@ -29,7 +29,6 @@
 //------------------------------------------------------------------------------
 
 int t44_get_msg_count(struct mxt_device *mxt, int *count);
-char *t44_get_msg_string(struct mxt_device *mxt);
 int t44_get_msg_bytes(struct mxt_device *mxt, unsigned char *buf, size_t buflen, int *count);
 int t44_msg_reset(struct mxt_device *mxt);
 int mxt_read_messages(struct mxt_device *mxt, int timeout_seconds, void *context, int (*msg_func)(struct mxt_device *mxt, uint8_t *msg, void *context, uint8_t size), int *flag);
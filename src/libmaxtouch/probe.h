@@ -0,0 +1,54 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   probe.h
+/// \brief  USDT static probe points for perf and bpftrace
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+/* Probes are a single NOP until a tracer attaches, and compile out entirely
+ * unless configure found sys/sdt.h. All are in provider "mxt", eg:
+ *   bpftrace -e 'usdt:./mxt-app:mxt:read__end { @[arg2] = count(); }'
+ *
+ *   read__start(register, count)       read__end(register, count, rc)
+ *   write__start(register, count)      write__end(register, count, rc)
+ *   message(report_id, length, data)
+ *   t37__page(mode, page, data)
+ *   bootloader__frame(frame, size, rc)
+ *   bridge__line(line)                 bridge__frame(opcode, seq, address, count)
+ */
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define MXT_PROBE1(name, a) DTRACE_PROBE1(mxt, name, a)
+#define MXT_PROBE2(name, a, b) DTRACE_PROBE2(mxt, name, a, b)
+#define MXT_PROBE3(name, a, b, c) DTRACE_PROBE3(mxt, name, a, b, c)
+#define MXT_PROBE4(name, a, b, c, d) DTRACE_PROBE4(mxt, name, a, b, c, d)
+#else
+#define MXT_PROBE1(name, a) do { } while (0)
+#define MXT_PROBE2(name, a, b) do { } while (0)
+#define MXT_PROBE3(name, a, b, c) do { } while (0)
+#define MXT_PROBE4(name, a, b, c, d) do { } while (0)
+#endif
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+/// \file   stats.c
+/// \brief  Transport statistics for maXTouch devices
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <time.h>
+
+#include "stats.h"
+
+static const char * const mxt_stats_op_names[MXT_STATS_OPS] = {
+  "read", "write", "msg", "bootloader"
+};
+
+//******************************************************************************
+/// \brief Monotonic time in microseconds
+uint64_t mxt_stats_now_us(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+//******************************************************************************
+/// \brief Add one time to histogram
+void mxt_stats_add(struct mxt_stats_histogram *hist, uint64_t us)
+{
+  int bucket = 0;
+
+  if (us >= 2)
+    bucket = 63 - __builtin_clzll(us);
+
+  if (bucket >= MXT_STATS_BUCKETS)
+    bucket = MXT_STATS_BUCKETS - 1;
+
+  hist->buckets[bucket]++;
+  hist->count++;
+  hist->total_us += us;
+  if (us > hist->max_us)
+    hist->max_us = us;
+}
+
+//******************************************************************************
+/// \brief Record one operation started at start_us, with result ret
+void mxt_stats_record(struct mxt_transport_stats *stats, enum mxt_stats_op op,
+                      uint64_t start_us, int ret)
+{
+  struct mxt_stats_histogram *hist = &stats->latency[op];
+
+  mxt_stats_add(hist, mxt_stats_now_us() - start_us);
+
+  if (ret)
+    hist->errors++;
+}
+
+//******************************************************************************
+/// \brief Add statistics of one device to running totals
+void mxt_stats_merge(struct mxt_transport_stats *total,
+                     const struct mxt_transport_stats *stats)
+{
+  int op, i;
+
+  for (op = 0; op < MXT_STATS_OPS; op++) {
+    struct mxt_stats_histogram *t = &total->latency[op];
+    const struct mxt_stats_histogram *s = &stats->latency[op];
+
+    t->count += s->count;
+    t->errors += s->errors;
+    t->total_us += s->total_us;
+    if (s->max_us > t->max_us)
+      t->max_us = s->max_us;
+
+    for (i = 0; i < MXT_STATS_BUCKETS; i++)
+      t->buckets[i] += s->buckets[i];
+  }
+
+  total->bytes_read += stats->bytes_read;
+  total->bytes_written += stats->bytes_written;
+  total->syscalls += stats->syscalls;
+  total->retries += stats->retries;
+  total->naks += stats->naks;
+  total->eagain += stats->eagain;
+}
+
+//******************************************************************************
+/// \brief Estimate percentile from histogram
+/// \return upper bound of bucket holding the percentile, in microseconds
+uint64_t mxt_stats_percentile(const struct mxt_stats_histogram *hist, int pct)
+{
+  unsigned long target;
+  unsigned long seen = 0;
+  uint64_t bound;
+  int i;
+
+  if (hist->count == 0)
+    return 0;
+
+  /* Rank of sample, rounded up */
+  target = (hist->count * pct + 99) / 100;
+  if (target == 0)
+    target = 1;
+
+  for (i = 0; i < MXT_STATS_BUCKETS - 1; i++) {
+    seen += hist->buckets[i];
+    if (seen >= target) {
+      bound = 2ULL << i;
+      return (bound < hist->max_us) ? bound : hist->max_us;
+    }
+  }
+
+  return hist->max_us;
+}
+
+//******************************************************************************
+/// \brief Name of operation
+const char *mxt_stats_op_name(enum mxt_stats_op op)
+{
+  if (op >= MXT_STATS_OPS)
+    return "unknown";
+
+  return mxt_stats_op_names[op];
+}
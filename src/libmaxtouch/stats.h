@@ -0,0 +1,94 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   stats.h
+/// \brief  Transport statistics for maXTouch devices
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <errno.h>
+
+/* Power of two microsecond buckets, the last also holds anything slower */
+#define MXT_STATS_BUCKETS 21
+
+//******************************************************************************
+/// \brief Operations for which latency is recorded
+enum mxt_stats_op {
+  MXT_STATS_READ,               /*!< mxt_read_register() */
+  MXT_STATS_WRITE,              /*!< mxt_write_register() */
+  MXT_STATS_MSG,                /*!< mxt_get_msg_count(), includes its reads */
+  MXT_STATS_BOOTLOADER,         /*!< mxt_bootloader_read()/write() */
+  MXT_STATS_OPS
+};
+
+//******************************************************************************
+/// \brief Latency histogram
+///
+/// Bucket 0 counts times under 2us, bucket n times from 2^n to 2^(n+1) us.
+struct mxt_stats_histogram {
+  unsigned long count;
+  unsigned long errors;
+  uint64_t total_us;
+  uint64_t max_us;
+  unsigned long buckets[MXT_STATS_BUCKETS];
+};
+
+//******************************************************************************
+/// \brief Transport statistics
+///
+/// Counters are plain fields updated in place by the transport code, which
+/// always runs with the device lock held, so collection takes no further locks
+/// and never allocates. Read or reset them through mxt_get_transport_stats()
+/// and mxt_reset_transport_stats(), which take the same lock. Totals of freed
+/// devices are merged into the context under its own lock.
+struct mxt_transport_stats {
+  struct mxt_stats_histogram latency[MXT_STATS_OPS];
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+  unsigned long syscalls;       /*!< I/O system calls and USB transfers */
+  unsigned long retries;        /*!< Transfers repeated after a failure */
+  unsigned long naks;           /*!< I2C NAKs seen by driver or bridge chip */
+  unsigned long eagain;         /*!< EAGAIN/EWOULDBLOCK returns */
+};
+
+uint64_t mxt_stats_now_us(void);
+void mxt_stats_add(struct mxt_stats_histogram *hist, uint64_t us);
+void mxt_stats_record(struct mxt_transport_stats *stats, enum mxt_stats_op op,
+                      uint64_t start_us, int ret);
+void mxt_stats_merge(struct mxt_transport_stats *total,
+                     const struct mxt_transport_stats *stats);
+uint64_t mxt_stats_percentile(const struct mxt_stats_histogram *hist, int pct);
+const char *mxt_stats_op_name(enum mxt_stats_op op);
+
+//******************************************************************************
+/// \brief Classify errno from a failed transport system call
+static inline void mxt_stats_errno(struct mxt_transport_stats *stats, int err)
+{
+  if (err == EAGAIN || err == EWOULDBLOCK)
+    stats->eagain++;
+  else if (err == ENXIO || err == EREMOTEIO)
+    stats->naks++;
+}
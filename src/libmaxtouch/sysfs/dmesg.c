@@ -115,18 +115,82 @@ static void dmesg_list_empty(struct mxt_device *mxt)
   return;
 }
 
+//******************************************************************************
+/// \brief  Walk kernel log lines from newest to oldest, stopping at the first
+///         line not newer than the timestamp
+/// \param  mxt  Maxtouch Device
+/// \param  ep  Length of log in buffer
+/// \param  skip  Number of newest messages to pass over without adding
+/// \param  add  Add messages to the list, otherwise only count them
+/// \param  last_sec  Returns time of newest line read, unchanged if none
+/// \param  last_msec  Microseconds of newest line read
+/// \return Number of new messages, including those skipped
+static int dmesg_walk(struct mxt_device *mxt, int ep, int skip, bool add,
+                      unsigned long *last_sec, unsigned long *last_msec)
+{
+  char msg[BUFFERSIZE];
+  char *msgptr;
+  int sp = ep;
+  int found = 0;
+  unsigned long sec, msec;
+  bool newest = true;
+
+  // Search for next new line character
+  while (true) {
+    sp--;
+    while (sp >= 0 && *(mxt->sysfs.debug_msg_buf + sp) != '\n')
+      sp--;
+
+    if (sp <= 0)
+      break;
+
+    // Try to parse dmesg line
+    if (sscanf(mxt->sysfs.debug_msg_buf+sp+1, "< %*c>[ %lu.%06lu] %255[^\n]",
+               &sec, &msec, msg) != 3)
+      continue;
+
+    // Timestamp must be greater than previous messages, slightly
+    // complicated by seconds and microseconds
+    if ((sec == mxt->sysfs.timestamp && msec <= mxt->sysfs.mtimestamp) ||
+        (sec < mxt->sysfs.timestamp))
+      break;
+
+    // Lines newer than a skipped message must be read again next time
+    if (newest && found >= skip) {
+      *last_sec = sec;
+      *last_msec = msec;
+      newest = false;
+    }
+
+    msg[sizeof(msg) - 1] = '\0';
+    msgptr = strstr(msg, "MXT MSG");
+    if (!msgptr)
+      continue;
+
+    found++;
+    if (add && found > skip)
+      dmesg_list_add(mxt, sec, msec, msgptr);
+  }
+
+  return found;
+}
+
 //******************************************************************************
 /// \brief  Get messages
+///
+/// At most MAX_DMESG_COUNT messages are returned at a time, which keeps within
+/// the JNI reference limit. These are the oldest ones, and any newer ones are
+/// left for the next call.
 /// \param  mxt  Maxtouch Device
 /// \param  count Number of messages available
 /// \param  init_timestamp Read newest dmesg line and initialise timestamp
 /// \return #mxt_rc
 int dmesg_get_msgs(struct mxt_device *mxt, int *count, bool init_timestamp)
 {
-  char msg[BUFFERSIZE];
   int ep, sp;
+  int found;
   int ret = MXT_SUCCESS;
-  unsigned long sec, msec, lastsec = 0, lastmsec = 0;
+  unsigned long sec, msec;
 
   // Read entire kernel log buffer
   ep = klogctl(SYSLOG_ACTION_READ_ALL, mxt->sysfs.debug_msg_buf,
@@ -134,16 +198,15 @@ int dmesg_get_msgs(struct mxt_device *mxt, int *count, bool init_timestamp)
   // Return if no bytes read
   if (ep < 0) {
     mxt_warn(mxt->ctx, "klogctl error %d (%s)", errno, strerror(errno));
-    ret = mxt_errno_to_rc(errno);
-  } else {
-    // null terminate
-    mxt->sysfs.debug_msg_buf[ep] = 0;
-    sp = ep;
+    return mxt_errno_to_rc(errno);
+  }
 
-    if (!init_timestamp)
-      dmesg_list_empty(mxt);
+  // null terminate
+  mxt->sysfs.debug_msg_buf[ep] = 0;
 
-    // Search for next new line character
+  if (init_timestamp) {
+    // Find newest dmesg line
+    sp = ep;
     while (true) {
       sp--;
       while (sp >= 0 && *(mxt->sysfs.debug_msg_buf + sp) != '\n')
@@ -152,51 +215,41 @@ int dmesg_get_msgs(struct mxt_device *mxt, int *count, bool init_timestamp)
       if (sp <= 0)
         break;
 
-      // Try to parse dmesg line
-      if (sscanf(mxt->sysfs.debug_msg_buf+sp+1, "< %*c>[ %lu.%06lu] %255[^\n]",
-                 &sec, &msec, msg) == 3) {
-        if (init_timestamp) {
-          mxt->sysfs.timestamp = sec;
-          mxt->sysfs.mtimestamp = msec;
-          mxt_verb(mxt->ctx, "%s - init [%5lu.%06lu]", __func__, sec, msec);
-          break;
-        }
-
-        // Store time of last message in buffer
-        if (lastsec == 0) {
-          lastsec = sec;
-          lastmsec = msec;
-        }
-
-        // Only 500 at a time, otherwise we overrun JNI reference limit.
-        // Timestamp must be greater than previous messages, slightly
-        // complicated by seconds and microseconds
-        if ((mxt->sysfs.dmesg_count > MAX_DMESG_COUNT) ||
-            (sec == mxt->sysfs.timestamp && msec <= mxt->sysfs.mtimestamp) ||
-            (sec < mxt->sysfs.timestamp)) {
-          mxt->sysfs.timestamp = lastsec;
-          mxt->sysfs.mtimestamp = lastmsec;
-          break;
-        }
-
-        char* msgptr;
-        msg[sizeof(msg) - 1] = '\0';
-        msgptr = strstr(msg, "MXT MSG");
-        if (msgptr)
-          dmesg_list_add(mxt, sec, msec, msgptr);
+      if (sscanf(mxt->sysfs.debug_msg_buf+sp+1, "< %*c>[ %lu.%06lu]",
+                 &sec, &msec) == 2) {
+        mxt->sysfs.timestamp = sec;
+        mxt->sysfs.mtimestamp = msec;
+        mxt_verb(mxt->ctx, "%s - init [%5lu.%06lu]", __func__, sec, msec);
+        break;
       }
     }
 
-    if (!init_timestamp) {
-      *count = mxt->sysfs.dmesg_count;
-      mxt->sysfs.dmesg_ptr = mxt->sysfs.dmesg_head;
-    }
+    return ret;
+  }
+
+  dmesg_list_empty(mxt);
+
+  sec = mxt->sysfs.timestamp;
+  msec = mxt->sysfs.mtimestamp;
+
+  found = dmesg_walk(mxt, ep, 0, false, &sec, &msec);
+  if (found > MAX_DMESG_COUNT) {
+    sec = mxt->sysfs.timestamp;
+    msec = mxt->sysfs.mtimestamp;
+    dmesg_walk(mxt, ep, found - MAX_DMESG_COUNT, true, &sec, &msec);
+  } else if (found > 0) {
+    dmesg_walk(mxt, ep, 0, true, &sec, &msec);
   }
 
+  mxt->sysfs.timestamp = sec;
+  mxt->sysfs.mtimestamp = msec;
+
+  *count = mxt->sysfs.dmesg_count;
+  mxt->sysfs.dmesg_ptr = mxt->sysfs.dmesg_head;
+
   return ret;
 }
 
-
 //******************************************************************************
 /// \brief  Update the timestamp from the klog messages
 /// \param  mxt  Maxtouch Device
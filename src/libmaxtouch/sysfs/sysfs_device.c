@@ -38,14 +38,13 @@
 #include <malloc.h>
 #include <stdio.h>
 #include <libgen.h>
+#include <time.h>
 
 #include "libmaxtouch/log.h"
 #include "libmaxtouch/libmaxtouch.h"
 #include "sysfs_device.h"
 #include "dmesg.h"
 
-#define SYSFS_I2C_ROOT "/sys/bus/i2c/drivers/"
-
 //******************************************************************************
 /// \brief Construct filename of path
 static char *make_path(struct mxt_device *mxt, const char *filename)
@@ -167,8 +166,14 @@ static int scan_sysfs_directory(struct libmaxtouch_ctx *ctx,
       printf("sysfs:%s Atmel %s interface\n", pszDirname,
              debug_v2_found ? "Debug V2" : "Debug");
     } else {
-      ret = sysfs_new_connection(ctx, conn, pszDirname, acpi);
+      struct mxt_conn_info *new_conn;
+
+      ret = sysfs_new_connection(ctx, &new_conn, pszDirname, acpi);
+      if (ret)
+        goto close;
+
       mxt_dbg(ctx, "Found %s", pszDirname);
+      ret = mxt_scan_found(ctx, conn, new_conn);
       goto close;
     }
   } else {
@@ -201,14 +206,14 @@ static int scan_driver_directory(struct libmaxtouch_ctx *ctx,
   unsigned char acpi[PATH_MAX];
   int ret;
 
-  length = strlen(path) + strlen(dir->d_name) + 1;
+  length = strlen(path) + strlen(dir->d_name) + 2;
 
   if ((pszDirname = (char *)calloc(length, sizeof(char))) == NULL) {
     mxt_err(ctx, "calloc failure");
     return MXT_ERROR_NO_MEM;
   }
 
-  snprintf(pszDirname, length, "%s%s", path, dir->d_name);
+  snprintf(pszDirname, length, "%s/%s", path, dir->d_name);
 
   pDirectory = opendir(pszDirname);
   if (pDirectory == NULL) {
@@ -252,7 +257,7 @@ int sysfs_scan(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn)
   int ret;
 
   // Look in sysfs for driver entries
-  pDirectory = opendir(SYSFS_I2C_ROOT);
+  pDirectory = opendir(ctx->sysfs_root);
   if (!pDirectory)
     return MXT_ERROR_NO_DEVICE;
 
@@ -260,7 +265,7 @@ int sysfs_scan(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn)
     if (!strcmp(pEntry->d_name, ".") || !strcmp(pEntry->d_name, ".."))
       continue;
 
-    ret = scan_driver_directory(ctx, conn, SYSFS_I2C_ROOT, pEntry);
+    ret = scan_driver_directory(ctx, conn, ctx->sysfs_root, pEntry);
 
     // If found or error finish
     if (ret != MXT_ERROR_NO_DEVICE) goto close;
@@ -347,6 +352,7 @@ static int open_device_file(struct mxt_device *mxt, int *fd_out)
   }
 
   fd = open(mxt->sysfs.mem_access_path, O_RDWR);
+  mxt->stats.syscalls++;
 
   if (fd < 0) {
     mxt_err(mxt->ctx, "Could not open %s, error %s (%d)",
@@ -372,6 +378,7 @@ int sysfs_read_register(struct mxt_device *mxt, unsigned char *buf,
   if (ret)
     return ret;
 
+  mxt->stats.syscalls++;
   if (lseek(fd, start_register, 0) < 0) {
     mxt_err(mxt->ctx, "lseek error %s (%d)", strerror(errno), errno);
     ret = mxt_errno_to_rc(errno);
@@ -381,10 +388,12 @@ int sysfs_read_register(struct mxt_device *mxt, unsigned char *buf,
   *bytes_read = 0;
   while (*bytes_read < count) {
     ret = read(fd, buf + *bytes_read, count - *bytes_read);
+    mxt->stats.syscalls++;
     if (ret == 0) {
       ret = MXT_ERROR_IO;
       goto close;
     } else if (ret < 0) {
+      mxt_stats_errno(&mxt->stats, errno);
       mxt_err(mxt->ctx, "read error %s (%d)", strerror(errno), errno);
       ret = mxt_errno_to_rc(errno);
       goto close;
@@ -397,6 +406,7 @@ int sysfs_read_register(struct mxt_device *mxt, unsigned char *buf,
 
 close:
   close(fd);
+  mxt->stats.syscalls++;
   return ret;
 }
 
@@ -414,6 +424,7 @@ int sysfs_write_register(struct mxt_device *mxt, unsigned char const *buf,
   if (ret)
     return ret;
 
+  mxt->stats.syscalls++;
   if (lseek(fd, start_register, 0) < 0) {
     mxt_err(mxt->ctx, "lseek error %s (%d)", strerror(errno), errno);
     ret = mxt_errno_to_rc(errno);
@@ -423,10 +434,12 @@ int sysfs_write_register(struct mxt_device *mxt, unsigned char const *buf,
   bytes_written = 0;
   while (bytes_written < count) {
     ret = write(fd, buf+bytes_written, count - bytes_written);
+    mxt->stats.syscalls++;
     if (ret == 0) {
       ret = MXT_ERROR_IO;
       goto close;
     } else if (ret < 0) {
+      mxt_stats_errno(&mxt->stats, errno);
       mxt_err(mxt->ctx, "Error %s (%d) writing to register", strerror(errno), errno);
       ret = mxt_errno_to_rc(errno);
       goto close;
@@ -439,6 +452,7 @@ int sysfs_write_register(struct mxt_device *mxt, unsigned char const *buf,
 
 close:
   close(fd);
+  mxt->stats.syscalls++;
 
   return ret;
 }
@@ -550,31 +564,6 @@ int sysfs_set_debug(struct mxt_device *mxt, bool debug_state)
   return ret;
 }
 
-//******************************************************************************
-/// \brief  Get debug message string
-/// \param  mxt Device context
-/// \return C string or NULL
-char *sysfs_get_msg_string_v2(struct mxt_device *mxt)
-{
-  int ret, i;
-  int size;
-  size_t length;
-  unsigned char databuf[20];
-  static char msg_string[255];
-
-  ret = sysfs_get_msg_bytes_v2(mxt, &databuf[0], sizeof(databuf), &size);
-  if (ret)
-    return NULL;
-
-  length = snprintf(msg_string, sizeof(msg_string), "MXT MSG:");
-  for (i = 0; i < size; i++) {
-    length += snprintf(msg_string + length, sizeof(msg_string) - length,
-                       "%02X ", databuf[i]);
-  }
-
-  return &msg_string[0];
-}
-
 //******************************************************************************
 /// \brief Get debug message bytes
 /// \param  mxt Device context
@@ -646,6 +635,7 @@ int sysfs_get_msgs_v2(struct mxt_device *mxt, int *count)
   filename = make_path(mxt, "debug_msg");
 
   ret = stat(filename, &filestat);
+  mxt->stats.syscalls++;
   if (ret < 0) {
     mxt_err(mxt->ctx, "Could not stat %s, error %s (%d)",
             filename, strerror(errno), errno);
@@ -662,6 +652,7 @@ int sysfs_get_msgs_v2(struct mxt_device *mxt, int *count)
   mxt->sysfs.debug_v2_msg_buf = calloc(mxt->sysfs.debug_v2_size, sizeof(uint8_t));
 
   fd = open(filename, O_RDWR);
+  mxt->stats.syscalls++;
   if (fd < 0) {
     mxt_err(mxt->ctx, "Could not open %s, error %s (%d)", filename, strerror(errno), errno);
     ret = mxt_errno_to_rc(errno);
@@ -671,12 +662,16 @@ int sysfs_get_msgs_v2(struct mxt_device *mxt, int *count)
   t5_size = mxt_get_object_size(mxt, GEN_MESSAGEPROCESSOR_T5) - 1;
 
   num_bytes = read(fd, mxt->sysfs.debug_v2_msg_buf, mxt->sysfs.debug_v2_size);
+  mxt->stats.syscalls++;
   if (num_bytes < 0) {
+    mxt_stats_errno(&mxt->stats, errno);
     mxt_err(mxt->ctx, "read error %s (%d)", strerror(errno), errno);
     ret = mxt_errno_to_rc(errno);
     goto close;
   }
 
+  mxt->stats.bytes_read += num_bytes;
+
   mxt->sysfs.debug_v2_msg_count = num_bytes / t5_size;
   mxt->sysfs.debug_v2_msg_ptr = 0;
 
@@ -686,6 +681,7 @@ int sysfs_get_msgs_v2(struct mxt_device *mxt, int *count)
 
 close:
   close(fd);
+  mxt->stats.syscalls++;
   return ret;
 }
 
@@ -743,3 +739,107 @@ int sysfs_get_i2c_address(struct libmaxtouch_ctx *ctx,
 
   return MXT_SUCCESS;
 }
+
+//******************************************************************************
+/// \brief  Check whether the driver provides an attribute
+bool sysfs_has_attr(struct mxt_device *mxt, const char *attr)
+{
+  struct stat filestat;
+
+  return stat(make_path(mxt, attr), &filestat) == 0;
+}
+
+//******************************************************************************
+/// \brief  Get path in the firmware directory the kernel loads files from
+/// \return #mxt_rc
+int sysfs_firmware_path(struct mxt_device *mxt, const char *name,
+                        char *buf, size_t buflen)
+{
+  int len;
+
+  len = snprintf(buf, buflen, "%s/%s", mxt->ctx->firmware_dir, name);
+  if (len < 0 || (size_t)len >= buflen)
+    return MXT_ERROR_NO_MEM;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief  Check whether the device answers with a valid ID again
+static bool sysfs_device_ready(struct mxt_device *mxt)
+{
+  unsigned char id[7];
+  ssize_t count;
+  int fd;
+
+  fd = open(mxt->sysfs.mem_access_path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  count = pread(fd, id, sizeof(id), 0);
+  close(fd);
+
+  return count == sizeof(id) && id[0] != 0x00 && id[0] != 0xFF;
+}
+
+//******************************************************************************
+/// \brief  Have the kernel driver apply a file staged in the firmware
+///         directory, and wait for the device to come back
+///
+/// Writing to the attribute returns once the driver has sent the file. The
+/// name is written as some drivers take the file to load from it, others
+/// ignore it and always load their default name.
+/// \param  attr  Attribute, eg update_fw or update_cfg
+/// \param  name  File name relative to the firmware directory
+/// \return #mxt_rc, MXT_ERROR_TIMEOUT if the driver took the file but the
+///         device did not come back
+int sysfs_update(struct mxt_device *mxt, const char *attr, const char *name)
+{
+  struct timespec start, now, wait = { 0, 100 * 1000 * 1000 };
+  char *filename;
+  ssize_t count;
+  long elapsed_ms;
+  int span;
+  int fd;
+  int ret;
+
+  filename = make_path(mxt, attr);
+
+  fd = open(filename, O_WRONLY);
+  if (fd < 0) {
+    mxt_warn(mxt->ctx, "Could not open %s, error %s (%d)",
+             filename, strerror(errno), errno);
+    return mxt_errno_to_rc(errno);
+  }
+
+  mxt_info(mxt->ctx, "Kernel driver loading %s through %s", name, attr);
+
+  span = mxt_trace_begin(mxt->ctx, "kernel update", MXT_TRACE_NO_ARG);
+  count = write(fd, name, strlen(name));
+  ret = (count < 0) ? errno : 0;
+  close(fd);
+  mxt_trace_end(mxt->ctx, span);
+
+  if (count != (ssize_t)strlen(name)) {
+    mxt_warn(mxt->ctx, "Kernel driver failed to load %s, error %s (%d)",
+             name, strerror(ret), ret);
+    return ret ? mxt_errno_to_rc(ret) : MXT_ERROR_IO;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (!sysfs_device_ready(mxt)) {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed_ms = (now.tv_sec - start.tv_sec) * 1000
+                 + (now.tv_nsec - start.tv_nsec) / 1000000;
+
+    if (elapsed_ms > SYSFS_UPDATE_TIMEOUT_MS) {
+      mxt_err(mxt->ctx, "Timeout waiting for device after update");
+      return MXT_ERROR_TIMEOUT;
+    }
+
+    nanosleep(&wait, NULL);
+  }
+
+  return MXT_SUCCESS;
+}
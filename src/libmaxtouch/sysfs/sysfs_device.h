@@ -30,6 +30,17 @@
 
 struct dmesg_item;
 
+/* Default locations, see libmaxtouch_ctx sysfs_root and firmware_dir */
+#define SYSFS_I2C_ROOT "/sys/bus/i2c/drivers"
+#define SYSFS_FIRMWARE_DIR "/lib/firmware"
+
+/* Names the kernel driver requests from the firmware directory */
+#define SYSFS_FW_NAME "maxtouch.fw"
+#define SYSFS_CFG_NAME "maxtouch.cfg"
+
+/* Time for the driver to bring the device back after an update */
+#define SYSFS_UPDATE_TIMEOUT_MS 10000
+
 //******************************************************************************
 /// \brief sysfs device connection information
 struct sysfs_conn_info {
@@ -73,9 +84,11 @@ int sysfs_set_debug(struct mxt_device *mxt, bool debug_state);
 int sysfs_get_debug(struct mxt_device *mxt, bool *value);
 char *sysfs_get_directory(struct mxt_device *mxt);
 bool sysfs_has_debug_v2(struct mxt_device *mxt);
-char *sysfs_get_msg_string_v2(struct mxt_device *mxt);
 int sysfs_get_msg_bytes_v2(struct mxt_device *mxt, unsigned char *buf, size_t buflen, int *count);
 int sysfs_get_msgs_v2(struct mxt_device *mxt, int *count);
 int sysfs_msg_reset_v2(struct mxt_device *mxt);
 int sysfs_get_debug_v2_fd(struct mxt_device *mxt);
+bool sysfs_has_attr(struct mxt_device *mxt, const char *attr);
+int sysfs_firmware_path(struct mxt_device *mxt, const char *name, char *buf, size_t buflen);
+int sysfs_update(struct mxt_device *mxt, const char *attr, const char *name);
 int sysfs_get_i2c_address(struct libmaxtouch_ctx *ctx, struct mxt_conn_info *conn, int *adapter, int *address);
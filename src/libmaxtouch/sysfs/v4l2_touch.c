@@ -0,0 +1,393 @@
+//------------------------------------------------------------------------------
+/// \file   v4l2_touch.c
+/// \brief  Diagnostic frame capture through a V4L2 touch device
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "v4l2_touch.h"
+
+//******************************************************************************
+/// \brief  Find the V4L2 touch device registered by the kernel driver
+///
+/// The driver creates the node as a child of the I2C client, so it appears
+/// in the video4linux directory of the sysfs device.
+/// \param  node  Returns device node path, eg /dev/v4l-touch0
+/// \return #mxt_rc
+int v4l2_touch_find(struct mxt_device *mxt, char *node, size_t len)
+{
+  char path[PATH_MAX];
+  struct dirent *ent;
+  DIR *dir;
+  int ret = MXT_ERROR_NO_DEVICE;
+
+  if (!mxt->conn || mxt->conn->type != E_SYSFS)
+    return MXT_ERROR_NOT_SUPPORTED;
+
+  snprintf(path, sizeof(path), "%s/video4linux", mxt->conn->sysfs.path);
+
+  dir = opendir(path);
+  if (!dir)
+    return MXT_ERROR_NO_DEVICE;
+
+  while ((ent = readdir(dir)) != NULL) {
+    if (strncmp(ent->d_name, "v4l-touch", 9))
+      continue;
+
+    snprintf(node, len, "/dev/%s", ent->d_name);
+    mxt_dbg(mxt->ctx, "Found V4L2 touch device %s", node);
+    ret = MXT_SUCCESS;
+    break;
+  }
+
+  closedir(dir);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Convert little endian row major frame into X major values
+void v4l2_touch_convert(const uint8_t *src, int width, int height,
+                        int bytesperline, int16_t *dst)
+{
+  const uint8_t *row;
+  int x;
+  int y;
+
+  for (y = 0; y < height; y++) {
+    row = src + y * bytesperline;
+
+    for (x = 0; x < width; x++)
+      dst[x * height + y] = (int16_t)((row[2*x + 1] << 8) | row[2*x]);
+  }
+}
+
+#ifdef V4L2_CAP_TOUCH
+
+/* Time to wait for the driver to deliver a frame */
+#define V4L2_TOUCH_TIMEOUT_MS 2000
+
+//******************************************************************************
+/// \brief Issue ioctl, restarting if interrupted by a signal
+static int v4l2_ioctl(int fd, unsigned long request, void *arg)
+{
+  int ret;
+
+  do {
+    ret = ioctl(fd, request, arg);
+  } while (ret == -1 && errno == EINTR);
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Open V4L2 touch device and start streaming frames for mode
+///
+/// Input 0 of the driver carries deltas and input 1 references. The layout
+/// is taken from the format reported by the driver, which is in touchscreen
+/// orientation rather than matrix orientation.
+/// \param  l  Returns frame layout
+/// \return #mxt_rc
+int v4l2_touch_open(struct mxt_device *mxt, const char *node, uint8_t mode,
+                    struct mxt_frame_layout *l)
+{
+  struct v4l2_touch *t = &mxt->frame.v4l2;
+  struct v4l2_capability cap;
+  struct v4l2_input input;
+  struct v4l2_format fmt;
+  struct v4l2_requestbuffers req;
+  struct v4l2_buffer buf;
+  enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  uint32_t caps;
+  int index;
+  unsigned int i;
+  int ret;
+
+  switch (mode) {
+  case DELTAS_MODE:
+    index = 0;
+    break;
+
+  case REFS_MODE:
+    index = 1;
+    break;
+
+  default:
+    return MXT_ERROR_NOT_SUPPORTED;
+  }
+
+  memset(t, 0, sizeof(*t));
+
+  t->fd = open(node, O_RDWR | O_CLOEXEC);
+  if (t->fd < 0) {
+    mxt_dbg(mxt->ctx, "Could not open %s, error %s (%d)",
+            node, strerror(errno), errno);
+    return mxt_errno_to_rc(errno);
+  }
+
+  t->open = true;
+
+  memset(&cap, 0, sizeof(cap));
+  if (v4l2_ioctl(t->fd, VIDIOC_QUERYCAP, &cap))
+    goto ioctl_error;
+
+  caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS)
+         ? cap.device_caps : cap.capabilities;
+
+  if (!(caps & V4L2_CAP_TOUCH) || !(caps & V4L2_CAP_VIDEO_CAPTURE)
+      || !(caps & V4L2_CAP_STREAMING)) {
+    mxt_dbg(mxt->ctx, "%s is not a touch capture device", node);
+    ret = MXT_ERROR_NOT_SUPPORTED;
+    goto close;
+  }
+
+  memset(&input, 0, sizeof(input));
+  input.index = index;
+  if (v4l2_ioctl(t->fd, VIDIOC_ENUMINPUT, &input)
+      || input.type != V4L2_INPUT_TYPE_TOUCH) {
+    mxt_dbg(mxt->ctx, "%s has no input for mode %02X", node, mode);
+    ret = MXT_ERROR_NOT_SUPPORTED;
+    goto close;
+  }
+
+  if (v4l2_ioctl(t->fd, VIDIOC_S_INPUT, &index))
+    goto ioctl_error;
+
+  memset(&fmt, 0, sizeof(fmt));
+  fmt.type = type;
+  if (v4l2_ioctl(t->fd, VIDIOC_G_FMT, &fmt))
+    goto ioctl_error;
+
+  if (fmt.fmt.pix.pixelformat != V4L2_TCH_FMT_DELTA_TD16
+      && fmt.fmt.pix.pixelformat != V4L2_TCH_FMT_TU16) {
+    mxt_dbg(mxt->ctx, "Unsupported pixel format %08X",
+            fmt.fmt.pix.pixelformat);
+    ret = MXT_ERROR_NOT_SUPPORTED;
+    goto close;
+  }
+
+  t->width = fmt.fmt.pix.width;
+  t->height = fmt.fmt.pix.height;
+  t->bytesperline = fmt.fmt.pix.bytesperline;
+  if (t->bytesperline < t->width * 2)
+    t->bytesperline = t->width * 2;
+
+  if (t->width <= 0 || t->height <= 0) {
+    mxt_dbg(mxt->ctx, "Bad frame size %dx%d", t->width, t->height);
+    ret = MXT_ERROR_UNEXPECTED_DEVICE_STATE;
+    goto close;
+  }
+
+  memset(&req, 0, sizeof(req));
+  req.count = V4L2_TOUCH_BUFFERS;
+  req.type = type;
+  req.memory = V4L2_MEMORY_MMAP;
+  if (v4l2_ioctl(t->fd, VIDIOC_REQBUFS, &req))
+    goto ioctl_error;
+
+  if (req.count == 0) {
+    mxt_dbg(mxt->ctx, "No buffers from %s", node);
+    ret = MXT_ERROR_NO_MEM;
+    goto close;
+  }
+
+  for (i = 0; i < req.count && i < V4L2_TOUCH_BUFFERS; i++) {
+    memset(&buf, 0, sizeof(buf));
+    buf.type = type;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = i;
+    if (v4l2_ioctl(t->fd, VIDIOC_QUERYBUF, &buf))
+      goto ioctl_error;
+
+    t->buf[i] = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     t->fd, buf.m.offset);
+    if (t->buf[i] == MAP_FAILED) {
+      t->buf[i] = NULL;
+      goto ioctl_error;
+    }
+
+    t->buf_len[i] = buf.length;
+    t->n_buffers++;
+
+    if (v4l2_ioctl(t->fd, VIDIOC_QBUF, &buf))
+      goto ioctl_error;
+  }
+
+  if (v4l2_ioctl(t->fd, VIDIOC_STREAMON, &type))
+    goto ioctl_error;
+
+  l->x_size = t->width;
+  l->y_size = t->height;
+  l->data_values = t->width * t->height;
+  l->passes = 1;
+  l->pages_per_pass = 0;
+  l->page_size = 0;
+  l->stripe_width = t->height;
+
+  mxt_info(mxt->ctx, "Capturing frames from %s, %s, X%dY%d",
+           node, input.name, t->width, t->height);
+
+  return MXT_SUCCESS;
+
+ioctl_error:
+  mxt_dbg(mxt->ctx, "V4L2 error on %s: %s (%d)", node, strerror(errno), errno);
+  ret = mxt_errno_to_rc(errno);
+close:
+  v4l2_touch_close(mxt);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Wait for the next frame from the driver and copy it into dst
+/// \return #mxt_rc
+int v4l2_touch_read(struct mxt_device *mxt, int16_t *dst)
+{
+  struct v4l2_touch *t = &mxt->frame.v4l2;
+  struct v4l2_buffer buf;
+  struct pollfd pfd;
+  size_t frame_len;
+  int span;
+  int ret;
+
+  pfd.fd = t->fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  span = mxt_trace_begin(mxt->ctx, "v4l2 frame", 0);
+
+  ret = poll(&pfd, 1, V4L2_TOUCH_TIMEOUT_MS);
+
+  if (ret == -1 && errno == EINTR) {
+    mxt_dbg(mxt->ctx, "Interrupted");
+    ret = MXT_ERROR_INTERRUPTED;
+    goto end;
+  } else if (ret == 0) {
+    mxt_err(mxt->ctx, "Timeout waiting for V4L2 frame");
+    ret = MXT_ERROR_TIMEOUT;
+    goto end;
+  } else if (ret < 0) {
+    mxt_err(mxt->ctx, "poll returned %s (%d)", strerror(errno), errno);
+    ret = mxt_errno_to_rc(errno);
+    goto end;
+  }
+
+  memset(&buf, 0, sizeof(buf));
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+  if (v4l2_ioctl(t->fd, VIDIOC_DQBUF, &buf)) {
+    mxt_err(mxt->ctx, "Failed to dequeue V4L2 buffer: %s (%d)",
+            strerror(errno), errno);
+    ret = mxt_errno_to_rc(errno);
+    goto end;
+  }
+
+  frame_len = (size_t)t->bytesperline * (t->height - 1) + t->width * 2;
+
+  if (buf.index >= t->n_buffers || t->buf_len[buf.index] < frame_len
+      || (buf.bytesused && buf.bytesused < frame_len)
+      || (buf.flags & V4L2_BUF_FLAG_ERROR)) {
+    mxt_err(mxt->ctx, "Bad V4L2 buffer %u", buf.index);
+    ret = MXT_ERROR_UNEXPECTED_DEVICE_STATE;
+  } else {
+    v4l2_touch_convert(t->buf[buf.index], t->width, t->height,
+                       t->bytesperline, dst);
+    ret = MXT_SUCCESS;
+  }
+
+  /* Hand the buffer back so the driver can fill it with the next frame */
+  if (buf.index < t->n_buffers && v4l2_ioctl(t->fd, VIDIOC_QBUF, &buf)) {
+    mxt_err(mxt->ctx, "Failed to queue V4L2 buffer: %s (%d)",
+            strerror(errno), errno);
+    if (ret == MXT_SUCCESS)
+      ret = mxt_errno_to_rc(errno);
+  }
+
+end:
+  mxt_trace_end(mxt->ctx, span);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Stop streaming and release buffers
+void v4l2_touch_close(struct mxt_device *mxt)
+{
+  struct v4l2_touch *t = &mxt->frame.v4l2;
+  enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  unsigned int i;
+
+  if (!t->open)
+    return;
+
+  v4l2_ioctl(t->fd, VIDIOC_STREAMOFF, &type);
+
+  for (i = 0; i < t->n_buffers; i++)
+    munmap(t->buf[i], t->buf_len[i]);
+
+  close(t->fd);
+  memset(t, 0, sizeof(*t));
+}
+
+#else
+
+//******************************************************************************
+/// \brief  V4L2 touch capture needs linux/videodev2.h from Linux 4.10 or later
+/// \return MXT_ERROR_NOT_SUPPORTED
+int v4l2_touch_open(struct mxt_device *mxt, const char *node, uint8_t mode,
+                    struct mxt_frame_layout *l)
+{
+  mxt_dbg(mxt->ctx, "V4L2 touch capture not built in");
+  return MXT_ERROR_NOT_SUPPORTED;
+}
+
+//******************************************************************************
+/// \brief  Not used, since v4l2_touch_open() always fails
+/// \return MXT_ERROR_NOT_SUPPORTED
+int v4l2_touch_read(struct mxt_device *mxt, int16_t *dst)
+{
+  return MXT_ERROR_NOT_SUPPORTED;
+}
+
+//******************************************************************************
+/// \brief Nothing to release
+void v4l2_touch_close(struct mxt_device *mxt)
+{
+}
+
+#endif /* V4L2_CAP_TOUCH */
@@ -0,0 +1,58 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   v4l2_touch.h
+/// \brief  Diagnostic frame capture through a V4L2 touch device
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Buffers requested from the driver for streaming */
+#define V4L2_TOUCH_BUFFERS 2
+
+struct mxt_device;
+struct mxt_frame_layout;
+
+//******************************************************************************
+/// \brief V4L2 touch capture state
+struct v4l2_touch {
+  bool open;
+  int fd;
+  int width;
+  int height;
+  int bytesperline;
+  unsigned int n_buffers;
+  void *buf[V4L2_TOUCH_BUFFERS];
+  size_t buf_len[V4L2_TOUCH_BUFFERS];
+};
+
+int v4l2_touch_find(struct mxt_device *mxt, char *node, size_t len);
+int v4l2_touch_open(struct mxt_device *mxt, const char *node, uint8_t mode, struct mxt_frame_layout *l);
+int v4l2_touch_read(struct mxt_device *mxt, int16_t *dst);
+void v4l2_touch_close(struct mxt_device *mxt);
+void v4l2_touch_convert(const uint8_t *src, int width, int height, int bytesperline, int16_t *dst);
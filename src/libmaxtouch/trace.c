@@ -0,0 +1,179 @@
+//------------------------------------------------------------------------------
+/// \file   trace.c
+/// \brief  Timeline trace of device operations
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "libmaxtouch.h"
+#include "trace.h"
+
+//******************************************************************************
+/// \brief Start recording spans into a buffer of size entries
+/// \return #mxt_rc
+int mxt_trace_start(struct libmaxtouch_ctx *ctx, int size)
+{
+  struct mxt_trace *trace;
+
+  if (ctx->trace)
+    return MXT_SUCCESS;
+
+  if (size <= 0)
+    return MXT_ERROR_BAD_INPUT;
+
+  trace = calloc(1, sizeof(*trace));
+  if (!trace)
+    return MXT_ERROR_NO_MEM;
+
+  trace->spans = calloc(size, sizeof(*trace->spans));
+  if (!trace->spans) {
+    free(trace);
+    return MXT_ERROR_NO_MEM;
+  }
+
+  trace->size = size;
+  ctx->trace = trace;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Stop tracing and free buffer
+void mxt_trace_stop(struct libmaxtouch_ctx *ctx)
+{
+  if (!ctx->trace)
+    return;
+
+  free(ctx->trace->spans);
+  free(ctx->trace);
+  ctx->trace = NULL;
+}
+
+//******************************************************************************
+/// \brief Record start of span
+/// \return span handle, or -1 if the buffer is full
+int mxt_trace_begin_span(struct libmaxtouch_ctx *ctx, const char *name,
+                         int arg)
+{
+  struct mxt_trace *trace = ctx->trace;
+  struct mxt_trace_span *span;
+  int index = __atomic_load_n(&trace->count, __ATOMIC_RELAXED);
+
+  /* Claim a slot, spans may be begun by several device threads */
+  do {
+    if (index == trace->size) {
+      __atomic_add_fetch(&trace->dropped, 1, __ATOMIC_RELAXED);
+      return -1;
+    }
+  } while (!__atomic_compare_exchange_n(&trace->count, &index, index + 1,
+                                        true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+
+  span = &trace->spans[index];
+  span->name = name;
+  span->arg = arg;
+  span->tid = syscall(SYS_gettid);
+  span->start_us = mxt_stats_now_us();
+  span->end_us = 0;
+
+  return index;
+}
+
+//******************************************************************************
+/// \brief Record end of span
+void mxt_trace_end_span(struct libmaxtouch_ctx *ctx, int span)
+{
+  if (!ctx->trace || span >= __atomic_load_n(&ctx->trace->count, __ATOMIC_RELAXED))
+    return;
+
+  ctx->trace->spans[span].end_us = mxt_stats_now_us();
+}
+
+//******************************************************************************
+/// \brief Write spans as Chrome trace event JSON
+///
+/// Spans still open, for example after an error return, end at the time of
+/// writing.
+/// \return #mxt_rc
+int mxt_trace_write(struct libmaxtouch_ctx *ctx, const char *filename)
+{
+  struct mxt_trace *trace = ctx->trace;
+  struct mxt_trace_span *span;
+  uint64_t now_us = mxt_stats_now_us();
+  uint64_t end_us;
+  int pid = getpid();
+  FILE *fp;
+  int i;
+
+  if (!trace)
+    return MXT_ERROR_NOT_SUPPORTED;
+
+  fp = fopen(filename, "w");
+  if (!fp) {
+    mxt_err(ctx, "Could not open %s, error %s (%d)",
+            filename, strerror(errno), errno);
+    return mxt_errno_to_rc(errno);
+  }
+
+  fprintf(fp, "{\"traceEvents\":[");
+
+  for (i = 0; i < trace->count; i++) {
+    span = &trace->spans[i];
+    end_us = span->end_us ? span->end_us : now_us;
+
+    fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+            "\"ts\":%" PRIu64 ",\"dur\":%" PRIu64,
+            i ? "," : "", span->name, pid, span->tid,
+            span->start_us, end_us - span->start_us);
+
+    if (span->arg != MXT_TRACE_NO_ARG)
+      fprintf(fp, ",\"args\":{\"n\":%d}", span->arg);
+
+    fprintf(fp, "}");
+  }
+
+  fprintf(fp, "\n],\"displayTimeUnit\":\"ms\","
+          "\"otherData\":{\"dropped\":%lu}}\n", trace->dropped);
+
+  if (fclose(fp)) {
+    mxt_err(ctx, "Error %s (%d) writing %s", strerror(errno), errno, filename);
+    return mxt_errno_to_rc(errno);
+  }
+
+  mxt_info(ctx, "Wrote %d trace spans to %s", trace->count, filename);
+  if (trace->dropped)
+    mxt_warn(ctx, "Trace buffer full, %lu spans dropped", trace->dropped);
+
+  return MXT_SUCCESS;
+}
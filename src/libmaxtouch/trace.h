@@ -0,0 +1,78 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   trace.h
+/// \brief  Timeline trace of device operations
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+
+/* Default number of spans preallocated by mxt_trace_start() */
+#define MXT_TRACE_DEFAULT_SPANS 65536
+
+/* Value of arg for spans without one */
+#define MXT_TRACE_NO_ARG -1
+
+struct libmaxtouch_ctx;
+
+//******************************************************************************
+/// \brief Recorded span, end_us is 0 until the span is ended
+struct mxt_trace_span {
+  const char *name;
+  int arg;
+  int tid;                      /*!< Thread that began the span */
+  uint64_t start_us;
+  uint64_t end_us;
+};
+
+//******************************************************************************
+/// \brief Trace buffer, filled in order of span start
+struct mxt_trace {
+  struct mxt_trace_span *spans;
+  int size;
+  int count;
+  unsigned long dropped;
+};
+
+int mxt_trace_start(struct libmaxtouch_ctx *ctx, int size);
+void mxt_trace_stop(struct libmaxtouch_ctx *ctx);
+int mxt_trace_write(struct libmaxtouch_ctx *ctx, const char *filename);
+int mxt_trace_begin_span(struct libmaxtouch_ctx *ctx, const char *name,
+                         int arg);
+void mxt_trace_end_span(struct libmaxtouch_ctx *ctx, int span);
+
+/* Begin a span, name must be a string literal. Returns a handle for
+ * mxt_trace_end(), or -1 when tracing is off or the buffer is full. Needs
+ * struct libmaxtouch_ctx from libmaxtouch.h */
+#define mxt_trace_begin(ctx, name, arg) \
+  (__builtin_expect((ctx)->trace != NULL, 0) \
+   ? mxt_trace_begin_span(ctx, name, arg) : -1)
+
+#define mxt_trace_end(ctx, span) \
+  do { \
+  if (__builtin_expect((span) >= 0, 0)) \
+    mxt_trace_end_span(ctx, span); \
+  } while (0)
@@ -153,6 +153,7 @@ static int usb_transfer(struct mxt_device *mxt, void *cmd, int cmd_size,
           mxt->usb.handle, ENDPOINT_2_OUT, cmd,
           cmd_size, &bytes_transferred, USB_TRANSFER_TIMEOUT
         );
+  mxt->stats.syscalls++;
 
   if (ret != LIBUSB_SUCCESS) {
     mxt_err(mxt->ctx, "USB command error %s", usb_error_name(ret));
@@ -180,6 +181,7 @@ static int usb_transfer(struct mxt_device *mxt, void *cmd, int cmd_size,
           mxt->usb.handle, ENDPOINT_1_IN, response,
           response_size, &bytes_transferred, USB_TRANSFER_TIMEOUT
         );
+  mxt->stats.syscalls++;
 
   if (ret != LIBUSB_SUCCESS) {
     mxt_err(mxt->ctx, "USB response error %s", usb_error_name(ret));
@@ -263,6 +265,9 @@ int usb_read_register(struct mxt_device *mxt, unsigned char *buf,
 
   /* Check the result in the response */
   if (pkt[response_ofs] != COMMS_STATUS_OK) {
+    if (pkt[response_ofs] == COMMS_STATUS_DATA_NACK)
+      mxt->stats.naks++;
+
     mxt_err
     (
       mxt->ctx,
@@ -346,6 +351,9 @@ static int write_data(struct mxt_device *mxt, unsigned char const *buf,
 
   /* Check the result in the response */
   if (!ignore_response && pkt[response_ofs] != COMMS_STATUS_WRITE_OK) {
+    if (pkt[response_ofs] == COMMS_STATUS_DATA_NACK)
+      mxt->stats.naks++;
+
     mxt_err
     (
       mxt->ctx,
@@ -657,6 +665,7 @@ retry:
   if (ret == LIBUSB_ERROR_NO_DEVICE) {
     usleep(500000);
     if (tries--) {
+      mxt->stats.retries++;
       mxt_warn(mxt->ctx, "%s opening USB device, retrying", usb_error_name(ret));
       goto retry;
     } else {
@@ -801,9 +810,9 @@ int usb_scan(struct libmaxtouch_ctx *ctx, struct mxt_conn_info **conn)
         mxt_verb(ctx, "Found VID=%04X PID=%04X %03d-%03d",
                  desc.idVendor, desc.idProduct, usb_bus, usb_device);
 
-        *conn = new_conn;
-        ret = MXT_SUCCESS;
-        goto free_device_list;
+        ret = mxt_scan_found(ctx, conn, new_conn);
+        if (ret != MXT_ERROR_NO_DEVICE)
+          goto free_device_list;
       }
     } else {
       mxt_verb(ctx, "Ignoring VID=%04X PID=%04X", desc.idVendor, desc.idProduct);
@@ -983,6 +992,7 @@ retry:
                    &bytes_written, true);
   if (ret == MXT_ERROR_NO_DEVICE && tries--) {
     usleep(500000);
+    mxt->stats.retries++;
     mxt_warn(mxt->ctx, "Error sending reset command, retrying");
     goto retry;
   } else if (ret) {
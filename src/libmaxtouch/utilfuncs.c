@@ -37,6 +37,7 @@
 #include <getopt.h>
 
 #include "libmaxtouch.h"
+#include "hex.h"
 #include "utilfuncs.h"
 
 #define BUF_SIZE 1024
@@ -240,73 +241,32 @@ int mxt_handle_write_cmd(struct mxt_device *mxt, const uint16_t type,
   return MXT_SUCCESS;
 }
 
-//******************************************************************************
-/// \brief Convert hex nibble to digit
-/// \return #mxt_rc
-static int to_digit(const char hex, char *const decimal)
-{
-  if (hex >= '0' && hex <= '9')
-    *decimal = hex - '0';
-  else if (hex >= 'A' && hex <= 'F')
-    *decimal = hex - 'A' + 10;
-  else if (hex >= 'a' && hex <= 'f')
-    *decimal = hex - 'a' + 10;
-  else {
-    *decimal = 0;
-    return MXT_ERROR_BAD_INPUT;
-  }
-
-  return MXT_SUCCESS;
-}
-
 //******************************************************************************
 /// \brief Convert ASCII buffer containing hex digits to binary
+///
+/// Conversion stops at the end of the string or at a newline.
 /// \return #mxt_rc
 int mxt_convert_hex(char *hex, unsigned char *databuf,
                     uint16_t *count, unsigned int buf_size)
 {
-  unsigned int pos = 0;
-  uint16_t datapos = 0;
-  char highnibble;
-  char lownibble;
-  char high_dec_nibble;
-  char low_dec_nibble;
-  int ret = MXT_SUCCESS;
-
-  while (1) {
-    highnibble = *(hex + pos);
-    lownibble = *(hex + pos + 1);
-
-    /* end of string */
-    if (highnibble == '\0' || highnibble == '\n')
-      break;
-
-    /* uneven number of hex digits */
-    if (lownibble == '\0' || lownibble == '\n') {
-      ret = MXT_ERROR_BAD_INPUT;
-      break;
-    }
+  size_t len = strcspn(hex, "\n");
+  int ret;
 
-    if (pos > buf_size) {
-      ret = MXT_ERROR_NO_MEM;
-      break;
-    }
+  *count = 0;
 
-    ret = to_digit(highnibble, &high_dec_nibble);
-    if (ret)
-      break;
+  /* uneven number of hex digits */
+  if (len % 2)
+    return MXT_ERROR_BAD_INPUT;
 
-    ret = to_digit(lownibble, &low_dec_nibble);
-    if (ret)
-      break;
+  if (len / 2 > buf_size)
+    return MXT_ERROR_NO_MEM;
 
-    *(databuf + datapos) = (high_dec_nibble << 4) | low_dec_nibble;
-    datapos++;
-    pos += 2;
-  }
+  ret = mxt_hex_decode(databuf, hex, len / 2);
+  if (ret)
+    return ret;
 
-  *count = datapos;
-  return ret;
+  *count = len / 2;
+  return MXT_SUCCESS;
 }
 
 //******************************************************************************
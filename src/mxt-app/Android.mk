@@ -14,6 +14,10 @@ LOCAL_SRC_FILES := \
   touch_app.c \
   self_test.c \
   bridge.c \
+  bridge_stats.c \
+  daemon.c \
+  script.c \
+  snapshot.c \
   buffer.c \
   gr.c \
   serial_data.c \
@@ -32,6 +32,8 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <ctype.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -39,6 +41,7 @@
 #include "libmaxtouch/info_block.h"
 #include "libmaxtouch/log.h"
 #include "libmaxtouch/sysfs/sysfs_device.h"
+#include "libmaxtouch/probe.h"
 
 #ifdef HAVE_LIBUSB
 #include "libmaxtouch/usb/usb_device.h"
@@ -88,6 +91,7 @@ struct flash_context {
 /// \return #mxt_rc
 static int wait_for_chg(struct mxt_device *mxt)
 {
+  int span = mxt_trace_begin(mxt->ctx, "chg wait", MXT_TRACE_NO_ARG);
 #ifdef HAVE_LIBUSB
   int try = 0;
   int ret;
@@ -117,9 +121,20 @@ static int wait_for_chg(struct mxt_device *mxt)
     usleep(MXT_BOOTLOADER_DELAY);
   }
 
+  mxt_trace_end(mxt->ctx, span);
   return MXT_SUCCESS;
 }
 
+//******************************************************************************
+/// \brief Wait for chip to come out of reset
+static void reset_sleep(struct flash_context *fw)
+{
+  int span = mxt_trace_begin(fw->ctx, "sleep", MXT_RESET_TIME * 1000);
+
+  sleep(MXT_RESET_TIME);
+  mxt_trace_end(fw->ctx, span);
+}
+
 //******************************************************************************
 /// \brief Send a frame with length field set to 0x0000. This should force a
 //         bootloader reset
@@ -276,6 +291,7 @@ static int send_frames(struct flash_context *fw)
   int frame;
   int frame_retry = 0;
   int bytes_sent = 0;
+  int span;
 
   fw->have_bootloader_version = false;
   fw->extended_id_mode = false;
@@ -336,6 +352,8 @@ static int send_frames(struct flash_context *fw)
       }
     }
 
+    span = mxt_trace_begin(fw->ctx, "bootloader frame", frame);
+
     if (mxt_check_bootloader(fw, MXT_WAITING_FRAME_DATA) < 0) {
       mxt_err(fw->ctx, "Unexpected bootloader state");
       return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
@@ -349,6 +367,8 @@ static int send_frames(struct flash_context *fw)
     // Check CRC
     mxt_verb(fw->ctx, "Checking CRC");
     ret = mxt_check_bootloader(fw, MXT_FRAME_CRC_PASS);
+    mxt_trace_end(fw->ctx, span);
+    MXT_PROBE3(bootloader__frame, frame, frame_size, ret);
     if (ret == MXT_ERROR_BOOTLOADER_FRAME_CRC_FAIL) {
       if (frame_retry > 0) {
         mxt_err(fw->ctx, "Failure sending frame %d - aborting", frame);
@@ -512,6 +532,189 @@ static int mxt_check_firmware_version(struct flash_context *fw)
   return MXT_SUCCESS;
 }
 
+//******************************************************************************
+/// \brief Read back firmware version after update and check it if required
+/// \return #mxt_rc
+static int mxt_verify_firmware_version(struct flash_context *fw)
+{
+  int ret;
+
+  ret = mxt_get_info(fw->mxt);
+  if (ret) {
+    mxt_err(fw->ctx, "Failed to get info block");
+    return ret;
+  }
+
+  mxt_get_firmware_version(fw->mxt, (char *)&fw->curr_version);
+
+  if (!fw->check_version) {
+    mxt_info(fw->ctx, "SUCCESS - version is %s", fw->curr_version);
+    return MXT_SUCCESS;
+  }
+
+  if (!strcmp(fw->curr_version, fw->new_version)) {
+    mxt_info(fw->ctx, "SUCCESS - version %s verified", fw->curr_version);
+    return MXT_SUCCESS;
+  }
+
+  mxt_err(fw->ctx, "FAILURE - detected version is %s", fw->curr_version);
+  return MXT_ERROR_FIRMWARE_UPDATE_FAILED;
+}
+
+//******************************************************************************
+/// \brief Write firmware to path in the binary format the kernel driver
+///        loads, decoding it if it is hex encoded like .enc files
+/// \return #mxt_rc
+static int stage_firmware(struct flash_context *fw, const char *path)
+{
+  char staged[PATH_MAX + 4];
+  FILE *out;
+  bool encoded;
+  int high = -1;
+  int c;
+  int ret = MXT_SUCCESS;
+
+  /* The driver must never see a partly written file */
+  snprintf(staged, sizeof(staged), "%s.new", path);
+
+  out = fopen(staged, "w");
+  if (!out) {
+    mxt_warn(fw->ctx, "Cannot open %s, error %s (%d)",
+             staged, strerror(errno), errno);
+    return mxt_errno_to_rc(errno);
+  }
+
+  rewind(fw->fp);
+  encoded = isxdigit(fgetc(fw->fp)) && isxdigit(fgetc(fw->fp));
+  rewind(fw->fp);
+
+  while ((c = fgetc(fw->fp)) != EOF) {
+    if (!encoded) {
+      fputc(c, out);
+      continue;
+    }
+
+    if (isspace(c))
+      continue;
+
+    if (!isxdigit(c)) {
+      mxt_err(fw->ctx, "Bad character in firmware file");
+      ret = MXT_ERROR_FILE_FORMAT;
+      goto close;
+    }
+
+    c = isdigit(c) ? c - '0' : tolower(c) - 'a' + 10;
+
+    if (high < 0) {
+      high = c;
+    } else {
+      fputc((high << 4) | c, out);
+      high = -1;
+    }
+  }
+
+  if (high >= 0) {
+    mxt_err(fw->ctx, "Odd number of digits in firmware file");
+    ret = MXT_ERROR_FILE_FORMAT;
+  }
+
+close:
+  if (fclose(out) && ret == MXT_SUCCESS) {
+    mxt_err(fw->ctx, "Error %s (%d) writing %s", strerror(errno), errno, staged);
+    ret = mxt_errno_to_rc(errno);
+  }
+
+  if (ret == MXT_SUCCESS && rename(staged, path)) {
+    mxt_warn(fw->ctx, "Could not stage %s, error %s (%d)",
+             path, strerror(errno), errno);
+    ret = mxt_errno_to_rc(errno);
+  }
+
+  if (ret)
+    unlink(staged);
+
+  rewind(fw->fp);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Flash firmware through the update_fw attribute of the kernel
+///        driver, rather than taking the device away from it
+///
+/// If the driver cannot be used, for example because it has no update_fw
+/// attribute, the firmware directory cannot be written or the driver rejects
+/// the file, nothing has been changed and the caller updates the device
+/// directly instead.
+/// \return #mxt_rc, MXT_ERROR_NOT_SUPPORTED if the driver cannot do this
+static int mxt_kernel_flash_firmware(struct flash_context *fw,
+                                     const char *new_version)
+{
+  char path[PATH_MAX];
+  int ret;
+
+  if (!fw->conn) {
+    ret = mxt_scan(fw->ctx, &fw->conn, false);
+    if (ret)
+      return MXT_ERROR_NOT_SUPPORTED;
+  }
+
+  if (fw->conn->type != E_SYSFS)
+    return MXT_ERROR_NOT_SUPPORTED;
+
+  ret = mxt_new_device(fw->ctx, fw->conn, &fw->mxt);
+  if (ret)
+    return MXT_ERROR_NOT_SUPPORTED;
+
+  if (!sysfs_has_attr(fw->mxt, "update_fw")) {
+    mxt_dbg(fw->ctx, "Driver has no update_fw attribute");
+    ret = MXT_ERROR_NOT_SUPPORTED;
+    goto free;
+  }
+
+  /* May be in bootloader mode already */
+  ret = mxt_get_info(fw->mxt);
+  if (ret)
+    goto fallback;
+
+  if (strlen(new_version) > 0) {
+    fw->check_version = true;
+    fw->new_version = new_version;
+    ret = mxt_check_firmware_version(fw);
+    if (ret)
+      goto free;
+  }
+
+  ret = sysfs_firmware_path(fw->mxt, SYSFS_FW_NAME, path, sizeof(path));
+  if (ret)
+    goto fallback;
+
+  ret = stage_firmware(fw, path);
+  if (ret == MXT_ERROR_FILE_FORMAT)
+    goto free;
+  else if (ret)
+    goto fallback;
+
+  mxt_info(fw->ctx, "Staged firmware at %s", path);
+
+  /* Only waiting for the device afterwards is past the point of return */
+  ret = sysfs_update(fw->mxt, "update_fw", SYSFS_FW_NAME);
+  if (ret == MXT_ERROR_TIMEOUT)
+    goto free;
+  else if (ret)
+    goto fallback;
+
+  ret = mxt_verify_firmware_version(fw);
+  goto free;
+
+fallback:
+  mxt_warn(fw->ctx, "Kernel driver cannot flash firmware, using bootloader");
+  ret = MXT_ERROR_NOT_SUPPORTED;
+free:
+  mxt_free_device(fw->mxt);
+  fw->mxt = NULL;
+  return ret;
+}
+
 //******************************************************************************
 /// \brief Reset into bootloader mode
 /// \return #mxt_rc
@@ -524,7 +727,7 @@ static int mxt_enter_bootloader_mode(struct flash_context *fw)
     mxt_err(fw->ctx, "Reset failure - aborting");
     return ret;
   } else {
-    sleep(MXT_RESET_TIME);
+    reset_sleep(fw);
   }
 
   if (fw->conn->type == E_I2C_DEV) {
@@ -548,13 +751,17 @@ static int mxt_enter_bootloader_mode(struct flash_context *fw)
 
 //******************************************************************************
 /// \brief  Flash firmware to chip
+///
+/// If the device is bound to a kernel driver which can update it, the driver
+/// does the update unless kernel_update is false.
 int mxt_flash_firmware(struct libmaxtouch_ctx *ctx,
                        struct mxt_device *maxtouch,
                        const char *filename, const char *new_version,
-                       struct mxt_conn_info *conn)
+                       struct mxt_conn_info *conn, bool kernel_update)
 {
   struct flash_context fw = { 0 };
   int ret;
+  int span;
 
   fw.ctx = ctx;
   fw.mxt = maxtouch;
@@ -571,6 +778,17 @@ int mxt_flash_firmware(struct libmaxtouch_ctx *ctx,
   fw.file_size = ftell(fw.fp);
   rewind(fw.fp);
 
+  if (kernel_update) {
+    ret = mxt_kernel_flash_firmware(&fw, new_version);
+    if (ret != MXT_ERROR_NOT_SUPPORTED) {
+      fclose(fw.fp);
+      mxt_unref_conn(fw.conn);
+      return ret;
+    }
+
+    fw.check_version = false;
+  }
+
   ret = mxt_bootloader_init_chip(&fw);
   if (ret && (ret != MXT_DEVICE_IN_BOOTLOADER))
     return ret;
@@ -588,7 +806,9 @@ int mxt_flash_firmware(struct libmaxtouch_ctx *ctx,
       mxt_dbg(fw.ctx, "check_version:%d", fw.check_version);
     }
 
+    span = mxt_trace_begin(fw.ctx, "enter bootloader", MXT_TRACE_NO_ARG);
     ret = mxt_enter_bootloader_mode(&fw);
+    mxt_trace_end(fw.ctx, span);
     if (ret) {
       mxt_err(fw.ctx, "Could not enter bootloader mode");
       goto release;
@@ -601,13 +821,15 @@ int mxt_flash_firmware(struct libmaxtouch_ctx *ctx,
     return ret;
   }
 
+  span = mxt_trace_begin(fw.ctx, "send frames", MXT_TRACE_NO_ARG);
   ret = send_frames(&fw);
+  mxt_trace_end(fw.ctx, span);
   if (ret)
     return ret;
 
   /* Handle transition back to appmode address */
   if (fw.mxt->conn->type == E_I2C_DEV) {
-    sleep(MXT_RESET_TIME);
+    reset_sleep(&fw);
 
     if (fw.appmode_address < 0) {
       mxt_info(fw.ctx, "Sent all firmware frames");
@@ -637,7 +859,7 @@ int mxt_flash_firmware(struct libmaxtouch_ctx *ctx,
       return ret;
 
     while (tries--) {
-      sleep(MXT_RESET_TIME);
+      reset_sleep(&fw);
 
       ret = usb_rediscover_device(fw.mxt, bus_devices);
       if (ret == MXT_SUCCESS)
@@ -667,28 +889,7 @@ int mxt_flash_firmware(struct libmaxtouch_ctx *ctx,
   }
 #endif
 
-  ret = mxt_get_info(fw.mxt);
-  if (ret) {
-    mxt_err(fw.ctx, "Failed to get info block");
-    goto release;
-  }
-
-  mxt_get_firmware_version(fw.mxt, (char *)&fw.curr_version);
-
-  if (!fw.check_version) {
-    mxt_info(fw.ctx, "SUCCESS - version is %s", fw.curr_version);
-    ret = MXT_SUCCESS;
-    goto release;
-  }
-
-
-  if (!strcmp(fw.curr_version, fw.new_version)) {
-    mxt_info(fw.ctx, "SUCCESS - version %s verified", fw.curr_version);
-    ret = MXT_SUCCESS;
-  } else {
-    mxt_err(fw.ctx, "FAILURE - detected version is %s", fw.curr_version);
-    ret = MXT_ERROR_FIRMWARE_UPDATE_FAILED;
-  }
+  ret = mxt_verify_firmware_version(&fw);
 
 release:
   mxt_free_device(fw.mxt);
@@ -702,6 +903,7 @@ int mxt_bootloader_version(struct libmaxtouch_ctx *ctx, struct mxt_device *mxt,
 {
   struct flash_context fw = {0};
   int ret;
+  int span;
   unsigned char buf[3];
 
   fw.ctx = ctx;
@@ -715,7 +917,9 @@ int mxt_bootloader_version(struct libmaxtouch_ctx *ctx, struct mxt_device *mxt,
   }
 
   if (ret != MXT_DEVICE_IN_BOOTLOADER) {
+    span = mxt_trace_begin(fw.ctx, "enter bootloader", MXT_TRACE_NO_ARG);
     ret = mxt_enter_bootloader_mode(&fw);
+    mxt_trace_end(fw.ctx, span);
     if (ret) {
       mxt_err(fw.ctx, "Could not enter bootloader mode");
       return ret;
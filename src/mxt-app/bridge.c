@@ -35,175 +35,1032 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <netdb.h>
 #include <inttypes.h>
-#include <poll.h>
+#include <time.h>
+#include <endian.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
 
 #include "libmaxtouch/libmaxtouch.h"
 #include "libmaxtouch/log.h"
 #include "libmaxtouch/utilfuncs.h"
+#include "libmaxtouch/hex.h"
+#include "libmaxtouch/probe.h"
 
 #include "mxt_app.h"
-#include "buffer.h"
+#include "bridge.h"
+#include "bridge_stats.h"
 
-#define MAX_LINESIZE 10000
+/* Maximum number of clients connected to the server at once */
+#define BRIDGE_MAX_CLIENTS       8
+
+/* Queued output above which requests are not read and pushes are dropped */
+#define BRIDGE_TX_HIGH_WATER     (256 * 1024)
+
+/* Queued output below which a paused client is read again */
+#define BRIDGE_TX_LOW_WATER      (64 * 1024)
+
+/* Queued output at which a client is disconnected */
+#define BRIDGE_TX_HARD_LIMIT     (4 * 1024 * 1024)
+
+/* Message poll interval if the device has no notification fd */
+#define BRIDGE_MSG_POLL_MS       25
+
+/* Most consecutive REA requests merged into one device read */
+#define BRIDGE_MERGE_MAX_READS   32
+
+/* Largest device read made by merging REA requests */
+#define BRIDGE_MERGE_MAX_BYTES   4096
+
+/* epoll data for fds which are not clients, clients use their slot index */
+#define BRIDGE_EV_LISTEN         BRIDGE_MAX_CLIENTS
+#define BRIDGE_EV_MSG            (BRIDGE_MAX_CLIENTS + 1)
+
+struct bridge_server;
 
 struct bridge_context {
   int sockfd;
   bool msgs_enabled;
+  struct bridge_msgq *latest;   /* Held messages in latest state mode */
+  bool binary;
+  bool pipelined;               /* Tagged requests, reads merged */
+  char tag[BRIDGE_TAG_MAX + 1]; /* Tag of request being answered */
+  struct bridge_rxbuf rx;
+  struct bridge_txbuf tx;
+  struct bridge_server *server;
+  struct bridge_context *next;  /* Request queue link */
+  int slot;
+  bool queued;
+  bool rx_paused;
+  bool rx_eof;
+  bool failed;
+  uint32_t events;
+  unsigned long msg_flushes;
+  unsigned long msg_total;
+  unsigned long msgs_dropped;
+  int msg_max_batch;
+  unsigned long reads_merged;
+  unsigned long merged_transfers;
+};
+
+//******************************************************************************
+/// \brief Register read requested by client
+struct bridge_read {
+  char tag[BRIDGE_TAG_MAX + 1];
+  uint16_t seq;
+  uint16_t address;
+  uint16_t count;
+};
+
+//******************************************************************************
+/// \brief Bridge server state
+///
+/// All device access happens from the one event loop. Requests from clients
+/// are taken one at a time from a single queue, so they are serialised
+/// without locking and no client can starve the others.
+struct bridge_server {
+  int epfd;
+  int listenfd;                 /* -1 when running as client */
+  int msg_fd;                   /* Registered message poll fd or -1 */
+  bool msg_watch_stale;         /* msg_fd must be registered again */
+  bool msg_timer;               /* Poll for messages on timer */
+  struct timespec msg_last;
+  int num_clients;
+  int num_subscribed;
+  struct bridge_context *clients[BRIDGE_MAX_CLIENTS];
+  struct bridge_context *queue_head;
+  struct bridge_context *queue_tail;
+  struct bridge_context *stream_client; /* Client receiving frames or NULL */
+  struct t37_ctx stream;
+  struct bridge_stats stats;
+  enum bridge_stat_cmd req_cmd; /* Command of request being handled */
+  uint64_t req_socket_us;       /* Time spent sending its reply */
 };
 
 
 //******************************************************************************
-/// \brief Read command on a single line
+/// \brief Initialise receive buffer for socket
 /// \return #mxt_rc
-static int readline(struct mxt_device *mxt, int fd, struct mxt_buffer *linebuf)
+int bridge_rx_init(struct bridge_rxbuf *rx, int fd)
 {
-  int ret;
-  int n;
-  int readcount;
-  char c;
+  rx->data = malloc(BRIDGE_RXBUF_SIZE);
+  if (!rx->data)
+    return MXT_ERROR_NO_MEM;
 
-  mxt_buf_reset(linebuf);
+  rx->fd = fd;
+  rx->start = 0;
+  rx->end = 0;
+  rx->discard = false;
 
-  for (n = 1; n < MAX_LINESIZE; n++) {
-    /* read 1 character at a time */
-    readcount = read(fd, &c, 1);
-    if (readcount == 1) {
-      if ((c == '\n') || (c == '\r'))
-        break;
+  return MXT_SUCCESS;
+}
 
-      ret = mxt_buf_add(linebuf, c);
-      if (ret)
-        return ret;
-    } else if (readcount == 0) {
-      if (n == 1)
-        return MXT_SUCCESS;
-      else
-        break;
+//******************************************************************************
+/// \brief Free receive buffer
+void bridge_rx_free(struct bridge_rxbuf *rx)
+{
+  free(rx->data);
+  rx->data = NULL;
+}
+
+//******************************************************************************
+/// \brief Receive as much data as will fit in the buffer with a single call
+/// \return #mxt_rc, MXT_ERROR_CONNECTION_FAILURE if peer closed socket
+int bridge_rx_fill(struct mxt_device *mxt, struct bridge_rxbuf *rx)
+{
+  ssize_t readcount;
+
+  /* Move unconsumed data to start of buffer */
+  if (rx->start == rx->end) {
+    rx->start = 0;
+    rx->end = 0;
+  } else if (rx->start > 0) {
+    memmove(rx->data, rx->data + rx->start, rx->end - rx->start);
+    rx->end -= rx->start;
+    rx->start = 0;
+  }
+
+  if (rx->end == BRIDGE_RXBUF_SIZE) {
+    mxt_err(mxt->ctx, "Receive buffer full");
+    return MXT_ERROR_PROTOCOL_FAULT;
+  }
+
+  readcount = recv(rx->fd, rx->data + rx->end, BRIDGE_RXBUF_SIZE - rx->end, 0);
+  if (readcount == 0) {
+    mxt_dbg(mxt->ctx, "Peer closed socket");
+    return MXT_ERROR_CONNECTION_FAILURE;
+  } else if (readcount < 0) {
+    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+      return MXT_SUCCESS;
+
+    mxt_err(mxt->ctx, "Read error: %s (%d)", strerror(errno), errno);
+    return mxt_errno_to_rc(errno);
+  }
+
+  rx->end += readcount;
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Extract next complete line from receive buffer
+///
+/// The line is null terminated in place and is valid until the next call to
+/// bridge_rx_fill(). A null byte also ends a line, so a line which has been
+/// read can be read again by restoring the start offset. A line longer than
+/// BRIDGE_MAX_LINESIZE is reported once and the remainder discarded up to the
+/// next terminator.
+/// \return #mxt_rc, MXT_ERROR_NO_MESSAGE if no complete line is buffered,
+/// MXT_ERROR_PROTOCOL_FAULT if line too long
+int bridge_rx_getline(struct mxt_device *mxt, struct bridge_rxbuf *rx,
+                      char **line)
+{
+  uint8_t *start = rx->data + rx->start;
+  size_t avail = rx->end - rx->start;
+  size_t i;
+
+  for (i = 0; i < avail; i++) {
+    if (start[i] == '\n' || start[i] == '\r' || start[i] == '\0')
+      break;
+  }
+
+  if (rx->discard) {
+    if (i == avail) {
+      rx->start = rx->end;
+      return MXT_ERROR_NO_MESSAGE;
+    }
+
+    /* Resume at the line after the over-long one */
+    rx->discard = false;
+    rx->start += i + 1;
+    return bridge_rx_getline(mxt, rx, line);
+  }
+
+  if (i > BRIDGE_MAX_LINESIZE || (i == avail && avail > BRIDGE_MAX_LINESIZE)) {
+    mxt_warn(mxt->ctx, "Line exceeds %d bytes, discarding",
+             BRIDGE_MAX_LINESIZE);
+
+    if (i == avail) {
+      rx->discard = true;
+      rx->start = rx->end;
     } else {
-      mxt_err(mxt->ctx, "Read error: %s (%d)", strerror(errno), errno);
-      return mxt_errno_to_rc(errno);
+      rx->start += i + 1;
     }
+
+    return MXT_ERROR_PROTOCOL_FAULT;
   }
 
-  /* null-terminate the buffer */
-  ret = mxt_buf_add(linebuf, '\0');
-  if (ret)
+  if (i == avail)
+    return MXT_ERROR_NO_MESSAGE;
+
+  start[i] = '\0';
+  *line = (char *)start;
+  rx->start += i + 1;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Extract next complete binary frame from receive buffer
+///
+/// Header fields are returned in host byte order. The payload points into the
+/// receive buffer and is valid until the next call to bridge_rx_fill().
+/// \return #mxt_rc, MXT_ERROR_NO_MESSAGE if no complete frame is buffered
+int bridge_rx_getframe(struct mxt_device *mxt, struct bridge_rxbuf *rx,
+                       struct bridge_frame_hdr *hdr, uint8_t **payload)
+{
+  size_t avail = rx->end - rx->start;
+  uint16_t length;
+
+  if (avail < BRIDGE_FRAME_HDR_LEN)
+    return MXT_ERROR_NO_MESSAGE;
+
+  memcpy(hdr, rx->data + rx->start, BRIDGE_FRAME_HDR_LEN);
+  length = le16toh(hdr->length);
+
+  if (avail < BRIDGE_FRAME_HDR_LEN + length)
+    return MXT_ERROR_NO_MESSAGE;
+
+  hdr->length = length;
+  hdr->seq = le16toh(hdr->seq);
+  hdr->address = le16toh(hdr->address);
+  hdr->count = le16toh(hdr->count);
+
+  *payload = rx->data + rx->start + BRIDGE_FRAME_HDR_LEN;
+  rx->start += BRIDGE_FRAME_HDR_LEN + length;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Initialise transmit buffer for socket
+void bridge_tx_init(struct bridge_txbuf *tx, int fd)
+{
+  tx->fd = fd;
+  tx->data = NULL;
+  tx->start = 0;
+  tx->end = 0;
+  tx->capacity = 0;
+}
+
+//******************************************************************************
+/// \brief Free transmit buffer
+void bridge_tx_free(struct bridge_txbuf *tx)
+{
+  free(tx->data);
+  tx->data = NULL;
+  tx->start = 0;
+  tx->end = 0;
+  tx->capacity = 0;
+}
+
+//******************************************************************************
+/// \brief Number of bytes queued and not yet sent
+size_t bridge_tx_pending(const struct bridge_txbuf *tx)
+{
+  return tx->end - tx->start;
+}
+
+//******************************************************************************
+/// \brief Send data, queueing whatever the socket does not accept
+///
+/// Data is only sent directly if nothing is already queued, so output is
+/// never reordered. Never blocks.
+/// \return #mxt_rc
+int bridge_tx_writev(struct mxt_device *mxt, struct bridge_txbuf *tx,
+                     const struct iovec *iov, int iovcnt)
+{
+  struct msghdr msg;
+  size_t total = 0;
+  size_t sent = 0;
+  size_t needed;
+  size_t offset;
+  ssize_t ret;
+  uint8_t *newdata;
+  int i;
+
+  for (i = 0; i < iovcnt; i++)
+    total += iov[i].iov_len;
+
+  if (bridge_tx_pending(tx) == 0) {
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (struct iovec *)iov;
+    msg.msg_iovlen = iovcnt;
+
+    ret = sendmsg(tx->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (ret >= 0) {
+      sent = ret;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
+      return MXT_ERROR_CONNECTION_FAILURE;
+    }
+
+    if (sent == total)
+      return MXT_SUCCESS;
+  }
+
+  /* Make room for the remainder */
+  needed = bridge_tx_pending(tx) + total - sent;
+  if (tx->start > 0) {
+    memmove(tx->data, tx->data + tx->start, tx->end - tx->start);
+    tx->end -= tx->start;
+    tx->start = 0;
+  }
+
+  if (needed > tx->capacity) {
+    size_t capacity = tx->capacity ? tx->capacity : 4096;
+
+    while (capacity < needed)
+      capacity *= 2;
+
+    newdata = realloc(tx->data, capacity);
+    if (!newdata) {
+      mxt_err(mxt->ctx, "Failed to allocate memory");
+      return MXT_ERROR_NO_MEM;
+    }
+
+    tx->data = newdata;
+    tx->capacity = capacity;
+  }
+
+  for (i = 0; i < iovcnt; i++) {
+    if (sent >= iov[i].iov_len) {
+      sent -= iov[i].iov_len;
+      continue;
+    }
+
+    offset = sent;
+    memcpy(tx->data + tx->end, (uint8_t *)iov[i].iov_base + offset,
+           iov[i].iov_len - offset);
+    tx->end += iov[i].iov_len - offset;
+    sent = 0;
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Send as much queued data as the socket accepts without blocking
+/// \return #mxt_rc
+int bridge_tx_flush(struct mxt_device *mxt, struct bridge_txbuf *tx)
+{
+  ssize_t ret;
+
+  while (bridge_tx_pending(tx) > 0) {
+    ret = send(tx->fd, tx->data + tx->start, bridge_tx_pending(tx),
+               MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      else if (errno == EINTR)
+        continue;
+
+      mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
+      return MXT_ERROR_CONNECTION_FAILURE;
+    }
+
+    tx->start += ret;
+  }
+
+  if (tx->start == tx->end) {
+    tx->start = 0;
+    tx->end = 0;
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Empty message queue, keeping its counters
+void bridge_msgq_clear(struct bridge_msgq *q)
+{
+  q->length = 0;
+  q->count = 0;
+}
+
+//******************************************************************************
+/// \brief Add message to queue, replacing an older position update
+/// \return #mxt_rc, MXT_ERROR_NO_MEM if the queue is full
+int bridge_msgq_add(struct bridge_msgq *q, const uint8_t *msg, uint8_t len,
+                    bool position)
+{
+  uint8_t *old;
+  int i;
+
+  if (len == 0 || len > BRIDGE_MSG_MAX)
+    return MXT_ERROR_BAD_INPUT;
+
+  /* Only the last message with the same report ID may be replaced, so
+   * press and release events keep their place between position updates */
+  for (i = q->count - 1; position && i >= 0; i--) {
+    old = q->data + q->offset[i];
+    if (old[1] != msg[0])
+      continue;
+
+    if (q->position[i] && old[0] == len) {
+      memcpy(old + 1, msg, len);
+      q->merged++;
+      return MXT_SUCCESS;
+    }
+
+    break;
+  }
+
+  if (q->count == BRIDGE_MSGQ_MAX_MSGS)
+    return MXT_ERROR_NO_MEM;
+
+  q->offset[q->count] = q->length;
+  q->position[q->count] = position;
+  q->data[q->length] = len;
+  memcpy(q->data + q->length + 1, msg, len);
+  q->length += len + 1;
+  q->count++;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Send to client, applying output limits
+/// \return #mxt_rc
+static int bridge_writev(struct mxt_device *mxt,
+                         struct bridge_context *bridge_ctx,
+                         const struct iovec *iov, int iovcnt)
+{
+  struct bridge_server *server = bridge_ctx->server;
+  uint64_t start_us;
+  size_t pending;
+  int ret;
+  int i;
+
+  if (bridge_ctx->failed)
+    return MXT_ERROR_CONNECTION_FAILURE;
+
+  for (i = 0; i < iovcnt; i++)
+    server->stats.bytes_out += iov[i].iov_len;
+
+  start_us = mxt_stats_now_us();
+  ret = bridge_tx_writev(mxt, &bridge_ctx->tx, iov, iovcnt);
+  server->req_socket_us += mxt_stats_now_us() - start_us;
+  if (ret) {
+    bridge_ctx->failed = true;
     return ret;
+  }
+
+  pending = bridge_tx_pending(&bridge_ctx->tx);
+  if (pending > BRIDGE_TX_HARD_LIMIT) {
+    mxt_warn(mxt->ctx, "Client %d has %zu bytes unsent, disconnecting",
+             bridge_ctx->slot, pending);
+    bridge_ctx->failed = true;
+    return MXT_ERROR_CONNECTION_FAILURE;
+  } else if (pending > BRIDGE_TX_HIGH_WATER && !bridge_ctx->rx_paused) {
+    mxt_dbg(mxt->ctx, "Client %d not reading, pausing its requests",
+            bridge_ctx->slot);
+    bridge_ctx->rx_paused = true;
+  }
 
   return MXT_SUCCESS;
 }
 
+//******************************************************************************
+/// \brief Send buffer to client
+/// \return #mxt_rc
+static int bridge_write(struct mxt_device *mxt,
+                        struct bridge_context *bridge_ctx,
+                        const void *buf, size_t count)
+{
+  struct iovec iov;
+
+  iov.iov_base = (void *)buf;
+  iov.iov_len = count;
+
+  return bridge_writev(mxt, bridge_ctx, &iov, 1);
+}
+
+//******************************************************************************
+/// \brief Send reply to client, prefixed by tag of current request if any
+/// \return #mxt_rc
+static int bridge_reply(struct mxt_device *mxt,
+                        struct bridge_context *bridge_ctx,
+                        const void *buf, size_t count)
+{
+  char prefix[BRIDGE_TAG_MAX + 3];
+  struct iovec iov[2];
+
+  if (bridge_ctx->tag[0] == '\0')
+    return bridge_write(mxt, bridge_ctx, buf, count);
+
+  iov[0].iov_base = prefix;
+  iov[0].iov_len = snprintf(prefix, sizeof(prefix), "#%s ", bridge_ctx->tag);
+  iov[1].iov_base = (void *)buf;
+  iov[1].iov_len = count;
+
+  return bridge_writev(mxt, bridge_ctx, iov, 2);
+}
+
+//******************************************************************************
+/// \brief Send binary frame with optional payload
+/// \return #mxt_rc
+static int bridge_send_frame(struct mxt_device *mxt,
+                             struct bridge_context *bridge_ctx,
+                             uint8_t opcode, uint8_t status, uint16_t seq,
+                             uint16_t address, uint16_t count,
+                             const void *payload, size_t length)
+{
+  struct bridge_frame_hdr hdr;
+  struct iovec iov[2];
+  int iovcnt = 1;
+
+  if (length > BRIDGE_FRAME_MAX_PAYLOAD)
+    return MXT_INTERNAL_ERROR;
+
+  hdr.length = htole16(length);
+  hdr.opcode = opcode;
+  hdr.status = status;
+  hdr.seq = htole16(seq);
+  hdr.address = htole16(address);
+  hdr.count = htole16(count);
+
+  iov[0].iov_base = &hdr;
+  iov[0].iov_len = BRIDGE_FRAME_HDR_LEN;
+
+  if (length > 0) {
+    iov[1].iov_base = (void *)payload;
+    iov[1].iov_len = length;
+    iovcnt = 2;
+  }
+
+  return bridge_writev(mxt, bridge_ctx, iov, iovcnt);
+}
+
 #define MXT_ADB_CLIENT_MSG_PREFIX "MSG "
 
+/* Longest ASCII line for one message */
+#define BRIDGE_MSG_LINE_MAX (sizeof(MXT_ADB_CLIENT_MSG_PREFIX) + BRIDGE_MSG_MAX * 2)
+
+/* T9 status bits */
+#define BRIDGE_T9_DETECT   0x80
+#define BRIDGE_T9_PRESS    0x40
+#define BRIDGE_T9_RELEASE  0x20
+#define BRIDGE_T9_SUPPRESS 0x02
+#define BRIDGE_T9_UNGRIP   0x01
+
+/* T100 touch status, event in the low nibble */
+#define BRIDGE_T100_DETECT 0x80
+#define BRIDGE_T100_EVENT  0x0F
+#define BRIDGE_T100_NONE   0x00
+#define BRIDGE_T100_MOVE   0x01
+
+//******************************************************************************
+/// \brief Record number of messages sent in one flush
+static void bridge_count_flush(struct mxt_device *mxt,
+                               struct bridge_context *bridge_ctx,
+                               int num_msgs)
+{
+  bridge_ctx->msg_flushes++;
+  bridge_ctx->msg_total += num_msgs;
+  bridge_ctx->server->stats.msgs_pushed += num_msgs;
+
+  if (num_msgs > bridge_ctx->msg_max_batch)
+    bridge_ctx->msg_max_batch = num_msgs;
+
+  mxt_verb(mxt->ctx, "Sent %d messages to client %d in one write",
+           num_msgs, bridge_ctx->slot);
+}
+
+//******************************************************************************
+/// \brief Format batch of messages as ASCII lines
+/// \return Length of output
+static size_t bridge_format_messages(const uint8_t *batch, size_t batch_len,
+                                     char *out)
+{
+  const size_t prefix_len = strlen(MXT_ADB_CLIENT_MSG_PREFIX);
+  size_t length = 0;
+  size_t pos = 0;
+  int num_bytes;
+
+  while (pos < batch_len) {
+    num_bytes = batch[pos++];
+
+    memcpy(out + length, MXT_ADB_CLIENT_MSG_PREFIX, prefix_len);
+    length += prefix_len;
+
+    length = mxt_hex_encode(out + length, batch + pos, num_bytes) - out;
+
+    out[length++] = '\n';
+    pos += num_bytes;
+  }
+
+  return length;
+}
+
+//******************************************************************************
+/// \brief Check whether message only updates the position of a touch
+///
+/// Press, release and suppression events, and the screen status reports of
+/// T100, are never treated as position updates.
+static bool bridge_msg_is_position(struct mxt_device *mxt,
+                                   const uint8_t *msg, int len)
+{
+  const struct mxt_report_id_map *map;
+  int report_id;
+  uint8_t status;
+
+  if (len < 2)
+    return false;
+
+  report_id = msg[0];
+  status = msg[1];
+
+  if (report_id == 0 || report_id >= mxt->info.max_report_id)
+    return false;
+
+  map = &mxt->report_id_map[report_id];
+
+  switch (map->object_type) {
+  case TOUCH_MULTITOUCHSCREEN_T9:
+    return (status & (BRIDGE_T9_DETECT | BRIDGE_T9_PRESS | BRIDGE_T9_RELEASE
+                      | BRIDGE_T9_SUPPRESS | BRIDGE_T9_UNGRIP))
+           == BRIDGE_T9_DETECT;
+
+  case TOUCH_MULTITOUCHSCREEN_T100:
+    /* The first two report IDs of each instance carry screen status */
+    if (report_id < 3
+        || map[-2].object_type != map->object_type
+        || map[-2].instance != map->instance)
+      return false;
+
+    return (status & BRIDGE_T100_DETECT)
+           && ((status & BRIDGE_T100_EVENT) == BRIDGE_T100_MOVE
+               || (status & BRIDGE_T100_EVENT) == BRIDGE_T100_NONE);
+
+  default:
+    return false;
+  }
+}
+
 //******************************************************************************
-/// \brief Read MXT messages and send them to other end
+/// \brief Send batch of messages to client in one write
+///
+/// ascii holds the batch formatted by bridge_format_messages() for clients
+/// using the ASCII protocol.
 /// \return #mxt_rc
-static int handle_messages(struct mxt_device *mxt, struct bridge_context *bridge_ctx)
+static int bridge_send_msgs(struct mxt_device *mxt,
+                            struct bridge_context *client,
+                            const uint8_t *batch, size_t length,
+                            uint16_t num_msgs,
+                            const char *ascii, size_t ascii_len)
 {
-  int msg_count, length;
   int ret;
-  int i, j;
 
-  unsigned char databuf[20];
+  if (client->binary)
+    ret = bridge_send_frame(mxt, client, BRIDGE_OP_MSG, BRIDGE_STATUS_OK,
+                            0, 0, num_msgs, batch, length);
+  else
+    ret = bridge_write(mxt, client, ascii, ascii_len);
+
+  if (ret == MXT_SUCCESS)
+    bridge_count_flush(mxt, client, num_msgs);
 
-  if (!bridge_ctx->msgs_enabled)
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Queue batch for client in latest state mode
+static void bridge_hold_msgs(struct mxt_device *mxt,
+                             struct bridge_context *client,
+                             const uint8_t *batch, size_t length)
+{
+  struct bridge_msgq *q = client->latest;
+  unsigned long merged = q->merged;
+  size_t pos = 0;
+  int num_bytes;
+
+  while (pos < length) {
+    num_bytes = batch[pos++];
+
+    if (bridge_msgq_add(q, batch + pos, num_bytes,
+                        bridge_msg_is_position(mxt, batch + pos, num_bytes)))
+      client->msgs_dropped++;
+
+    pos += num_bytes;
+  }
+
+  client->server->stats.msgs_merged += q->merged - merged;
+}
+
+//******************************************************************************
+/// \brief Send held messages once earlier output to client has drained
+static void bridge_flush_latest(struct mxt_device *mxt,
+                                struct bridge_context *client)
+{
+  struct bridge_msgq *q = client->latest;
+  char *ascii = NULL;
+  size_t ascii_len = 0;
+
+  if (!q || q->count == 0 || bridge_tx_pending(&client->tx) > 0)
+    return;
+
+  if (!client->binary) {
+    ascii = malloc(q->count * BRIDGE_MSG_LINE_MAX);
+    if (!ascii) {
+      mxt_err(mxt->ctx, "Failed to allocate memory");
+      return;
+    }
+
+    ascii_len = bridge_format_messages(q->data, q->length, ascii);
+  }
+
+  bridge_send_msgs(mxt, client, q->data, q->length, q->count,
+                   ascii, ascii_len);
+  bridge_msgq_clear(q);
+  free(ascii);
+}
+
+//******************************************************************************
+/// \brief Read MXT messages and send them to all subscribed clients
+///
+/// All messages pending at this point are drained from the device once and
+/// sent to each client in a single write, as one binary frame or as ASCII
+/// lines in one buffer. A burst of touch messages therefore does not cost a
+/// TCP segment per message. Clients which are not keeping up miss the batch,
+/// except in latest state mode where messages are held until they catch up.
+/// \return #mxt_rc
+static int bridge_handle_messages(struct mxt_device *mxt,
+                                  struct bridge_server *server)
+{
+  struct bridge_context *client;
+  uint8_t *batch;
+  char *ascii = NULL;
+  size_t length = 0;
+  size_t ascii_len = 0;
+  uint16_t num_msgs = 0;
+  int msg_count;
+  int num_bytes;
+  int ret;
+  int i;
+
+  if (server->num_subscribed == 0)
     return MXT_SUCCESS;
 
   ret = mxt_get_msg_count(mxt, &msg_count);
+  server->msg_watch_stale = true;
   if (ret)
     return ret;
 
+  if (msg_count <= 0)
+    return MXT_SUCCESS;
+
+  batch = malloc(msg_count * (BRIDGE_MSG_MAX + 1));
+  if (!batch) {
+    mxt_err(mxt->ctx, "Failed to allocate memory");
+    return MXT_ERROR_NO_MEM;
+  }
+
+  /* Each message is preceded by its length, as in BRIDGE_OP_MSG */
   for (i = 0; i < msg_count; i++) {
-    int num_bytes;
-    ret = mxt_get_msg_bytes(mxt, databuf, sizeof(databuf), &num_bytes);
+    ret = mxt_get_msg_bytes(mxt, batch + length + 1, BRIDGE_MSG_MAX,
+                            &num_bytes);
     if (ret == MXT_ERROR_NO_MESSAGE)
       continue;
     else if (ret)
-      return ret;
+      goto free;
 
-    length = snprintf(mxt->msg_string, sizeof(mxt->msg_string),
-                      MXT_ADB_CLIENT_MSG_PREFIX);
+    batch[length] = num_bytes;
+    length += num_bytes + 1;
+    num_msgs++;
+  }
 
-    for (j = 0; j < num_bytes; j++) {
-      length += snprintf(mxt->msg_string + length,
-                         sizeof(mxt->msg_string) - length,
-                         "%02X", databuf[j]);
+  ret = MXT_SUCCESS;
+
+  if (num_msgs == 0)
+    goto free;
+
+  for (i = 0; i < BRIDGE_MAX_CLIENTS; i++) {
+    client = server->clients[i];
+    if (!client || !client->msgs_enabled || client->failed)
+      continue;
+
+    if (client->latest) {
+      bridge_hold_msgs(mxt, client, batch, length);
+      continue;
     }
 
-    ret = write(bridge_ctx->sockfd, mxt->msg_string, strlen(mxt->msg_string));
-    if (ret < 0) {
-      mxt_err(mxt->ctx, "Write failure: %s (%d)", strerror(errno), errno);
-      return mxt_errno_to_rc(ret);
+    if (bridge_tx_pending(&client->tx) > BRIDGE_TX_HIGH_WATER) {
+      client->msgs_dropped += num_msgs;
+      continue;
     }
 
-    ret = write(bridge_ctx->sockfd, "\n", 1);
-    if (ret < 0) {
-      mxt_err(mxt->ctx, "Write failure: %s (%d)", strerror(errno), errno);
-      return mxt_errno_to_rc(ret);
+    if (!client->binary && !ascii) {
+      ascii = malloc(num_msgs * BRIDGE_MSG_LINE_MAX);
+      if (!ascii) {
+        mxt_err(mxt->ctx, "Failed to allocate memory");
+        ret = MXT_ERROR_NO_MEM;
+        goto free;
+      }
+
+      ascii_len = bridge_format_messages(batch, length, ascii);
     }
+
+    bridge_send_msgs(mxt, client, batch, length, num_msgs, ascii, ascii_len);
   }
 
-  return MXT_SUCCESS;
+free:
+  free(ascii);
+  free(batch);
+  return ret;
 }
 
 //******************************************************************************
-/// \brief Handle bridge read
+/// \brief Send ASCII reply to bridge read, databuf NULL if the read failed
 /// \return #mxt_rc
-static int bridge_rea_cmd(struct mxt_device *mxt, struct bridge_context *bridge_ctx,
-                          uint16_t address, uint16_t count)
+static int bridge_rea_reply(struct mxt_device *mxt,
+                            struct bridge_context *bridge_ctx,
+                            const uint8_t *databuf, uint16_t count)
 {
   int ret;
-  uint8_t *databuf;
   char *response;
   const char * const PREFIX = "RRP ";
   size_t response_len;
-  int i;
-
-  databuf = calloc(count, sizeof(uint8_t));
-  if (!databuf) {
-    mxt_err(mxt->ctx, "Failed to allocate memory");
-    return MXT_ERROR_NO_MEM;
-  }
 
   /* Allow for newline/null byte */
   response_len = strlen(PREFIX) + count*2 + 1;
   response = calloc(response_len, sizeof(uint8_t));
   if (!response) {
     mxt_err(mxt->ctx, "Failed to allocate memory");
-    ret = MXT_ERROR_NO_MEM;
-    goto free_databuf;
+    return MXT_ERROR_NO_MEM;
   }
 
   strcpy(response, PREFIX);
-  ret = mxt_read_register(mxt, databuf, address, count);
-  if (ret) {
+  if (!databuf) {
     mxt_warn(mxt->ctx, "RRP ERR");
     strcpy(response + strlen(PREFIX), "ERR\n");
     response_len = strlen(response);
   } else {
-    for (i = 0; i < count; i++) {
-      sprintf(response + strlen(PREFIX) + i*2, "%02X", databuf[i]);
-    }
+    *mxt_hex_encode(response + strlen(PREFIX), databuf, count) = '\0';
     mxt_info(mxt->ctx, "%s", response);
     response[response_len - 1] = '\n';
   }
 
-  ret = write(bridge_ctx->sockfd, response, response_len);
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-    ret = mxt_errno_to_rc(errno);
-    goto free;
+  ret = bridge_reply(mxt, bridge_ctx, response, response_len);
+
+  free(response);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Remove "#tag " prefix from pipelined request
+/// \return #mxt_rc, MXT_ERROR_PROTOCOL_FAULT if tag is malformed
+static int bridge_split_tag(char **line, char *tag)
+{
+  char *start = *line;
+  size_t len;
+
+  tag[0] = '\0';
+
+  if (start[0] != '#')
+    return MXT_SUCCESS;
+
+  len = strcspn(start + 1, " ");
+  if (len == 0 || len > BRIDGE_TAG_MAX || start[len + 1] != ' ')
+    return MXT_ERROR_PROTOCOL_FAULT;
+
+  memcpy(tag, start + 1, len);
+  tag[len] = '\0';
+  *line = start + len + 2;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Take next request from receive buffer if it reads on from address
+///
+/// Any other request is left in the buffer to be handled in turn.
+/// \return true if read was taken
+static bool bridge_next_read(struct mxt_device *mxt,
+                             struct bridge_context *bridge_ctx,
+                             struct bridge_read *rd, size_t address,
+                             size_t room)
+{
+  struct bridge_rxbuf *rx = &bridge_ctx->rx;
+  size_t mark = rx->start;
+  bool discard = rx->discard;
+  struct bridge_frame_hdr hdr;
+  uint8_t *payload;
+  char *line;
+
+  if (bridge_ctx->binary) {
+    if (bridge_rx_getframe(mxt, rx, &hdr, &payload) == MXT_SUCCESS
+        && hdr.opcode == BRIDGE_OP_REA) {
+      rd->tag[0] = '\0';
+      rd->seq = hdr.seq;
+      rd->address = hdr.address;
+      rd->count = hdr.count;
+      goto check;
+    }
+  } else {
+    while (bridge_rx_getline(mxt, rx, &line) == MXT_SUCCESS) {
+      /* Skip empty line left by CRLF */
+      if (line[0] == '\0')
+        continue;
+
+      if (bridge_split_tag(&line, rd->tag) == MXT_SUCCESS
+          && sscanf(line, "REA %" SCNu16 " %" SCNu16,
+                    &rd->address, &rd->count) == 2) {
+        rd->seq = 0;
+        goto check;
+      }
+
+      break;
+    }
   }
 
-  ret = MXT_SUCCESS;
+  goto rewind;
+
+check:
+  if (rd->address == address && rd->count <= room)
+    return true;
+
+rewind:
+  rx->start = mark;
+  rx->discard = discard;
+  return false;
+}
+
+//******************************************************************************
+/// \brief Handle bridge read
+///
+/// For a pipelined client, further reads which are already buffered and carry
+/// on from this one are answered from a single device read. If that read
+/// fails, every read merged into it fails: reading again could repeat part
+/// of a read of T5 or T44 and use up messages.
+/// \return #mxt_rc
+static int bridge_rea_cmd(struct mxt_device *mxt,
+                          struct bridge_context *bridge_ctx,
+                          const struct bridge_read *first)
+{
+  struct bridge_read reads[BRIDGE_MERGE_MAX_READS];
+  uint8_t *databuf;
+  size_t total = first->count;
+  size_t off;
+  int num = 1;
+  int status;
+  int ret;
+  int i;
+
+  reads[0] = *first;
+  bridge_ctx->server->req_cmd = BRIDGE_STAT_REA;
+
+  if (bridge_ctx->pipelined) {
+    while (num < BRIDGE_MERGE_MAX_READS && total < BRIDGE_MERGE_MAX_BYTES
+           && bridge_next_read(mxt, bridge_ctx, &reads[num],
+                               first->address + total,
+                               BRIDGE_MERGE_MAX_BYTES - total)) {
+      total += reads[num].count;
+      num++;
+    }
+  }
+
+  databuf = malloc(total ? total : 1);
+  if (!databuf) {
+    mxt_err(mxt->ctx, "Failed to allocate memory");
+    return MXT_ERROR_NO_MEM;
+  }
+
+  status = mxt_read_register(mxt, databuf, first->address, total);
+
+  if (num > 1) {
+    mxt_verb(mxt->ctx, "Merged %d reads, %zu bytes at %u",
+             num, total, first->address);
+    bridge_ctx->reads_merged += num;
+    bridge_ctx->merged_transfers++;
+  }
+
+  for (i = 0, off = 0; i < num; off += reads[i].count, i++) {
+    if (bridge_ctx->binary && status) {
+      mxt_warn(mxt->ctx, "RRP ERR");
+      ret = bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_RRP,
+                              BRIDGE_STATUS_ERR, reads[i].seq,
+                              reads[i].address, 0, NULL, 0);
+    } else if (bridge_ctx->binary) {
+      ret = bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_RRP,
+                              BRIDGE_STATUS_OK, reads[i].seq,
+                              reads[i].address, reads[i].count,
+                              databuf + off, reads[i].count);
+    } else {
+      strcpy(bridge_ctx->tag, reads[i].tag);
+      ret = bridge_rea_reply(mxt, bridge_ctx,
+                             status ? NULL : databuf + off,
+                             reads[i].count);
+    }
+
+    if (ret)
+      break;
+  }
 
-free:
-  free(response);
-free_databuf:
   free(databuf);
   return ret;
 }
@@ -240,13 +1097,8 @@ static int bridge_wri_cmd(struct mxt_device *mxt, struct bridge_context *bridge_
     }
   }
 
-  ret = write(bridge_ctx->sockfd, response, strlen(response));
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-    ret = mxt_errno_to_rc(errno);
-  }
+  ret = bridge_reply(mxt, bridge_ctx, response, strlen(response));
 
-  ret = MXT_SUCCESS;
   free(databuf);
   return ret;
 }
@@ -261,7 +1113,7 @@ static int bridge_handle_reset(struct mxt_device *mxt,
   int ret;
   char *response;
   const char * const PREFIX = "RST ";
-  size_t response_len = 8;
+  size_t response_len = strlen(PREFIX) + strlen("ERR\n") + 1;
 
   /* Allow for newline/null byte */
   response = calloc(response_len, sizeof(uint8_t));
@@ -283,13 +1135,10 @@ static int bridge_handle_reset(struct mxt_device *mxt,
     response_len = strlen(response);
   }
 
-  ret = write(bridge_ctx->sockfd, response, response_len);
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-    ret = mxt_errno_to_rc(errno);
-    goto free;
-  }
-
+  ret = bridge_reply(mxt, bridge_ctx, response, response_len);
+  if (ret)
+    goto free;
+
   ret = MXT_SUCCESS;
 
 free:
@@ -311,14 +1160,10 @@ static int bridge_info_version(struct mxt_device *mxt, struct bridge_context *br
     return MXT_ERROR_NO_MEM;
   }
 
-  ret = write(bridge_ctx->sockfd, outstr, strlen(outstr));
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-    ret = mxt_errno_to_rc(errno);
-  }
+  ret = bridge_reply(mxt, bridge_ctx, outstr, strlen(outstr));
 
   free(outstr);
-  return MXT_SUCCESS;
+  return ret;
 }
 
 //******************************************************************************
@@ -368,14 +1213,41 @@ static int bridge_info_connection(struct mxt_device *mxt, struct bridge_context
     return MXT_ERROR_NO_MEM;
   }
 
-  ret = write(bridge_ctx->sockfd, outstr, strlen(outstr));
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-    ret = mxt_errno_to_rc(errno);
+  ret = bridge_reply(mxt, bridge_ctx, outstr, strlen(outstr));
+
+  free(outstr);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Output server statistics
+/// \return #mxt_rc
+static int bridge_info_stats(struct mxt_device *mxt,
+                             struct bridge_context *bridge_ctx)
+{
+  const char * const PREFIX = "INFO STATS ";
+  const size_t max_len = 8192;
+  char *outstr;
+  size_t len;
+  int ret;
+
+  outstr = malloc(max_len);
+  if (!outstr) {
+    mxt_err(mxt->ctx, "Failed to allocate memory");
+    return MXT_ERROR_NO_MEM;
   }
 
+  strcpy(outstr, PREFIX);
+  len = strlen(PREFIX);
+  len += bridge_stats_format(&bridge_ctx->server->stats,
+                             mxt_stats_now_us(),
+                             outstr + len, max_len - len - 1);
+  outstr[len++] = '\n';
+
+  ret = bridge_reply(mxt, bridge_ctx, outstr, len);
+
   free(outstr);
-  return MXT_SUCCESS;
+  return ret;
 }
 
 //******************************************************************************
@@ -390,221 +1262,1034 @@ static int bridge_info_cmd(struct mxt_device *mxt, struct bridge_context *bridge
     ret = bridge_info_connection(mxt, bridge_ctx);
   } else if (!strcmp(info, "VERSION")) {
     ret = bridge_info_version(mxt, bridge_ctx);
+  } else if (!strcmp(info, "STATS")) {
+    ret = bridge_info_stats(mxt, bridge_ctx);
   } else {
     mxt_warn(mxt->ctx, "%s unknown: \"%s\"", __func__, info);
     ret = MXT_SUCCESS;
   }
 
-  return ret;
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Send chip attach message
+/// \return #mxt_rc
+static int send_chip_attach(struct mxt_device *mxt, struct bridge_context *bridge_ctx)
+{
+  const char * const msg = "CAT\n";
+
+  mxt_dbg(mxt->ctx, "Sending chip attach");
+
+  return bridge_write(mxt, bridge_ctx, msg, strlen(msg));
+}
+
+//******************************************************************************
+/// \brief Send chip detach message
+/// \return #mxt_rc
+static int send_chip_detach(struct mxt_device *mxt,
+                            struct bridge_context *bridge_ctx)
+{
+  const char * const msg = "CDT\n";
+
+  if (bridge_ctx->binary)
+    return bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_CDT, BRIDGE_STATUS_OK,
+                             0, 0, 0, NULL, 0);
+
+  return bridge_write(mxt, bridge_ctx, msg, strlen(msg));
+}
+
+//******************************************************************************
+/// \brief Enable message forwarding to client
+///
+/// Old messages are discarded only if no other client is receiving them.
+/// In latest state mode touch position updates are coalesced while the
+/// client is behind, messages held from an earlier latest state
+/// configuration are discarded.
+/// \return #mxt_rc
+static int bridge_msgcfg(struct mxt_device *mxt,
+                         struct bridge_context *bridge_ctx, bool latest)
+{
+  struct bridge_server *server = bridge_ctx->server;
+  int others = server->num_subscribed - (bridge_ctx->msgs_enabled ? 1 : 0);
+  int ret;
+
+  mxt_info(mxt->ctx, "Configuring Messages");
+
+  if (others == 0) {
+    ret = mxt_msg_reset(mxt);
+    if (ret) {
+      mxt_warn(mxt->ctx, "Failure to reset msgs");
+      return ret;
+    }
+  }
+
+  if (latest && !bridge_ctx->latest) {
+    bridge_ctx->latest = calloc(1, sizeof(struct bridge_msgq));
+    if (!bridge_ctx->latest) {
+      mxt_err(mxt->ctx, "Failed to allocate memory");
+      return MXT_ERROR_NO_MEM;
+    }
+
+    mxt_info(mxt->ctx, "Sending latest touch state to client %d",
+             bridge_ctx->slot);
+  } else if (!latest && bridge_ctx->latest) {
+    free(bridge_ctx->latest);
+    bridge_ctx->latest = NULL;
+  }
+
+  if (!bridge_ctx->msgs_enabled) {
+    bridge_ctx->msgs_enabled = true;
+    server->num_subscribed++;
+    server->msg_watch_stale = true;
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Stop pushing diagnostic frames
+static void bridge_stream_stop(struct mxt_device *mxt,
+                               struct bridge_server *server)
+{
+  if (!server->stream_client)
+    return;
+
+  mxt_info(mxt->ctx, "Client %d: stopped streaming after %u frames",
+           server->stream_client->slot, server->stream.frame);
+
+  mxt_debug_dump_free(&server->stream);
+  server->stream_client = NULL;
+}
+
+//******************************************************************************
+/// \brief Start pushing diagnostic frames of mode to client
+///
+/// Only one client may stream at a time, since all frames are paged through
+/// the one T37 object.
+/// \return #mxt_rc
+static int bridge_stream_start(struct mxt_device *mxt,
+                               struct bridge_context *bridge_ctx, uint8_t mode)
+{
+  struct bridge_server *server = bridge_ctx->server;
+  struct t37_ctx *stream = &server->stream;
+  int ret;
+
+  if (server->stream_client && server->stream_client != bridge_ctx) {
+    mxt_warn(mxt->ctx, "Client %d is already streaming",
+             server->stream_client->slot);
+    return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
+  }
+
+  bridge_stream_stop(mxt, server);
+
+  memset(stream, 0, sizeof(*stream));
+  stream->lc = mxt->ctx;
+  stream->mxt = mxt;
+  stream->mode = mode;
+
+  ret = mxt_debug_dump_initialise(stream);
+  if (ret) {
+    mxt_debug_dump_free(stream);
+    return ret;
+  }
+
+  if (bridge_ctx->binary
+      && (stream->data_values + 2) * sizeof(uint16_t) > BRIDGE_FRAME_MAX_PAYLOAD) {
+    mxt_warn(mxt->ctx, "Mode %02X frames of %d values do not fit in a frame",
+             mode, stream->data_values);
+    mxt_debug_dump_free(stream);
+    return MXT_ERROR_NOT_SUPPORTED;
+  }
+
+  mxt_info(mxt->ctx, "Client %d: streaming mode %02X", bridge_ctx->slot, mode);
+  server->stream_client = bridge_ctx;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Whether the next frame should be captured now
+static bool bridge_stream_ready(struct bridge_server *server)
+{
+  struct bridge_context *client = server->stream_client;
+
+  return client && !client->failed
+         && bridge_tx_pending(&client->tx) <= BRIDGE_TX_HIGH_WATER;
+}
+
+//******************************************************************************
+/// \brief Capture next diagnostic frame and push it to the streaming client
+///
+/// If the capture fails the client is told so and streaming stops. If the
+/// frame cannot be sent the client is disconnected.
+static void bridge_stream_frame(struct mxt_device *mxt,
+                                struct bridge_server *server)
+{
+  struct bridge_context *client = server->stream_client;
+  struct t37_ctx *stream = &server->stream;
+  const char * const frm_err = "FRM ERR\n";
+  size_t num_values = stream->data_values;
+  size_t payload_len = (num_values + 2) * sizeof(uint16_t);
+  uint16_t *payload;
+  char *ascii;
+  char *p;
+  size_t i;
+  int ret;
+
+  stream->frame++;
+
+  ret = mxt_read_diagnostic_frame(stream);
+  if (ret) {
+    mxt_warn(mxt->ctx, "Failed to capture frame %u", stream->frame);
+    goto fail;
+  }
+
+  /* A client which switched to binary after STREAM may not fit the frame */
+  if (client->binary && payload_len > BRIDGE_FRAME_MAX_PAYLOAD) {
+    mxt_warn(mxt->ctx, "Frame of %zu values is too large", num_values);
+    goto fail;
+  }
+
+  /* X and Y size followed by the values, all little endian */
+  payload = malloc(payload_len);
+  if (!payload) {
+    mxt_err(mxt->ctx, "Failed to allocate memory");
+    goto fail;
+  }
+
+  payload[0] = htole16(stream->x_size);
+  payload[1] = htole16(stream->y_size);
+  for (i = 0; i < num_values; i++)
+    payload[i + 2] = htole16(stream->data_buf[i]);
+
+  if (client->binary) {
+    ret = bridge_send_frame(mxt, client, BRIDGE_OP_FRM, BRIDGE_STATUS_OK,
+                            stream->frame, stream->mode, num_values,
+                            payload, payload_len);
+  } else {
+    /* "FRM mode frame x y " plus hex values and newline */
+    ascii = malloc(32 + num_values * 4 + 1);
+    if (ascii) {
+      p = ascii + sprintf(ascii, "FRM %02X %u %d %d ", stream->mode,
+                          stream->frame, stream->x_size, stream->y_size);
+      p = mxt_hex_encode(p, (uint8_t *)(payload + 2),
+                     num_values * sizeof(uint16_t));
+      *p++ = '\n';
+
+      ret = bridge_write(mxt, client, ascii, p - ascii);
+      free(ascii);
+    } else {
+      mxt_err(mxt->ctx, "Failed to allocate memory");
+      ret = MXT_ERROR_NO_MEM;
+    }
+  }
+
+  free(payload);
+  if (ret)
+    goto disconnect;
+
+  return;
+
+fail:
+  if (client->binary)
+    ret = bridge_send_frame(mxt, client, BRIDGE_OP_FRM, BRIDGE_STATUS_ERR,
+                            stream->frame, stream->mode, 0, NULL, 0);
+  else
+    ret = bridge_write(mxt, client, frm_err, strlen(frm_err));
+
+  if (!ret) {
+    bridge_stream_stop(mxt, server);
+    return;
+  }
+
+disconnect:
+  mxt_warn(mxt->ctx, "Client %d: failed to send frame %u, disconnecting",
+           client->slot, stream->frame);
+  client->failed = true;
+  bridge_stream_stop(mxt, server);
+}
+
+//******************************************************************************
+/// \brief Deal with incoming binary frame
+/// \return #mxt_rc
+static int handle_frame(struct mxt_device *mxt, struct bridge_context *bridge_ctx,
+                        struct bridge_frame_hdr *hdr, uint8_t *payload)
+{
+  struct bridge_read rd;
+  uint16_t length = hdr->length;
+  uint16_t seq = hdr->seq;
+  uint16_t address = hdr->address;
+  uint16_t count = hdr->count;
+  uint8_t status;
+  int ret;
+
+  mxt_verb(mxt->ctx, "Frame opcode:%02X seq:%u address:%u count:%u length:%u",
+           hdr->opcode, seq, address, count, length);
+  MXT_PROBE4(bridge__frame, hdr->opcode, seq, address, count);
+
+  switch (hdr->opcode) {
+  case BRIDGE_OP_REA:
+    rd.tag[0] = '\0';
+    rd.seq = seq;
+    rd.address = address;
+    rd.count = count;
+    ret = bridge_rea_cmd(mxt, bridge_ctx, &rd);
+    break;
+
+  case BRIDGE_OP_WRI:
+    bridge_ctx->server->req_cmd = BRIDGE_STAT_WRI;
+    ret = mxt_write_register(mxt, payload, address, length);
+    status = ret ? BRIDGE_STATUS_ERR : BRIDGE_STATUS_OK;
+    ret = bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_WRP, status,
+                            seq, address, length, NULL, 0);
+    break;
+
+  case BRIDGE_OP_RST:
+    bridge_ctx->server->req_cmd = BRIDGE_STAT_RST;
+    ret = mxt_reset_chip(mxt, false);
+    status = ret ? BRIDGE_STATUS_ERR : BRIDGE_STATUS_OK;
+    ret = bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_RSTRP, status,
+                            seq, 0, 0, NULL, 0);
+    break;
+
+  case BRIDGE_OP_MSGCFG:
+    bridge_ctx->server->req_cmd = BRIDGE_STAT_MSGCFG;
+    ret = bridge_msgcfg(mxt, bridge_ctx, address == 1);
+    status = ret ? BRIDGE_STATUS_ERR : BRIDGE_STATUS_OK;
+    ret = bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_MSGRP, status,
+                            seq, 0, 0, NULL, 0);
+    break;
+
+  case BRIDGE_OP_STREAM:
+    if (address == 0) {
+      if (bridge_ctx->server->stream_client == bridge_ctx)
+        bridge_stream_stop(mxt, bridge_ctx->server);
+      ret = MXT_SUCCESS;
+    } else if (address > 0xFF) {
+      ret = MXT_ERROR_BAD_INPUT;
+    } else {
+      ret = bridge_stream_start(mxt, bridge_ctx, address);
+    }
+
+    status = ret ? BRIDGE_STATUS_ERR : BRIDGE_STATUS_OK;
+    ret = bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_STREAMRP, status,
+                            seq, address, 0, NULL, 0);
+    break;
+
+  case BRIDGE_OP_ASCII:
+    mxt_info(mxt->ctx, "Switching to ASCII protocol");
+    ret = bridge_send_frame(mxt, bridge_ctx, BRIDGE_OP_ASCIIRP,
+                            BRIDGE_STATUS_OK, seq, 0, 0, NULL, 0);
+    bridge_ctx->binary = false;
+    break;
+
+  default:
+    mxt_warn(mxt->ctx, "UNKNOWN opcode: %02X", hdr->opcode);
+    ret = bridge_send_frame(mxt, bridge_ctx, hdr->opcode | 0x80,
+                            BRIDGE_STATUS_UNKNOWN, seq, 0, 0, NULL, 0);
+    break;
+  }
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Deal with incoming command line
+/// \return #mxt_rc
+static int handle_line(struct mxt_device *mxt, struct bridge_context *bridge_ctx,
+                       char *line)
+{
+  int ret;
+  const char * const unknown_cmd = "UNKNOWN COMMAND\n";
+  const char * const msgcfg_ok = "MSGCFG OK\n";
+  const char * const msgcfg_err = "MSGCFG ERR\n";
+  const char * msgcfg_response;
+  const char * const info_cmd = "INFO ";
+  const char * const binary_ok = BRIDGE_BINARY_OK "\n";
+  const char * const pipe_ok = BRIDGE_PIPE_OK "\n";
+  const char * const stream_ok = "STREAM OK\n";
+  const char * const stream_err = "STREAM ERR\n";
+  struct bridge_read rd;
+  uint8_t mode;
+  int offset;
+
+  if (strlen(line) == 0)
+    return MXT_SUCCESS;
+
+  mxt_verb(mxt->ctx, "%s", line);
+  MXT_PROBE1(bridge__line, line);
+
+  if (!strcmp(line, "SAT")) {
+    mxt_info(mxt->ctx, "Server attached");
+    ret = MXT_SUCCESS;
+  } else if (!strcmp(line, "SDT")) {
+    mxt_info(mxt->ctx, "Server detached");
+    ret = MXT_SUCCESS;
+  } else if (sscanf(line, "REA %" SCNu16 " %" SCNu16,
+                    &rd.address, &rd.count) == 2) {
+    strcpy(rd.tag, bridge_ctx->tag);
+    rd.seq = 0;
+    ret = bridge_rea_cmd(mxt, bridge_ctx, &rd);
+  } else if (sscanf(line, "WRI %" SCNu16 "%n", &rd.address, &offset) == 1) {
+    /* skip space */
+    offset += 1;
+
+    bridge_ctx->server->req_cmd = BRIDGE_STAT_WRI;
+    ret = bridge_wri_cmd(mxt, bridge_ctx, rd.address,
+                         line + offset,
+                         strlen(line) - offset);
+  } else if (sscanf(line, "RST %" SCNu16 "%n", &rd.address, &offset) == 1) {
+    bridge_ctx->server->req_cmd = BRIDGE_STAT_RST;
+    ret = bridge_handle_reset(mxt, bridge_ctx, rd.address);
+    ret = MXT_SUCCESS;
+  } else if (!strcmp(line, BRIDGE_MSGCFG_LATEST)) {
+    bridge_ctx->server->req_cmd = BRIDGE_STAT_MSGCFG;
+    ret = bridge_msgcfg(mxt, bridge_ctx, true);
+    msgcfg_response = ret ? msgcfg_err : msgcfg_ok;
+
+    ret = bridge_reply(mxt, bridge_ctx, msgcfg_response, strlen(msgcfg_response));
+  } else if (sscanf(line, "MSGCFG %" SCNu16 "%n", &rd.address, &offset) == 1) {
+    bridge_ctx->server->req_cmd = BRIDGE_STAT_MSGCFG;
+    ret = bridge_msgcfg(mxt, bridge_ctx, false);
+    msgcfg_response = ret ? msgcfg_err : msgcfg_ok;
+
+    ret = bridge_reply(mxt, bridge_ctx, msgcfg_response, strlen(msgcfg_response));
+  } else if (!strncmp(line, info_cmd, strlen(info_cmd))) {
+    ret = bridge_info_cmd(mxt, bridge_ctx, line + strlen(info_cmd));
+  } else if (!strcmp(line, BRIDGE_BINARY_CMD)) {
+    mxt_info(mxt->ctx, "Switching to binary protocol");
+
+    ret = bridge_reply(mxt, bridge_ctx, binary_ok, strlen(binary_ok));
+    if (ret == MXT_SUCCESS)
+      bridge_ctx->binary = true;
+  } else if (!strcmp(line, BRIDGE_STREAM_STOP)) {
+    if (bridge_ctx->server->stream_client == bridge_ctx)
+      bridge_stream_stop(mxt, bridge_ctx->server);
+
+    ret = bridge_reply(mxt, bridge_ctx, stream_ok, strlen(stream_ok));
+  } else if (sscanf(line, BRIDGE_STREAM_CMD " %" SCNx8, &mode) == 1) {
+    ret = bridge_stream_start(mxt, bridge_ctx, mode);
+    if (ret)
+      ret = bridge_reply(mxt, bridge_ctx, stream_err, strlen(stream_err));
+    else
+      ret = bridge_reply(mxt, bridge_ctx, stream_ok, strlen(stream_ok));
+  } else if (!strcmp(line, BRIDGE_PIPE_CMD)) {
+    mxt_info(mxt->ctx, "Pipelining requests");
+
+    ret = bridge_reply(mxt, bridge_ctx, pipe_ok, strlen(pipe_ok));
+    bridge_ctx->pipelined = true;
+  } else {
+    mxt_warn(mxt->ctx, "UNKNOWN: \"%s\"", line);
+
+    ret = bridge_reply(mxt, bridge_ctx, unknown_cmd, strlen(unknown_cmd));
+  }
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Deal with next complete command or frame from client
+/// \return #mxt_rc, MXT_ERROR_NO_MESSAGE if none is buffered
+static int bridge_process_request(struct mxt_device *mxt,
+                                  struct bridge_context *bridge_ctx)
+{
+  const char * const unknown_cmd = "UNKNOWN COMMAND\n";
+  struct bridge_server *server = bridge_ctx->server;
+  struct bridge_frame_hdr hdr;
+  uint8_t *payload;
+  uint64_t start_us;
+  uint64_t total_us;
+  char *line;
+  int ret;
+
+  server->req_cmd = BRIDGE_STAT_NONE;
+  server->req_socket_us = 0;
+  start_us = mxt_stats_now_us();
+
+  /* Mode may change part way through the buffer */
+  if (bridge_ctx->binary) {
+    ret = bridge_rx_getframe(mxt, &bridge_ctx->rx, &hdr, &payload);
+    if (ret == MXT_SUCCESS)
+      ret = handle_frame(mxt, bridge_ctx, &hdr, payload);
+  } else {
+    ret = bridge_rx_getline(mxt, &bridge_ctx->rx, &line);
+    if (ret == MXT_SUCCESS) {
+      bridge_ctx->tag[0] = '\0';
+
+      if (bridge_ctx->pipelined
+          && bridge_split_tag(&line, bridge_ctx->tag) != MXT_SUCCESS) {
+        mxt_warn(mxt->ctx, "Bad tag: \"%s\"", line);
+        ret = bridge_write(mxt, bridge_ctx, unknown_cmd, strlen(unknown_cmd));
+      } else {
+        ret = handle_line(mxt, bridge_ctx, line);
+      }
+    } else if (ret == MXT_ERROR_PROTOCOL_FAULT) {
+      /* Keep replies in step with requests */
+      ret = bridge_write(mxt, bridge_ctx, unknown_cmd, strlen(unknown_cmd));
+    }
+  }
+
+  if (server->req_cmd != BRIDGE_STAT_NONE) {
+    total_us = mxt_stats_now_us() - start_us;
+    bridge_stats_record(&server->stats, server->req_cmd,
+                        total_us - server->req_socket_us,
+                        server->req_socket_us);
+  }
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Add client to the back of the request queue
+static void bridge_queue_client(struct bridge_server *server,
+                                struct bridge_context *bridge_ctx)
+{
+  if (bridge_ctx->queued || bridge_ctx->rx_paused || bridge_ctx->failed)
+    return;
+
+  bridge_ctx->queued = true;
+  bridge_ctx->next = NULL;
+
+  if (server->queue_tail)
+    server->queue_tail->next = bridge_ctx;
+  else
+    server->queue_head = bridge_ctx;
+
+  server->queue_tail = bridge_ctx;
+}
+
+//******************************************************************************
+/// \brief Serve queued requests one at a time, round robin between clients
+static void bridge_run_queue(struct mxt_device *mxt,
+                             struct bridge_server *server)
+{
+  struct bridge_context *bridge_ctx;
+  int ret;
+
+  while (server->queue_head) {
+    bridge_ctx = server->queue_head;
+    server->queue_head = bridge_ctx->next;
+    if (!server->queue_head)
+      server->queue_tail = NULL;
+
+    bridge_ctx->queued = false;
+    if (bridge_ctx->failed)
+      continue;
+
+    ret = bridge_process_request(mxt, bridge_ctx);
+    if (ret == MXT_SUCCESS) {
+      bridge_queue_client(server, bridge_ctx);
+    } else if (ret != MXT_ERROR_NO_MESSAGE) {
+      mxt_err(mxt->ctx, "Client %d request returned %d", bridge_ctx->slot, ret);
+      bridge_ctx->failed = true;
+    }
+  }
+}
+
+//******************************************************************************
+/// \brief Update epoll events for client from its buffer state
+static void bridge_update_events(struct mxt_device *mxt,
+                                 struct bridge_server *server,
+                                 struct bridge_context *bridge_ctx)
+{
+  struct epoll_event ev;
+
+  ev.events = 0;
+  if (!bridge_ctx->rx_paused && !bridge_ctx->rx_eof)
+    ev.events |= EPOLLIN | EPOLLRDHUP;
+  if (bridge_tx_pending(&bridge_ctx->tx) > 0)
+    ev.events |= EPOLLOUT;
+
+  if (ev.events == bridge_ctx->events)
+    return;
+
+  ev.data.u32 = bridge_ctx->slot;
+  if (epoll_ctl(server->epfd, EPOLL_CTL_MOD, bridge_ctx->sockfd, &ev) < 0) {
+    mxt_err(mxt->ctx, "epoll_ctl error: %s (%d)", strerror(errno), errno);
+    bridge_ctx->failed = true;
+    return;
+  }
+
+  bridge_ctx->events = ev.events;
+}
+
+//******************************************************************************
+/// \brief Register device message notification with epoll
+///
+/// The sysfs notification fd is reopened each time messages are read, so it
+/// is registered again afterwards. Without a usable fd messages are polled
+/// on a timer instead.
+static void bridge_watch_msgs(struct mxt_device *mxt,
+                              struct bridge_server *server)
+{
+  struct epoll_event ev;
+  int fd = 0;
+
+  server->msg_watch_stale = false;
+
+  if (server->msg_fd >= 0) {
+    epoll_ctl(server->epfd, EPOLL_CTL_DEL, server->msg_fd, NULL);
+    server->msg_fd = -1;
+  }
+
+  server->msg_timer = (server->num_subscribed > 0);
+  if (!server->msg_timer)
+    return;
+
+  fd = mxt_get_msg_poll_fd(mxt);
+  if (fd <= 0)
+    return;
+
+  ev.events = EPOLLPRI;
+  ev.data.u32 = BRIDGE_EV_MSG;
+
+  if (epoll_ctl(server->epfd, EPOLL_CTL_ADD, fd, &ev) < 0
+      && (errno != EEXIST
+          || epoll_ctl(server->epfd, EPOLL_CTL_MOD, fd, &ev) < 0)) {
+    mxt_dbg(mxt->ctx, "Cannot wait on message fd: %s (%d)",
+            strerror(errno), errno);
+    return;
+  }
+
+  server->msg_fd = fd;
+  server->msg_timer = false;
+}
+
+//******************************************************************************
+/// \brief Milliseconds until messages are next due to be polled
+static int bridge_msg_timeout(struct bridge_server *server)
+{
+  struct timespec now;
+  long elapsed;
+
+  if (!server->msg_timer)
+    return -1;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  elapsed = (now.tv_sec - server->msg_last.tv_sec) * 1000
+            + (now.tv_nsec - server->msg_last.tv_nsec) / 1000000;
+
+  if (elapsed >= BRIDGE_MSG_POLL_MS)
+    return 0;
+
+  return BRIDGE_MSG_POLL_MS - elapsed;
 }
 
 //******************************************************************************
-/// \brief Send chip attach message
-/// \return #mxt_rc
-static int send_chip_attach(struct mxt_device *mxt, struct bridge_context *bridge_ctx)
+/// \brief Time to wait for events before there is other work to do
+/// \return milliseconds, or -1 to wait indefinitely
+static int bridge_timeout(struct bridge_server *server)
 {
-  int ret;
-  const char * const msg = "CAT\n";
+  int timeout;
+  int stats_timeout;
 
-  mxt_dbg(mxt->ctx, "Sending chip attach");
+  /* Keep capturing frames while checking for requests */
+  if (bridge_stream_ready(server))
+    return 0;
 
-  ret = write(bridge_ctx->sockfd, msg, strlen(msg));
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-    ret = mxt_errno_to_rc(errno);
-  }
+  timeout = bridge_msg_timeout(server);
 
-  return MXT_SUCCESS;
+  stats_timeout = bridge_stats_timeout(&server->stats, mxt_stats_now_us());
+  if (stats_timeout >= 0 && (timeout < 0 || stats_timeout < timeout))
+    timeout = stats_timeout;
+
+  return timeout;
 }
 
 //******************************************************************************
-/// \brief Send chip detach message
+/// \brief Set up state for new client connection and send chip attach
 /// \return #mxt_rc
-static int send_chip_detach(struct mxt_device *mxt,
-                            struct bridge_context *bridge_ctx)
+static int bridge_add_client(struct mxt_device *mxt,
+                             struct bridge_server *server, int sockfd)
 {
+  struct bridge_context *bridge_ctx;
+  struct epoll_event ev;
+  int slot;
   int ret;
-  const char * const msg = "CDT\n";
 
-  ret = write(bridge_ctx->sockfd, msg, strlen(msg));
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-    ret = mxt_errno_to_rc(errno);
+  for (slot = 0; slot < BRIDGE_MAX_CLIENTS; slot++) {
+    if (!server->clients[slot])
+      break;
+  }
+
+  if (slot == BRIDGE_MAX_CLIENTS) {
+    mxt_warn(mxt->ctx, "Too many clients, refusing connection");
+    close(sockfd);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  if (fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK) < 0) {
+    mxt_err(mxt->ctx, "fcntl error: %s (%d)", strerror(errno), errno);
+    close(sockfd);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  bridge_ctx = calloc(1, sizeof(struct bridge_context));
+  if (!bridge_ctx) {
+    mxt_err(mxt->ctx, "Failed to allocate memory");
+    close(sockfd);
+    return MXT_ERROR_NO_MEM;
+  }
+
+  bridge_ctx->sockfd = sockfd;
+  bridge_ctx->server = server;
+  bridge_ctx->slot = slot;
+  bridge_ctx->msgs_enabled = false;
+  bridge_ctx->binary = false;
+  bridge_tx_init(&bridge_ctx->tx, sockfd);
+
+  ret = bridge_rx_init(&bridge_ctx->rx, sockfd);
+  if (ret)
+    goto free;
+
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  ev.data.u32 = slot;
+  if (epoll_ctl(server->epfd, EPOLL_CTL_ADD, sockfd, &ev) < 0) {
+    mxt_err(mxt->ctx, "epoll_ctl error: %s (%d)", strerror(errno), errno);
+    ret = MXT_ERROR_CONNECTION_FAILURE;
+    goto free_rx;
   }
 
+  bridge_ctx->events = ev.events;
+  server->clients[slot] = bridge_ctx;
+  server->num_clients++;
+
+  mxt_info(mxt->ctx, "Client %d connected", slot);
+
+  send_chip_attach(mxt, bridge_ctx);
   return MXT_SUCCESS;
+
+free_rx:
+  bridge_rx_free(&bridge_ctx->rx);
+free:
+  free(bridge_ctx);
+  close(sockfd);
+  return ret;
 }
 
 //******************************************************************************
-/// \brief Read and deal with incoming command
-/// \return #mxt_rc
-static int handle_cmd(struct mxt_device *mxt, struct bridge_context *bridge_ctx)
+/// \brief Send chip detach if possible and release client
+static void bridge_remove_client(struct mxt_device *mxt,
+                                 struct bridge_server *server,
+                                 struct bridge_context *bridge_ctx)
 {
-  int ret;
-  const char * const unknown_cmd = "UNKNOWN COMMAND\n";
-  const char * const msgcfg_ok = "MSGCFG OK\n";
-  const char * const msgcfg_err = "MSGCFG ERR\n";
-  const char * msgcfg_response;
-  const char * const info_cmd = "INFO ";
-  uint16_t address;
-  uint16_t count;
-  struct mxt_buffer linebuf;
-  char *line;
-  int offset;
+  if (server->stream_client == bridge_ctx)
+    bridge_stream_stop(mxt, server);
 
-  ret = mxt_buf_init(&linebuf);
-  if (ret)
-    return ret;
+  if (!bridge_ctx->failed) {
+    send_chip_detach(mxt, bridge_ctx);
+    bridge_tx_flush(mxt, &bridge_ctx->tx);
+  }
 
-  ret = readline(mxt, bridge_ctx->sockfd, &linebuf);
-  if (ret) {
-    mxt_dbg(mxt->ctx, "Error reading or peer closed socket");
-    goto free;
+  if (bridge_ctx->msg_flushes > 0)
+    mxt_dbg(mxt->ctx, "Client %d: sent %lu messages in %lu writes, "
+            "max %d per write, dropped %lu",
+            bridge_ctx->slot, bridge_ctx->msg_total, bridge_ctx->msg_flushes,
+            bridge_ctx->msg_max_batch, bridge_ctx->msgs_dropped);
+
+  if (bridge_ctx->merged_transfers > 0)
+    mxt_dbg(mxt->ctx, "Client %d: merged %lu reads into %lu transfers",
+            bridge_ctx->slot, bridge_ctx->reads_merged,
+            bridge_ctx->merged_transfers);
+
+  if (bridge_ctx->latest)
+    mxt_dbg(mxt->ctx, "Client %d: merged %lu position updates",
+            bridge_ctx->slot, bridge_ctx->latest->merged);
+
+  if (bridge_ctx->msgs_enabled) {
+    server->num_subscribed--;
+    server->msg_watch_stale = true;
   }
 
-  line = (char *)linebuf.data;
-  if (strlen(line) == 0) {
-    ret = MXT_SUCCESS;
-    goto free;
+  epoll_ctl(server->epfd, EPOLL_CTL_DEL, bridge_ctx->sockfd, NULL);
+  close(bridge_ctx->sockfd);
+
+  server->clients[bridge_ctx->slot] = NULL;
+  server->num_clients--;
+
+  mxt_info(mxt->ctx, "Client %d disconnected", bridge_ctx->slot);
+
+  bridge_rx_free(&bridge_ctx->rx);
+  bridge_tx_free(&bridge_ctx->tx);
+  free(bridge_ctx->latest);
+  free(bridge_ctx);
+
+  /* This string is used by ADB bridge client */
+  if (server->listenfd >= 0) {
+    printf("DISCONNECTED\n");
+    fflush(stdout);
   }
+}
 
-  mxt_verb(mxt->ctx, "%s", line);
+//******************************************************************************
+/// \brief Accept pending connection on listening socket
+static void bridge_accept(struct mxt_device *mxt, struct bridge_server *server)
+{
+  struct sockaddr_storage client_addr;
+  socklen_t sin_size = sizeof(client_addr);
+  int sockfd;
 
-  if (!strcmp(line, "SAT")) {
-    mxt_info(mxt->ctx, "Server attached");
-    ret = MXT_SUCCESS;
-  } else if (!strcmp(line, "SDT")) {
-    mxt_info(mxt->ctx, "Server detached");
-    ret = MXT_SUCCESS;
-  } else if (sscanf(line, "REA %" SCNu16 " %" SCNu16, &address, &count) == 2) {
-    ret = bridge_rea_cmd(mxt, bridge_ctx, address, count);
-  } else if (sscanf(line, "WRI %" SCNu16 "%n", &address, &offset) == 1) {
-    /* skip space */
-    offset += 1;
+  sockfd = accept(server->listenfd, (struct sockaddr *) &client_addr, &sin_size);
+  if (sockfd < 0) {
+    mxt_err(mxt->ctx, "Accept error: %s (%d)", strerror(errno), errno);
+    return;
+  }
 
-    ret = bridge_wri_cmd(mxt, bridge_ctx, address,
-                         line + offset,
-                         strlen(line) - offset);
-  } else if (sscanf(line, "RST %" SCNu16 "%n", &address, &offset) == 1) {
-    ret = bridge_handle_reset(mxt, bridge_ctx, address);
-    ret = MXT_SUCCESS;
-  } else if (sscanf(line, "MSGCFG %" SCNu16 "%n", &address, &offset) == 1) {
-    mxt_info(mxt->ctx, "Configuring Messages");
+  if (bridge_add_client(mxt, server, sockfd) == MXT_SUCCESS) {
+    printf("CONNECTED\n");
+    fflush(stdout);
+  }
+}
 
-    ret = mxt_msg_reset(mxt);
-    if (ret) {
-      mxt_warn(mxt->ctx, "Failure to reset msgs");
-      msgcfg_response = msgcfg_err;
-    } else {
-      bridge_ctx->msgs_enabled = true;
-      msgcfg_response = msgcfg_ok;
-    }
+//******************************************************************************
+/// \brief Handle epoll event on client socket
+static void bridge_client_event(struct mxt_device *mxt,
+                                struct bridge_server *server,
+                                struct bridge_context *bridge_ctx,
+                                uint32_t events)
+{
+  size_t buffered;
+  int ret;
 
-    ret = write(bridge_ctx->sockfd, msgcfg_response, strlen(msgcfg_response));
-    if (ret < 0) {
-      mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-      ret = mxt_errno_to_rc(errno);
+  if (events & EPOLLOUT) {
+    ret = bridge_tx_flush(mxt, &bridge_ctx->tx);
+    if (ret) {
+      bridge_ctx->failed = true;
+      return;
     }
+  }
 
-    ret = MXT_SUCCESS;
-  } else if (!strncmp(line, info_cmd, strlen(info_cmd))) {
-    ret = bridge_info_cmd(mxt, bridge_ctx, line + strlen(info_cmd));
-  } else {
-    ret = write(bridge_ctx->sockfd, unknown_cmd, strlen(unknown_cmd));
-    if (ret < 0) {
-      mxt_err(mxt->ctx, "Socket write error: %s (%d)", strerror(errno), errno);
-      ret = mxt_errno_to_rc(errno);
+  if (!bridge_ctx->rx_paused && !bridge_ctx->rx_eof
+      && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+    buffered = bridge_ctx->rx.end - bridge_ctx->rx.start;
+    ret = bridge_rx_fill(mxt, &bridge_ctx->rx);
+    server->stats.bytes_in += bridge_ctx->rx.end - bridge_ctx->rx.start
+                              - buffered;
+    if (ret == MXT_ERROR_CONNECTION_FAILURE) {
+      /* Answer requests already received before closing */
+      bridge_ctx->rx_eof = true;
+    } else if (ret) {
+      mxt_dbg(mxt->ctx, "Error reading from socket");
+      bridge_ctx->failed = true;
+      return;
     }
 
-    mxt_warn(mxt->ctx, "UNKNOWN: \"%s\"", line);
-    ret = MXT_SUCCESS;
+    bridge_queue_client(server, bridge_ctx);
   }
-
-free:
-  mxt_buf_free(&linebuf);
-  return ret;
 }
 
 //******************************************************************************
-/// \brief Main bridge function to handle a single connection
+/// \brief Event loop serving all clients and forwarding device messages
+///
+/// Runs until the device fails, or when running as a client until the
+/// connection is closed.
 /// \return #mxt_rc
-static int bridge(struct mxt_device *mxt, struct bridge_context *bridge_ctx)
+static int bridge(struct mxt_device *mxt, struct bridge_server *server)
 {
-  int ret, pollret;
-  struct pollfd fds[2];
-  int fopts = 0;
-  int debug_ng_fd = 0;
-  int numfds = 1;
+  struct epoll_event events[BRIDGE_MAX_CLIENTS + 2];
+  struct bridge_context *bridge_ctx;
+  bool msg_ready;
   int timeout;
+  int n, i;
+  int ret = MXT_SUCCESS;
 
-  fds[0].fd = bridge_ctx->sockfd;
-  fds[0].events = POLLIN | POLLERR;
+  clock_gettime(CLOCK_MONOTONIC, &server->msg_last);
 
-  ret = send_chip_attach(mxt, bridge_ctx);
-  if (ret)
-    return ret;
+  while (server->listenfd >= 0 || server->num_clients > 0) {
+    if (server->msg_watch_stale)
+      bridge_watch_msgs(mxt, server);
 
-  while (1) {
-    debug_ng_fd = mxt_get_msg_poll_fd(mxt);
-    if (debug_ng_fd) {
-      fds[1].fd = debug_ng_fd;
-      fds[1].events = POLLPRI;
-      numfds = 2;
-      timeout = -1;
-    } else {
-      timeout = 25; // milliseconds
-    }
+    timeout = bridge_timeout(server);
 
-    pollret = poll(fds, numfds, timeout);
-    if (pollret == -1 && errno == EINTR) {
+    n = epoll_wait(server->epfd, events, BRIDGE_MAX_CLIENTS + 2, timeout);
+    if (n < 0 && errno == EINTR) {
       mxt_dbg(mxt->ctx, "Interrupted");
       continue;
-    } else if (pollret == -1) {
-      mxt_err(mxt->ctx, "Poll returned %d (%s)", errno, strerror(errno));
+    } else if (n < 0) {
+      mxt_err(mxt->ctx, "epoll_wait returned %d (%s)", errno, strerror(errno));
       ret = mxt_errno_to_rc(errno);
-      goto disconnect;
+      break;
     }
 
-    /* Detect socket disconnect */
-    if (fcntl(bridge_ctx->sockfd, F_GETFL, &fopts) < 0) {
-      ret = MXT_SUCCESS;
-      mxt_warn(mxt->ctx, "Socket disconnected");
-      goto disconnect;
+    msg_ready = false;
+
+    for (i = 0; i < n; i++) {
+      if (events[i].data.u32 == BRIDGE_EV_LISTEN) {
+        bridge_accept(mxt, server);
+      } else if (events[i].data.u32 == BRIDGE_EV_MSG) {
+        msg_ready = true;
+      } else {
+        bridge_ctx = server->clients[events[i].data.u32];
+        if (bridge_ctx)
+          bridge_client_event(mxt, server, bridge_ctx, events[i].events);
+      }
     }
 
-    if (fds[0].revents) {
-      ret = handle_cmd(mxt, bridge_ctx);
-      if (ret) {
-        mxt_err(mxt->ctx, "handle_cmd returned %d", ret);
-        goto disconnect;
+    /* Resume clients which have caught up with their output */
+    for (i = 0; i < BRIDGE_MAX_CLIENTS; i++) {
+      bridge_ctx = server->clients[i];
+      if (bridge_ctx && bridge_ctx->rx_paused
+          && bridge_tx_pending(&bridge_ctx->tx) < BRIDGE_TX_LOW_WATER) {
+        mxt_dbg(mxt->ctx, "Client %d resumed", i);
+        bridge_ctx->rx_paused = false;
+        bridge_queue_client(server, bridge_ctx);
       }
     }
 
-    /* If timeout or msg poll fd event */
-    if (pollret == 0 || fds[1].revents) {
-      ret = handle_messages(mxt, bridge_ctx);
+    bridge_run_queue(mxt, server);
+
+    if (bridge_stream_ready(server))
+      bridge_stream_frame(mxt, server);
+
+    if (msg_ready || bridge_msg_timeout(server) == 0) {
+      clock_gettime(CLOCK_MONOTONIC, &server->msg_last);
+
+      ret = bridge_handle_messages(mxt, server);
       if (ret) {
         mxt_err(mxt->ctx, "handle_messages returned %d", ret);
-        goto disconnect;
+        break;
+      }
+    }
+
+    bridge_stats_report(mxt->ctx, &server->stats, mxt_stats_now_us());
+
+    for (i = 0; i < BRIDGE_MAX_CLIENTS; i++) {
+      bridge_ctx = server->clients[i];
+      if (!bridge_ctx)
+        continue;
+
+      if (bridge_ctx->rx_eof && !bridge_ctx->rx_paused
+          && bridge_tx_pending(&bridge_ctx->tx) == 0)
+        bridge_ctx->failed = true;
+
+      if (!bridge_ctx->failed) {
+        bridge_flush_latest(mxt, bridge_ctx);
+        bridge_update_events(mxt, server, bridge_ctx);
       }
+
+      if (bridge_ctx->failed)
+        bridge_remove_client(mxt, server, bridge_ctx);
     }
   }
 
-disconnect:
+  for (i = 0; i < BRIDGE_MAX_CLIENTS; i++) {
+    if (server->clients[i])
+      bridge_remove_client(mxt, server, server->clients[i]);
+  }
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Initialise bridge server state
+/// \return #mxt_rc
+static int bridge_server_init(struct mxt_device *mxt,
+                              struct bridge_server *server, int listenfd)
+{
+  struct epoll_event ev;
+
+  memset(server, 0, sizeof(struct bridge_server));
+  server->listenfd = listenfd;
+  server->msg_fd = -1;
+  bridge_stats_init(&server->stats);
+
+  server->epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (server->epfd < 0) {
+    mxt_err(mxt->ctx, "epoll_create error: %s (%d)", strerror(errno), errno);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  if (listenfd >= 0) {
+    ev.events = EPOLLIN;
+    ev.data.u32 = BRIDGE_EV_LISTEN;
+    if (epoll_ctl(server->epfd, EPOLL_CTL_ADD, listenfd, &ev) < 0) {
+      mxt_err(mxt->ctx, "epoll_ctl error: %s (%d)", strerror(errno), errno);
+      close(server->epfd);
+      return MXT_ERROR_CONNECTION_FAILURE;
+    }
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Serve the single connection made by bridge client
+/// \return #mxt_rc
+static int bridge_run_client(struct mxt_device *mxt, int sockfd)
+{
+  struct bridge_server bridge_server;
+  int ret;
+
+  ret = bridge_server_init(mxt, &bridge_server, -1);
+  if (ret) {
+    close(sockfd);
+    return ret;
+  }
+
+  ret = bridge_add_client(mxt, &bridge_server, sockfd);
+  if (ret == MXT_SUCCESS)
+    ret = bridge(mxt, &bridge_server);
+
+  close(bridge_server.epfd);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Serve connections to listening socket until interrupted
+/// \return #mxt_rc
+static int bridge_run_server(struct mxt_device *mxt, int serversock)
+{
+  struct bridge_server bridge_server;
+  int ret;
+
+  /* Start listening */
+  ret = listen(serversock, BRIDGE_MAX_CLIENTS);
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "Listen error: %s (%d)", strerror(errno), errno);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  ret = bridge_server_init(mxt, &bridge_server, serversock);
+  if (ret)
+    return ret;
 
-  send_chip_detach(mxt, bridge_ctx);
-  mxt_info(mxt->ctx, "Disconnected");
+  /* This string is used by ADB bridge client to signal it can connect */
+  printf("AWAITING_CONNECTION\n");
+  fflush(stdout);
+
+  ret = bridge(mxt, &bridge_server);
+
+  close(bridge_server.epfd);
   return ret;
 }
 
+//******************************************************************************
+/// \brief Fill in unix domain socket address
+/// \return #mxt_rc
+static int bridge_unix_addr(struct mxt_device *mxt, const char *path,
+                            struct sockaddr_un *addr)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+
+  if (path[0] == '\0' || strlen(path) >= sizeof(addr->sun_path)) {
+    mxt_err(mxt->ctx, "Invalid socket path \"%s\"", path);
+    return MXT_ERROR_BAD_INPUT;
+  }
+
+  strcpy(addr->sun_path, path);
+  return MXT_SUCCESS;
+}
+
 //******************************************************************************
 /// \brief Bridge client
+
 /// \return #mxt_rc
 int mxt_socket_client(struct mxt_device *mxt, char *ip_address, uint16_t port)
 {
   struct hostent *server;
-  struct bridge_context bridge_ctx;
-  bridge_ctx.msgs_enabled = false;
+  int sockfd;
   int ret;
   struct sockaddr_in serv_addr;
 
@@ -614,8 +2299,8 @@ int mxt_socket_client(struct mxt_device *mxt, char *ip_address, uint16_t port)
     return MXT_ERROR_CONNECTION_FAILURE;
   }
 
-  bridge_ctx.sockfd = socket(AF_INET, SOCK_STREAM, 0);
-  if (bridge_ctx.sockfd < 0) {
+  sockfd = socket(AF_INET, SOCK_STREAM, 0);
+  if (sockfd < 0) {
     mxt_err(mxt->ctx, "Socket error: %s (%d)", strerror(errno), errno);
     return MXT_ERROR_CONNECTION_FAILURE;
   }
@@ -630,29 +2315,58 @@ int mxt_socket_client(struct mxt_device *mxt, char *ip_address, uint16_t port)
 
   /* Connect */
   mxt_info(mxt->ctx, "Connecting to %s:%u", ip_address, port);
-  ret = connect(bridge_ctx.sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr));
+  ret = connect(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr));
   if (ret < 0) {
     mxt_err(mxt->ctx, "Connect error: %s (%d)", strerror(errno), errno);
+    close(sockfd);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  return bridge_run_client(mxt, sockfd);
+}
+
+//******************************************************************************
+/// \brief Bridge client over unix domain socket
+
+/// \return #mxt_rc
+int mxt_socket_client_unix(struct mxt_device *mxt, const char *path)
+{
+  struct sockaddr_un serv_addr;
+  int sockfd;
+  int ret;
+
+  ret = bridge_unix_addr(mxt, path, &serv_addr);
+  if (ret)
+    return ret;
+
+  sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sockfd < 0) {
+    mxt_err(mxt->ctx, "Socket error: %s (%d)", strerror(errno), errno);
     return MXT_ERROR_CONNECTION_FAILURE;
   }
 
-  ret = bridge(mxt, &bridge_ctx);
+  mxt_info(mxt->ctx, "Connecting to %s", path);
+  ret = connect(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr));
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "Connect error: %s (%d)", strerror(errno), errno);
+    close(sockfd);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
 
-  close(bridge_ctx.sockfd);
-  return ret;
+  return bridge_run_client(mxt, sockfd);
 }
 
 //******************************************************************************
 /// \brief Bridge server
+///
+/// Serves up to BRIDGE_MAX_CLIENTS connections at once and keeps running as
+/// clients come and go.
 int mxt_socket_server(struct mxt_device *mxt, uint16_t portno)
 {
   int serversock;
-  struct bridge_context bridge_ctx;
-  bridge_ctx.msgs_enabled = false;
   int ret;
   int one = 1;
-  struct sockaddr_in server_addr, client_addr;
-  socklen_t sin_size = sizeof(client_addr);
+  struct sockaddr_in server_addr;
 
   /* Create endpoint */
   serversock = socket(AF_INET, SOCK_STREAM, 0);
@@ -667,6 +2381,13 @@ int mxt_socket_server(struct mxt_device *mxt, uint16_t portno)
   server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
   server_addr.sin_port = htons(portno);
 
+  ret = setsockopt(serversock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "Setsockopt error: %s (%d)", strerror(errno), errno);
+    close(serversock);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
   /* Bind name to socket */
   ret = bind(serversock, (struct sockaddr *) &server_addr, sizeof(server_addr));
   if (ret < 0) {
@@ -675,6 +2396,7 @@ int mxt_socket_server(struct mxt_device *mxt, uint16_t portno)
     return MXT_ERROR_CONNECTION_FAILURE;
   }
 
+  /* Accepted sockets inherit this */
   ret = setsockopt(serversock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
   if (ret < 0) {
     mxt_err(mxt->ctx, "Setsockopt error: %s (%d)", strerror(errno), errno);
@@ -682,30 +2404,72 @@ int mxt_socket_server(struct mxt_device *mxt, uint16_t portno)
     return MXT_ERROR_CONNECTION_FAILURE;
   }
 
-  /* Start listening */
-  ret = listen(serversock, 1);
-  if (ret < 0) {
-    mxt_err(mxt->ctx, "Listen error: %s (%d)", strerror(errno), errno);
-    close(serversock);
+  ret = bridge_run_server(mxt, serversock);
+
+  close(serversock);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Bridge server over unix domain socket
+///
+/// The socket file is given permissions mode, so access can be limited to a
+/// user or group. A stale socket left by a server which has exited is
+/// replaced, but not one which is still accepting connections.
+/// \return #mxt_rc
+int mxt_socket_server_unix(struct mxt_device *mxt, const char *path,
+                           unsigned int mode)
+{
+  struct sockaddr_un server_addr;
+  struct stat st;
+  int serversock;
+  int ret;
+
+  ret = bridge_unix_addr(mxt, path, &server_addr);
+  if (ret)
+    return ret;
+
+  serversock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (serversock < 0) {
+    mxt_err(mxt->ctx, "Socket error: %s (%d)", strerror(errno), errno);
     return MXT_ERROR_CONNECTION_FAILURE;
   }
 
-  /* This string is used by ADB bridge client to signal it can connect */
-  printf("AWAITING_CONNECTION\n");
-  bridge_ctx.sockfd = accept(serversock, (struct sockaddr *) &client_addr, &sin_size);
-  if (bridge_ctx.sockfd < 0) {
-    mxt_err(mxt->ctx, "Accept error: %s (%d)", strerror(errno), errno);
-    close(serversock);
-    return MXT_ERROR_CONNECTION_FAILURE;
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    ret = connect(serversock, (struct sockaddr *) &server_addr,
+                  sizeof(server_addr));
+    if (ret == 0 || errno != ECONNREFUSED) {
+      mxt_err(mxt->ctx, "Socket %s is in use", path);
+      ret = MXT_ERROR_CONNECTION_FAILURE;
+      goto close;
+    }
+
+    mxt_dbg(mxt->ctx, "Removing stale socket %s", path);
+    unlink(path);
   }
 
-  printf("CONNECTED\n");
+  /* Bind name to socket */
+  ret = bind(serversock, (struct sockaddr *) &server_addr, sizeof(server_addr));
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "Bind error: %s (%d)", strerror(errno), errno);
+    ret = MXT_ERROR_CONNECTION_FAILURE;
+    goto close;
+  }
 
-  ret = bridge(mxt, &bridge_ctx);
+  ret = chmod(path, mode);
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "chmod error: %s (%d)", strerror(errno), errno);
+    ret = mxt_errno_to_rc(errno);
+    goto unlink;
+  }
 
-  close(serversock);
+  mxt_info(mxt->ctx, "Listening on %s mode %04o", path, mode);
 
-  printf("DISCONNECTED\n");
+  ret = bridge_run_server(mxt, serversock);
 
+unlink:
+  unlink(path);
+close:
+  close(serversock);
   return ret;
 }
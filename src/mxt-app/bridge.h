@@ -0,0 +1,187 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   bridge.h
+/// \brief  TCP bridge protocol definitions
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+struct mxt_device;
+
+/* Bridge address prefix selecting a unix domain socket path */
+#define BRIDGE_UNIX_PREFIX       "unix:"
+
+/* Default permissions of unix domain socket */
+#define BRIDGE_UNIX_MODE         0660
+
+/* Switch connection from ASCII lines to binary frames */
+#define BRIDGE_BINARY_CMD        "BIN"
+#define BRIDGE_BINARY_OK         "BIN OK"
+
+/* Opt in to tagged ASCII requests and merging of adjacent reads */
+#define BRIDGE_PIPE_CMD          "PIPE"
+#define BRIDGE_PIPE_OK           "PIPE OK"
+
+/* Push diagnostic frames of a T6 mode given in hex, or stop doing so */
+#define BRIDGE_STREAM_CMD        "STREAM"
+#define BRIDGE_STREAM_STOP       "STREAM STOP"
+
+/* Enable message pushes with touch position updates coalesced */
+#define BRIDGE_MSGCFG_LATEST     "MSGCFG LATEST"
+
+/* Longest request tag, excluding the leading '#' */
+#define BRIDGE_TAG_MAX           16
+
+//******************************************************************************
+/// \brief Binary frame opcodes
+///
+/// Requests use the low opcodes, the matching reply sets bit 7. Pushes which
+/// are not a reply to any request start at 0xC0.
+enum bridge_opcode {
+  BRIDGE_OP_REA    = 0x01,    /*!< Read count bytes from address */
+  BRIDGE_OP_WRI    = 0x02,    /*!< Write payload to address */
+  BRIDGE_OP_RST    = 0x03,    /*!< Reset device */
+  BRIDGE_OP_MSGCFG = 0x04,    /*!< Enable message pushes, latest state
+                                   only if address is 1 */
+  BRIDGE_OP_ASCII  = 0x05,    /*!< Return to ASCII protocol */
+  BRIDGE_OP_STREAM = 0x06,    /*!< Push frames of mode in address, 0 stops */
+
+  BRIDGE_OP_RRP    = 0x81,    /*!< Read reply, payload is register data */
+  BRIDGE_OP_WRP    = 0x82,    /*!< Write reply */
+  BRIDGE_OP_RSTRP  = 0x83,    /*!< Reset reply */
+  BRIDGE_OP_MSGRP  = 0x84,    /*!< Message configuration reply */
+  BRIDGE_OP_ASCIIRP = 0x85,   /*!< ASCII reply, last binary frame sent */
+  BRIDGE_OP_STREAMRP = 0x86,  /*!< Stream reply */
+
+  BRIDGE_OP_MSG    = 0xC0,    /*!< Batch of messages */
+  BRIDGE_OP_CDT    = 0xC1,    /*!< Chip detach */
+  BRIDGE_OP_FRM    = 0xC2,    /*!< Diagnostic frame */
+};
+
+/* Reply status */
+#define BRIDGE_STATUS_OK         0x00
+#define BRIDGE_STATUS_ERR        0x01
+#define BRIDGE_STATUS_UNKNOWN    0x02
+
+//******************************************************************************
+/// \brief Binary frame header
+///
+/// All fields are little endian. The header is followed by length bytes of
+/// payload. For BRIDGE_OP_MSG, count gives the number of messages and each
+/// message in the payload is preceded by its length in a single byte. For
+/// BRIDGE_OP_FRM, seq is the frame number, address the mode and count the
+/// number of 16 bit values, which follow the X and Y size in the payload.
+struct bridge_frame_hdr {
+  uint16_t length;    /*!< Payload length in bytes */
+  uint8_t opcode;     /*!< #bridge_opcode */
+  uint8_t status;     /*!< Reply status, zero in requests */
+  uint16_t seq;       /*!< Sequence number, echoed in reply */
+  uint16_t address;   /*!< Register address */
+  uint16_t count;     /*!< Bytes to read, or number of messages */
+} __attribute__((packed));
+
+#define BRIDGE_FRAME_HDR_LEN     sizeof(struct bridge_frame_hdr)
+#define BRIDGE_FRAME_MAX_PAYLOAD 0xFFFF
+
+/* Longest accepted ASCII command line, excluding terminator */
+#define BRIDGE_MAX_LINESIZE      10000
+
+/* Receive buffer holds at least one complete binary frame */
+#define BRIDGE_RXBUF_SIZE        (BRIDGE_FRAME_HDR_LEN + BRIDGE_FRAME_MAX_PAYLOAD)
+
+//******************************************************************************
+/// \brief Per-connection receive buffer
+///
+/// Filled by recv() calls of up to the free space in the buffer, commands and
+/// frames are then extracted without further system calls. Data between start
+/// and end has been received but not yet consumed.
+struct bridge_rxbuf {
+  int fd;             /*!< Socket to receive from */
+  uint8_t *data;      /*!< Buffer of BRIDGE_RXBUF_SIZE bytes */
+  size_t start;       /*!< Offset of first unconsumed byte, may be saved
+                           and restored to look ahead until the next fill */
+  size_t end;         /*!< Offset after last received byte */
+  bool discard;       /*!< Dropping the rest of an over-long line */
+};
+
+int bridge_rx_init(struct bridge_rxbuf *rx, int fd);
+void bridge_rx_free(struct bridge_rxbuf *rx);
+int bridge_rx_fill(struct mxt_device *mxt, struct bridge_rxbuf *rx);
+int bridge_rx_getline(struct mxt_device *mxt, struct bridge_rxbuf *rx,
+                      char **line);
+int bridge_rx_getframe(struct mxt_device *mxt, struct bridge_rxbuf *rx,
+                       struct bridge_frame_hdr *hdr, uint8_t **payload);
+
+//******************************************************************************
+/// \brief Per-connection transmit buffer
+///
+/// Output is sent straight away where the socket accepts it, anything left
+/// over is queued here until the socket becomes writable again.
+struct bridge_txbuf {
+  int fd;             /*!< Socket to send to */
+  uint8_t *data;      /*!< Queued output, grown as required */
+  size_t start;       /*!< Offset of first unsent byte */
+  size_t end;         /*!< Offset after last queued byte */
+  size_t capacity;    /*!< Allocated size of data */
+};
+
+void bridge_tx_init(struct bridge_txbuf *tx, int fd);
+void bridge_tx_free(struct bridge_txbuf *tx);
+int bridge_tx_writev(struct mxt_device *mxt, struct bridge_txbuf *tx,
+                     const struct iovec *iov, int iovcnt);
+int bridge_tx_flush(struct mxt_device *mxt, struct bridge_txbuf *tx);
+size_t bridge_tx_pending(const struct bridge_txbuf *tx);
+
+/* Maximum size of a single T5 message */
+#define BRIDGE_MSG_MAX           20
+
+/* Messages held for a latest state client before further ones are dropped */
+#define BRIDGE_MSGQ_MAX_MSGS     256
+
+//******************************************************************************
+/// \brief Messages held for a client in latest state mode
+///
+/// Messages wait here while earlier output to the client is still queued.
+/// A touch position update replaces the previous one for the same report ID
+/// if nothing else for that report ID has been queued since, so a slow
+/// client receives the newest position of each touch rather than a backlog.
+/// Data is in the BRIDGE_OP_MSG payload format.
+struct bridge_msgq {
+  uint8_t data[BRIDGE_MSGQ_MAX_MSGS * (BRIDGE_MSG_MAX + 1)];
+  uint16_t offset[BRIDGE_MSGQ_MAX_MSGS]; /*!< Offset of each length byte */
+  bool position[BRIDGE_MSGQ_MAX_MSGS];   /*!< Message may be replaced */
+  size_t length;             /*!< Bytes of data in use */
+  uint16_t count;            /*!< Number of messages held */
+  unsigned long merged;      /*!< Position updates replaced by newer ones */
+};
+
+void bridge_msgq_clear(struct bridge_msgq *q);
+int bridge_msgq_add(struct bridge_msgq *q, const uint8_t *msg, uint8_t len,
+                    bool position);
@@ -0,0 +1,233 @@
+//------------------------------------------------------------------------------
+/// \file   bridge_stats.c
+/// \brief  Bridge latency and throughput statistics
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/log.h"
+#include "bridge_stats.h"
+
+static const char * const bridge_stat_names[BRIDGE_STAT_CMDS] = {
+  "REA", "WRI", "RST", "MSGCFG"
+};
+
+//******************************************************************************
+/// \brief Clear statistics and start the clock
+void bridge_stats_init(struct bridge_stats *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  stats->start_us = mxt_stats_now_us();
+  stats->report_us = stats->start_us;
+}
+
+//******************************************************************************
+/// \brief Record device and socket time of one request
+void bridge_stats_record(struct bridge_stats *stats, enum bridge_stat_cmd cmd,
+                         uint64_t device_us, uint64_t socket_us)
+{
+  if (cmd >= BRIDGE_STAT_CMDS)
+    return;
+
+  mxt_stats_add(&stats->device[cmd], device_us);
+  mxt_stats_add(&stats->socket[cmd], socket_us);
+}
+
+//******************************************************************************
+/// \brief Total requests recorded
+static unsigned long bridge_stats_requests(const struct bridge_stats *stats)
+{
+  unsigned long requests = 0;
+  int i;
+
+  for (i = 0; i < BRIDGE_STAT_CMDS; i++)
+    requests += stats->device[i].count;
+
+  return requests;
+}
+
+//******************************************************************************
+/// \brief Append "avg/p50/p99/max" summary of histogram
+static int bridge_hist_summary(char *buf, size_t len,
+                               const struct mxt_stats_histogram *hist)
+{
+  return snprintf(buf, len, "%llu/%llu/%llu/%llu",
+                  (unsigned long long)(hist->total_us / hist->count),
+                  (unsigned long long)mxt_stats_percentile(hist, 50),
+                  (unsigned long long)mxt_stats_percentile(hist, 99),
+                  (unsigned long long)hist->max_us);
+}
+
+//******************************************************************************
+/// \brief Append bucket counts up to the last one in use
+static int bridge_hist_buckets(char *buf, size_t len,
+                               const struct mxt_stats_histogram *hist)
+{
+  int last = MXT_STATS_BUCKETS - 1;
+  int pos = 0;
+  int i;
+
+  while (last > 0 && hist->buckets[last] == 0)
+    last--;
+
+  for (i = 0; i <= last && (size_t)pos < len; i++)
+    pos += snprintf(buf + pos, len - pos, "%s%lu", i ? "," : "",
+                    hist->buckets[i]);
+
+  return pos;
+}
+
+//******************************************************************************
+/// \brief Format statistics as one line, without terminator
+///
+/// Totals are followed by, for each command, its count and device and socket
+/// times as avg/p50/p99/max in microseconds and as histogram bucket counts.
+/// \return length of output, which is truncated if longer than len - 1, or
+///         zero if len is zero
+size_t bridge_stats_format(const struct bridge_stats *stats, uint64_t now_us,
+                           char *buf, size_t len)
+{
+  const struct mxt_stats_histogram *dev;
+  const struct mxt_stats_histogram *sock;
+  double uptime = (now_us - stats->start_us) / 1000000.0;
+  size_t pos;
+  int i;
+
+  pos = snprintf(buf, len, "uptime=%.3f in=%llu out=%llu msgs=%llu "
+                 "msg_rate=%.1f merged=%llu", uptime,
+                 (unsigned long long)stats->bytes_in,
+                 (unsigned long long)stats->bytes_out,
+                 (unsigned long long)stats->msgs_pushed,
+                 (uptime > 0) ? stats->msgs_pushed / uptime : 0.0,
+                 (unsigned long long)stats->msgs_merged);
+
+  for (i = 0; i < BRIDGE_STAT_CMDS && pos < len; i++) {
+    dev = &stats->device[i];
+    sock = &stats->socket[i];
+
+    pos += snprintf(buf + pos, len - pos, " %s n=%lu",
+                    bridge_stat_names[i], dev->count);
+    if (dev->count == 0 || pos >= len)
+      continue;
+
+    pos += snprintf(buf + pos, len - pos, " dev=");
+    if (pos < len)
+      pos += bridge_hist_summary(buf + pos, len - pos, dev);
+    if (pos < len)
+      pos += snprintf(buf + pos, len - pos, " sock=");
+    if (pos < len)
+      pos += bridge_hist_summary(buf + pos, len - pos, sock);
+    if (pos < len)
+      pos += snprintf(buf + pos, len - pos, " dev_hist=");
+    if (pos < len)
+      pos += bridge_hist_buckets(buf + pos, len - pos, dev);
+    if (pos < len)
+      pos += snprintf(buf + pos, len - pos, " sock_hist=");
+    if (pos < len)
+      pos += bridge_hist_buckets(buf + pos, len - pos, sock);
+  }
+
+  if (pos < len)
+    return pos;
+
+  return (len > 0) ? len - 1 : 0;
+}
+
+//******************************************************************************
+/// \brief Whether anything has happened since the last report
+static bool bridge_stats_changed(const struct bridge_stats *stats)
+{
+  return stats->bytes_in != stats->report_bytes_in
+         || stats->bytes_out != stats->report_bytes_out
+         || stats->msgs_pushed != stats->report_msgs
+         || bridge_stats_requests(stats) != stats->report_requests;
+}
+
+//******************************************************************************
+/// \brief Time until next report is due
+/// \return milliseconds, or -1 if there is nothing new to report
+int bridge_stats_timeout(const struct bridge_stats *stats, uint64_t now_us)
+{
+  uint64_t elapsed_ms = (now_us - stats->report_us) / 1000;
+
+  if (!bridge_stats_changed(stats))
+    return -1;
+
+  if (elapsed_ms >= BRIDGE_STATS_INTERVAL_MS)
+    return 0;
+
+  return BRIDGE_STATS_INTERVAL_MS - elapsed_ms;
+}
+
+//******************************************************************************
+/// \brief Log rates over the last interval and latency so far, if due
+void bridge_stats_report(struct libmaxtouch_ctx *ctx,
+                         struct bridge_stats *stats, uint64_t now_us)
+{
+  const struct mxt_stats_histogram *dev;
+  const struct mxt_stats_histogram *sock;
+  double interval;
+  int i;
+
+  if (bridge_stats_timeout(stats, now_us) != 0)
+    return;
+
+  interval = (now_us - stats->report_us) / 1000000.0;
+
+  mxt_log_cond(ctx, LOG_DEBUG, "Bridge: in %.1f KiB/s, out %.1f KiB/s, "
+               "%.1f messages/s",
+               (stats->bytes_in - stats->report_bytes_in) / 1024.0 / interval,
+               (stats->bytes_out - stats->report_bytes_out) / 1024.0 / interval,
+               (stats->msgs_pushed - stats->report_msgs) / interval);
+
+  for (i = 0; i < BRIDGE_STAT_CMDS; i++) {
+    dev = &stats->device[i];
+    sock = &stats->socket[i];
+    if (dev->count == 0)
+      continue;
+
+    mxt_log_cond(ctx, LOG_DEBUG, "Bridge: %s %lu requests, device us "
+                 "avg %llu p99 %llu max %llu, socket us avg %llu p99 %llu "
+                 "max %llu", bridge_stat_names[i], dev->count,
+                 (unsigned long long)(dev->total_us / dev->count),
+                 (unsigned long long)mxt_stats_percentile(dev, 99),
+                 (unsigned long long)dev->max_us,
+                 (unsigned long long)(sock->total_us / sock->count),
+                 (unsigned long long)mxt_stats_percentile(sock, 99),
+                 (unsigned long long)sock->max_us);
+  }
+
+  stats->report_us = now_us;
+  stats->report_bytes_in = stats->bytes_in;
+  stats->report_bytes_out = stats->bytes_out;
+  stats->report_msgs = stats->msgs_pushed;
+  stats->report_requests = bridge_stats_requests(stats);
+}
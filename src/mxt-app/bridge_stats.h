@@ -0,0 +1,79 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   bridge_stats.h
+/// \brief  Bridge latency and throughput statistics
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "libmaxtouch/stats.h"
+
+struct libmaxtouch_ctx;
+
+/* Interval between statistics reports at debug log level */
+#define BRIDGE_STATS_INTERVAL_MS 10000
+
+//******************************************************************************
+/// \brief Commands for which latency is recorded
+enum bridge_stat_cmd {
+  BRIDGE_STAT_REA,
+  BRIDGE_STAT_WRI,
+  BRIDGE_STAT_RST,
+  BRIDGE_STAT_MSGCFG,
+  BRIDGE_STAT_CMDS,
+  BRIDGE_STAT_NONE = BRIDGE_STAT_CMDS
+};
+
+//******************************************************************************
+/// \brief Bridge server statistics
+///
+/// Device time runs from receiving a request to sending its reply, socket
+/// time is that spent sending the reply.
+struct bridge_stats {
+  struct mxt_stats_histogram device[BRIDGE_STAT_CMDS];
+  struct mxt_stats_histogram socket[BRIDGE_STAT_CMDS];
+  uint64_t bytes_in;
+  uint64_t bytes_out;
+  uint64_t msgs_pushed;
+  uint64_t msgs_merged;         /*!< Position updates coalesced */
+  uint64_t start_us;
+  uint64_t report_us;           /*!< Time of last report */
+  uint64_t report_bytes_in;     /*!< Totals at last report */
+  uint64_t report_bytes_out;
+  uint64_t report_msgs;
+  unsigned long report_requests;
+};
+
+void bridge_stats_init(struct bridge_stats *stats);
+void bridge_stats_record(struct bridge_stats *stats, enum bridge_stat_cmd cmd,
+                         uint64_t device_us, uint64_t socket_us);
+size_t bridge_stats_format(const struct bridge_stats *stats, uint64_t now_us,
+                           char *buf, size_t len);
+int bridge_stats_timeout(const struct bridge_stats *stats, uint64_t now_us);
+void bridge_stats_report(struct libmaxtouch_ctx *ctx,
+                         struct bridge_stats *stats, uint64_t now_us);
@@ -247,11 +247,16 @@ int mxt_broken_line(struct mxt_device *mxt, struct broken_line_options *bl_opts)
   frame.lc = mxt->ctx;
   frame.mode = REFS_MODE;
 
+  /* Lines are indexed in matrix coordinates, which V4L2 frames are not */
+  ret = mxt_frame_set_v4l2_node(mxt, NULL);
+  if (ret)
+    return ret;
+
   ret = mxt_debug_dump_initialise(&frame);
   if (ret)
     return ret;
 
-  ret = mxt_read_diagnostic_data_frame(&frame);
+  ret = mxt_read_diagnostic_frame(&frame);
   if (ret)
     goto free;
 
@@ -273,10 +278,7 @@ int mxt_broken_line(struct mxt_device *mxt, struct broken_line_options *bl_opts)
 free:
   free(mxt_ts_info);
   mxt_ts_info = NULL;
-  free(frame.data_buf);
-  frame.data_buf = NULL;
-  free(frame.t37_buf);
-  frame.t37_buf = NULL;
+  mxt_debug_dump_free(&frame);
 
   return ret;
 }
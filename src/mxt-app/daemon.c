@@ -0,0 +1,613 @@
+//------------------------------------------------------------------------------
+/// \file   daemon.c
+/// \brief  Resident daemon serving mxt-app commands over a unix socket
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/log.h"
+#include "libmaxtouch/utilfuncs.h"
+
+#include "mxt_app.h"
+#include "daemon.h"
+
+/* A client which connects but sends nothing is dropped after this time */
+#define DAEMON_RECV_TIMEOUT_S    2
+
+//******************************************************************************
+/// \brief Whether a command can be forwarded to the daemon
+bool mxt_daemon_cmd_supported(int cmd)
+{
+  switch (cmd) {
+  case CMD_READ:
+  case CMD_WRITE:
+  case CMD_INFO:
+  case CMD_RESET:
+  case CMD_CALIBRATE:
+  case CMD_BACKUP:
+  case CMD_CRC_CHECK:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+//******************************************************************************
+/// \brief Get the daemon socket path: $MXT_APP_DAEMON, else mxt-app.sock in
+///        $XDG_RUNTIME_DIR
+/// \return #mxt_rc, MXT_ERROR_NOENT if neither is set
+int mxt_daemon_socket_path(char *buf, size_t buflen)
+{
+  const char *env = getenv(DAEMON_SOCKET_ENV);
+  const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+  int len;
+
+  if (env && env[0])
+    len = snprintf(buf, buflen, "%s", env);
+  else if (runtime_dir && runtime_dir[0])
+    len = snprintf(buf, buflen, "%s/" DAEMON_SOCKET_NAME ".sock", runtime_dir);
+  else
+    return MXT_ERROR_NOENT;
+
+  if (len < 0 || (size_t)len >= buflen)
+    return MXT_ERROR_BAD_INPUT;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Whether a file owner can be trusted: ourselves or root
+static bool daemon_trusted_uid(uid_t uid)
+{
+  return uid == geteuid() || uid == 0;
+}
+
+//******************************************************************************
+/// \brief Check a socket can only have been created by a trusted daemon
+///
+/// The socket must be owned by us or root, in a directory also owned by us
+/// or root which nobody else may write to, such as $XDG_RUNTIME_DIR. Then no
+/// other user can have put it there.
+/// \return #mxt_rc
+int daemon_check_socket(const char *path)
+{
+  char dir[PATH_MAX];
+  char *slash;
+  struct stat st;
+
+  if (lstat(path, &st) < 0)
+    return MXT_ERROR_NO_DEVICE;
+
+  if (!S_ISSOCK(st.st_mode) || !daemon_trusted_uid(st.st_uid))
+    return MXT_ERROR_ACCESS;
+
+  if (strlen(path) >= sizeof(dir))
+    return MXT_ERROR_BAD_INPUT;
+
+  strcpy(dir, path);
+  slash = strrchr(dir, '/');
+  if (!slash)
+    strcpy(dir, ".");
+  else if (slash == dir)
+    dir[1] = '\0';
+  else
+    *slash = '\0';
+
+  if (lstat(dir, &st) < 0)
+    return MXT_ERROR_NO_DEVICE;
+
+  if (!S_ISDIR(st.st_mode) || !daemon_trusted_uid(st.st_uid)
+      || (st.st_mode & (S_IWGRP | S_IWOTH)))
+    return MXT_ERROR_ACCESS;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Check the process at the other end of a connected socket
+///
+/// Our own user and root are always accepted. Other users are accepted only
+/// when the socket permissions mode lets them in: any user for world
+/// writable, or users whose group is ours for group writable.
+/// \return #mxt_rc
+int daemon_check_peer(int sockfd, unsigned int mode)
+{
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+
+  if (getsockopt(sockfd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0
+      || len != sizeof(cred))
+    return MXT_ERROR_ACCESS;
+
+  if (daemon_trusted_uid(cred.uid)
+      || (mode & S_IWOTH)
+      || ((mode & S_IWGRP) && cred.gid == getegid()))
+    return MXT_SUCCESS;
+
+  return MXT_ERROR_ACCESS;
+}
+
+//******************************************************************************
+/// \brief Fill in unix domain socket address
+/// \return #mxt_rc
+static int daemon_unix_addr(const char *path, struct sockaddr_un *addr)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+
+  if (path[0] == '\0' || strlen(path) >= sizeof(addr->sun_path))
+    return MXT_ERROR_BAD_INPUT;
+
+  strcpy(addr->sun_path, path);
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Signal handler stopping the daemon
+static void daemon_signal_handler(int signal_num)
+{
+  mxt_sigint_rx = 1;
+}
+
+//******************************************************************************
+/// \brief Run a forwarded command against the open device
+/// \return #mxt_rc
+static int daemon_run(struct mxt_device *mxt, struct daemon_request *req)
+{
+  char *argv[DAEMON_ARGS_MAX];
+  char *arg = req->args;
+  int argc;
+
+  switch (req->cmd) {
+  case CMD_READ:
+    return mxt_read_object(mxt, req->object_type, req->instance,
+                           req->address, req->count, req->format);
+
+  case CMD_WRITE:
+    for (argc = 0; argc < req->argc; argc++) {
+      argv[argc] = arg;
+      arg += strlen(arg) + 1;
+    }
+
+    /* mxt_handle_write_cmd() takes values from optind onwards */
+    optind = 0;
+    return mxt_handle_write_cmd(mxt, req->object_type, req->count,
+                                req->instance, req->address, argc, argv);
+
+  case CMD_INFO:
+    mxt_print_info_block(mxt);
+    return MXT_SUCCESS;
+
+  case CMD_RESET:
+    return mxt_reset_chip(mxt, false);
+
+  case CMD_CALIBRATE:
+    return mxt_calibrate_chip(mxt);
+
+  case CMD_BACKUP:
+    return mxt_backup_config(mxt, req->backup_cmd);
+
+  case CMD_CRC_CHECK:
+    return mxt_checkcrc(mxt->ctx, mxt, req->filename);
+
+  default:
+    return MXT_ERROR_BAD_INPUT;
+  }
+}
+
+//******************************************************************************
+/// \brief Check a request is complete before it is acted on
+/// \return #mxt_rc
+int daemon_check_request(struct daemon_request *req)
+{
+  size_t used = 0;
+  int i;
+
+  if (req->magic != DAEMON_MAGIC || !mxt_daemon_cmd_supported(req->cmd))
+    return MXT_ERROR_PROTOCOL_FAULT;
+
+  req->filename[sizeof(req->filename) - 1] = '\0';
+
+  /* Every argument must be terminated inside the buffer */
+  for (i = 0; i < req->argc; i++) {
+    if (used >= sizeof(req->args))
+      return MXT_ERROR_PROTOCOL_FAULT;
+
+    used += strnlen(req->args + used, sizeof(req->args) - used) + 1;
+    if (used > sizeof(req->args))
+      return MXT_ERROR_PROTOCOL_FAULT;
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Send a request with the stdout and stderr to use for its output
+/// \return #mxt_rc
+int daemon_send_request(int sockfd, struct daemon_request *req,
+                        const int fds[2])
+{
+  union {
+    char buf[CMSG_SPACE(2 * sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  struct msghdr msg = { 0 };
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+
+  memset(&control, 0, sizeof(control));
+
+  iov.iov_base = req;
+  iov.iov_len = sizeof(*req);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+  memcpy(CMSG_DATA(cmsg), fds, 2 * sizeof(int));
+
+  if (sendmsg(sockfd, &msg, MSG_NOSIGNAL) != sizeof(*req))
+    return MXT_ERROR_CONNECTION_FAILURE;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Receive and check one request with its stdout and stderr
+///
+/// On success the caller owns and must close the two descriptors. On failure
+/// any descriptors received are closed.
+/// \return #mxt_rc
+int daemon_recv_request(int sockfd, struct daemon_request *req, int fds[2])
+{
+  union {
+    char buf[CMSG_SPACE(2 * sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  struct msghdr msg = { 0 };
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  ssize_t len;
+
+  fds[0] = -1;
+  fds[1] = -1;
+
+  iov.iov_base = req;
+  iov.iov_len = sizeof(*req);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  len = recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+  if (len < 0)
+    return MXT_ERROR_CONNECTION_FAILURE;
+
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS
+        && cmsg->cmsg_len == CMSG_LEN(2 * sizeof(int)))
+      memcpy(fds, CMSG_DATA(cmsg), 2 * sizeof(int));
+  }
+
+  if (len != sizeof(*req) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))
+      || fds[0] < 0 || fds[1] < 0 || daemon_check_request(req)) {
+    if (fds[0] >= 0)
+      close(fds[0]);
+    if (fds[1] >= 0)
+      close(fds[1]);
+
+    fds[0] = -1;
+    fds[1] = -1;
+    return MXT_ERROR_PROTOCOL_FAULT;
+  }
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Receive one request, run it with output to the client's stdout and
+///        stderr, and send back the result
+static void daemon_serve(struct mxt_device *mxt, int clientfd,
+                         unsigned int mode)
+{
+  struct libmaxtouch_ctx *ctx = mxt->ctx;
+  struct daemon_request *req;
+  struct daemon_reply reply = { DAEMON_MAGIC, MXT_ERROR_PROTOCOL_FAULT };
+  struct timeval tv = { DAEMON_RECV_TIMEOUT_S, 0 };
+  enum mxt_log_level log_level;
+  int fds[2] = { -1, -1 };
+  int saved_out;
+  int saved_err;
+
+  if (daemon_check_peer(clientfd, mode)) {
+    mxt_warn(ctx, "Refusing client of another user");
+    reply.ret = MXT_ERROR_ACCESS;
+    goto send;
+  }
+
+  req = calloc(1, sizeof(*req));
+  if (!req) {
+    reply.ret = MXT_ERROR_NO_MEM;
+    goto send;
+  }
+
+  setsockopt(clientfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  if (daemon_recv_request(clientfd, req, fds)) {
+    mxt_warn(ctx, "Bad request from client");
+    goto free;
+  }
+
+  mxt_dbg(ctx, "Request cmd %d", req->cmd);
+
+  /* Output goes where the client's own output would have gone */
+  fflush(stdout);
+  fflush(stderr);
+  saved_out = dup(STDOUT_FILENO);
+  saved_err = dup(STDERR_FILENO);
+  if (saved_out < 0 || saved_err < 0) {
+    reply.ret = mxt_errno_to_rc(errno);
+    goto restore;
+  }
+
+  dup2(fds[0], STDOUT_FILENO);
+  dup2(fds[1], STDERR_FILENO);
+
+  log_level = ctx->log_level;
+  mxt_set_log_level(ctx, req->verbose);
+
+  reply.ret = daemon_run(mxt, req);
+
+  ctx->log_level = log_level;
+
+  fflush(stdout);
+  fflush(stderr);
+  dup2(saved_out, STDOUT_FILENO);
+  dup2(saved_err, STDERR_FILENO);
+
+restore:
+  if (saved_out >= 0)
+    close(saved_out);
+  if (saved_err >= 0)
+    close(saved_err);
+  close(fds[0]);
+  close(fds[1]);
+free:
+  free(req);
+send:
+  if (send(clientfd, &reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply))
+    mxt_dbg(ctx, "Client went away");
+}
+
+//******************************************************************************
+/// \brief Stay attached to the device, serving commands forwarded by other
+///        mxt-app processes until interrupted
+///
+/// Requests are served one at a time, so each has the device to itself. The
+/// socket file is given permissions mode, and clients of other users are
+/// refused unless mode lets them in. A stale socket left by a daemon which
+/// has exited is replaced, but not one which is still running.
+/// \return #mxt_rc
+int mxt_daemon(struct mxt_device *mxt, const char *path, unsigned int mode)
+{
+  struct sockaddr_un addr;
+  struct sigaction sa;
+  struct sigaction old_int;
+  struct sigaction old_term;
+  struct sigaction old_pipe;
+  struct stat st;
+  int serversock;
+  int clientfd;
+  int ret;
+
+  ret = daemon_unix_addr(path, &addr);
+  if (ret) {
+    mxt_err(mxt->ctx, "Invalid socket path \"%s\"", path);
+    return ret;
+  }
+
+  serversock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (serversock < 0) {
+    mxt_err(mxt->ctx, "Socket error: %s (%d)", strerror(errno), errno);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    ret = connect(serversock, (struct sockaddr *) &addr, sizeof(addr));
+    if (ret == 0 || errno != ECONNREFUSED) {
+      mxt_err(mxt->ctx, "Socket %s is in use", path);
+      ret = MXT_ERROR_CONNECTION_FAILURE;
+      goto close;
+    }
+
+    mxt_dbg(mxt->ctx, "Removing stale socket %s", path);
+    unlink(path);
+  }
+
+  ret = bind(serversock, (struct sockaddr *) &addr, sizeof(addr));
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "Bind error: %s (%d)", strerror(errno), errno);
+    ret = MXT_ERROR_CONNECTION_FAILURE;
+    goto close;
+  }
+
+  ret = chmod(path, mode);
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "chmod error: %s (%d)", strerror(errno), errno);
+    ret = mxt_errno_to_rc(errno);
+    goto unlink;
+  }
+
+  ret = listen(serversock, 8);
+  if (ret < 0) {
+    mxt_err(mxt->ctx, "Listen error: %s (%d)", strerror(errno), errno);
+    ret = MXT_ERROR_CONNECTION_FAILURE;
+    goto unlink;
+  }
+
+  /* No SA_RESTART, so that accept() returns on a signal */
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = daemon_signal_handler;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, &old_int);
+  sigaction(SIGTERM, &sa, &old_term);
+
+  /* A client's stdout may be a pipe which has been closed */
+  sa.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &sa, &old_pipe);
+
+  mxt_info(mxt->ctx, "Daemon listening on %s mode %04o", path, mode);
+
+  ret = MXT_SUCCESS;
+  while (!mxt_sigint_rx) {
+    clientfd = accept4(serversock, NULL, NULL, SOCK_CLOEXEC);
+    if (clientfd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+
+      mxt_err(mxt->ctx, "Accept error: %s (%d)", strerror(errno), errno);
+      ret = MXT_ERROR_CONNECTION_FAILURE;
+      break;
+    }
+
+    daemon_serve(mxt, clientfd, mode);
+    close(clientfd);
+  }
+
+  mxt_info(mxt->ctx, "Daemon stopping");
+
+  sigaction(SIGINT, &old_int, NULL);
+  sigaction(SIGTERM, &old_term, NULL);
+  sigaction(SIGPIPE, &old_pipe, NULL);
+  mxt_sigint_rx = 0;
+
+unlink:
+  unlink(path);
+close:
+  close(serversock);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Forward a command to a running daemon
+///
+/// Write values are taken from argv, starting at optind. A file name is
+/// made absolute since the daemon has its own working directory. Nothing is
+/// sent unless the socket is in a directory only we or root can write to and
+/// the daemon is running as us or root, so that another user cannot pose as
+/// the daemon to capture output or fake the result.
+/// \return MXT_SUCCESS with the command's result in cmd_ret, or
+///         MXT_ERROR_NO_DEVICE if no trusted daemon is running
+int mxt_daemon_client(struct daemon_request *req, int argc, char *argv[],
+                      int *cmd_ret)
+{
+  char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+  char abs_path[PATH_MAX];
+  struct sockaddr_un addr;
+  struct daemon_reply reply;
+  const int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+  size_t used = 0;
+  size_t len;
+  ssize_t rc;
+  int sockfd;
+  int i;
+
+  if (mxt_daemon_socket_path(path, sizeof(path))
+      || daemon_unix_addr(path, &addr))
+    return MXT_ERROR_NO_DEVICE;
+
+  if (daemon_check_socket(path))
+    return MXT_ERROR_NO_DEVICE;
+
+  req->magic = DAEMON_MAGIC;
+
+  req->argc = 0;
+  for (i = optind; i < argc; i++) {
+    len = strlen(argv[i]) + 1;
+    if (used + len > sizeof(req->args)) {
+      fprintf(stderr, "Too many values to forward to daemon\n");
+      return MXT_ERROR_BAD_INPUT;
+    }
+
+    memcpy(req->args + used, argv[i], len);
+    used += len;
+    req->argc++;
+  }
+
+  if (req->filename[0] && realpath(req->filename, abs_path)) {
+    strncpy(req->filename, abs_path, sizeof(req->filename) - 1);
+    req->filename[sizeof(req->filename) - 1] = '\0';
+  }
+
+  sockfd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (sockfd < 0)
+    return MXT_ERROR_NO_DEVICE;
+
+  /* No daemon, or one the user may not use or should not trust */
+  if (connect(sockfd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+      || daemon_check_peer(sockfd, 0)) {
+    close(sockfd);
+    return MXT_ERROR_NO_DEVICE;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+
+  if (daemon_send_request(sockfd, req, fds)) {
+    fprintf(stderr, "Error sending to daemon: %s (%d)\n", strerror(errno), errno);
+    close(sockfd);
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  rc = recv(sockfd, &reply, sizeof(reply), 0);
+  close(sockfd);
+
+  if (rc != sizeof(reply) || reply.magic != DAEMON_MAGIC) {
+    fprintf(stderr, "No reply from daemon\n");
+    return MXT_ERROR_CONNECTION_FAILURE;
+  }
+
+  *cmd_ret = reply.ret;
+  return MXT_SUCCESS;
+}
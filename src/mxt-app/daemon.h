@@ -0,0 +1,85 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   daemon.h
+/// \brief  Resident daemon serving mxt-app commands over a unix socket
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+
+struct mxt_device;
+
+/* Environment variable giving the daemon socket path */
+#define DAEMON_SOCKET_ENV        "MXT_APP_DAEMON"
+
+/* Socket file name in $XDG_RUNTIME_DIR */
+#define DAEMON_SOCKET_NAME       "mxt-app"
+
+/* Identifies requests and replies */
+#define DAEMON_MAGIC             0x4d585444
+
+/* Bytes of write values forwarded with a request */
+#define DAEMON_ARGS_MAX          4096
+
+//******************************************************************************
+/// \brief Command forwarded by mxt-app to a running daemon
+///
+/// Sent as one packet together with the client's stdout and stderr, which the
+/// daemon writes command output to.
+struct daemon_request {
+  uint32_t magic;
+  int32_t cmd;                    /* mxt_app_cmd */
+  uint16_t object_type;
+  uint16_t address;
+  uint16_t count;
+  uint8_t instance;
+  uint8_t format;
+  uint8_t verbose;
+  uint8_t backup_cmd;
+  uint16_t argc;                  /* Number of strings in args */
+  char filename[PATH_MAX];
+  char args[DAEMON_ARGS_MAX];     /* Write values, each NUL terminated */
+};
+
+//******************************************************************************
+/// \brief Result of a forwarded command
+struct daemon_reply {
+  uint32_t magic;
+  int32_t ret;                    /* #mxt_rc of the command */
+};
+
+bool mxt_daemon_cmd_supported(int cmd);
+int mxt_daemon_socket_path(char *buf, size_t buflen);
+int mxt_daemon(struct mxt_device *mxt, const char *path, unsigned int mode);
+int mxt_daemon_client(struct daemon_request *req, int argc, char *argv[], int *cmd_ret);
+int daemon_check_socket(const char *path);
+int daemon_check_peer(int sockfd, unsigned int mode);
+int daemon_check_request(struct daemon_request *req);
+int daemon_send_request(int sockfd, struct daemon_request *req, const int fds[2]);
+int daemon_recv_request(int sockfd, struct daemon_request *req, int fds[2]);
@@ -49,108 +49,6 @@
 
 #define MAX_FILENAME_LENGTH     255
 
-//******************************************************************************
-/// \brief T37 Diagnostic Data object
-struct t37_diagnostic_data {
-  uint8_t mode;
-  uint8_t page;
-  uint8_t data[];
-};
-
-//******************************************************************************
-/// \brief Retrieve and store object information for debug data operation
-/// \return #mxt_rc
-static int get_objects_addr(struct t37_ctx *ctx)
-{
-  int t6_addr;
-
-  /* Obtain command processor's address */
-  t6_addr = mxt_get_object_address(ctx->mxt, GEN_COMMANDPROCESSOR_T6, 0);
-  if (t6_addr == OBJECT_NOT_FOUND) return MXT_ERROR_OBJECT_NOT_FOUND;
-
-  /* T37 commands address */
-  ctx->diag_cmd_addr = t6_addr + MXT_T6_DIAGNOSTIC_OFFSET;
-
-  /* Obtain Debug Diagnostic object's address */
-  ctx->t37_addr = mxt_get_object_address(ctx->mxt, DEBUG_DIAGNOSTIC_T37, 0);
-  if (ctx->t37_addr == OBJECT_NOT_FOUND) return MXT_ERROR_OBJECT_NOT_FOUND;
-
-  /* Obtain Debug Diagnostic object's size */
-  ctx->t37_size = mxt_get_object_size(ctx->mxt, DEBUG_DIAGNOSTIC_T37);
-  if (ctx->t37_size == OBJECT_NOT_FOUND) return MXT_ERROR_OBJECT_NOT_FOUND;
-
-  ctx->t111_instances = mxt_get_object_instances(ctx->mxt,
-                        SPT_SELFCAPCONFIG_T111);
-
-  ctx->t107_instances = mxt_get_object_instances(ctx->mxt,
-                        PROCI_ACTIVESTYLUS_T107);
-
-  return MXT_SUCCESS;
-}
-
-//******************************************************************************
-/// \brief Retrieve a single page of diagnostic data
-/// \return #mxt_rc
-static int mxt_get_t37_page(struct t37_ctx *ctx)
-{
-  int failures;
-  int ret;
-  uint8_t read_command = 1;
-  uint8_t page_up_cmd = PAGE_UP;
-
-  if (ctx->pass == 0 && ctx->page == 0) {
-    mxt_dbg(ctx->lc, "Writing mode command %02X", ctx->mode);
-    ret = mxt_write_register(ctx->mxt, &ctx->mode, ctx->diag_cmd_addr, 1);
-    if (ret)
-      return ret;
-  } else {
-    ret = mxt_write_register(ctx->mxt, &page_up_cmd, ctx->diag_cmd_addr, 1);
-    if (ret)
-      return ret;
-  }
-
-  /* Read back diagnostic register in T6 command processor until it has been
-   * cleared. This means that the chip has actioned the command */
-  failures = 0;
-
-  while (read_command) {
-    usleep(500);
-    ret = mxt_read_register(ctx->mxt, &read_command, ctx->diag_cmd_addr, 1);
-    if (ret) {
-      mxt_err(ctx->lc, "Failed to read the status of diagnostic mode command");
-      return ret;
-    }
-
-    if (read_command) {
-      failures++;
-
-      if (failures > 500) {
-        mxt_err(ctx->lc, "Timeout waiting for command to be actioned");
-        return MXT_ERROR_TIMEOUT;
-      }
-    }
-  }
-
-  ret = mxt_read_register(ctx->mxt, (uint8_t *)ctx->t37_buf,
-                          ctx->t37_addr, ctx->t37_size);
-  if (ret) {
-    mxt_err(ctx->lc, "Failed to read page");
-    return ret;
-  }
-
-  if (ctx->t37_buf->mode != ctx->mode) {
-    mxt_err(ctx->lc, "Bad mode in diagnostic data read");
-    return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
-  }
-
-  if (ctx->t37_buf->page != (ctx->pages_per_pass * ctx->pass + ctx->page)) {
-    mxt_err(ctx->lc, "Bad page in diagnostic data read");
-    return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
-  }
-
-  return MXT_SUCCESS;
-}
-
 //******************************************************************************
 /// \brief Output header to CSV file
 /// \return #mxt_rc
@@ -283,71 +181,6 @@ static int mxt_generate_hawkeye_header(struct t37_ctx *ctx)
   return MXT_SUCCESS;
 }
 
-//******************************************************************************
-/// \brief Insert page of data into buffer at appropriate co-ordinates
-/// \return #mxt_rc
-static int mxt_debug_insert_data_self_cap(struct t37_ctx *ctx)
-{
-  int i;
-  int ofs;
-  int pass_ofs = (ctx->y_size + ctx->x_size) * ctx->pass;
-  uint16_t val;
-
-  for (i = 0; i < ctx->page_size; i += 2) {
-    int data_pos = ctx->page * ctx->page_size/2 + i/2;
-
-    if (data_pos > (ctx->data_values/ctx->passes))
-      return MXT_SUCCESS;
-
-    ofs = pass_ofs + data_pos;
-
-    if (ofs > ctx->data_values)
-      return MXT_INTERNAL_ERROR;
-
-    val = (ctx->t37_buf->data[i+1] << 8) | ctx->t37_buf->data[i];
-
-    ctx->data_buf[ofs] = val;
-  }
-
-  return MXT_SUCCESS;
-}
-
-//******************************************************************************
-/// \brief Insert page of data into buffer at appropriate co-ordinates
-/// \return #mxt_rc
-static int mxt_debug_insert_data(struct t37_ctx *ctx)
-{
-  int i;
-  uint16_t value;
-  int ofs;
-
-  for (i = 0; i < ctx->page_size; i += 2) {
-    if (ctx->x_ptr > ctx->x_size) {
-      mxt_err(ctx->lc, "x pointer overrun");
-      return MXT_INTERNAL_ERROR;
-    }
-
-    value = (ctx->t37_buf->data[i+1] << 8) | ctx->t37_buf->data[i];
-
-    ofs = ctx->y_ptr + ctx->x_ptr * ctx->y_size;
-
-    /* The last page may overlap the end of the matrix */
-    if (ofs >= ctx->data_values)
-      return MXT_SUCCESS;
-
-    ctx->data_buf[ofs] = value;
-
-    ctx->y_ptr++;
-
-    if (ctx->y_ptr > ctx->stripe_endy) {
-      ctx->y_ptr = ctx->stripe_starty;
-      ctx->x_ptr++;
-    }
-  }
-
-  return MXT_SUCCESS;
-}
-
 //******************************************************************************
 /// \brief Write data to file
 /// \return #mxt_rc
@@ -432,121 +265,24 @@ static int get_num_frames(uint16_t *frames)
 /// \return #mxt_rc
 int mxt_debug_dump_initialise(struct t37_ctx *ctx)
 {
-  struct mxt_id_info *id = ctx->mxt->info.id;
+  struct mxt_frame_layout layout;
   int ret;
 
-  ctx->active_stylus = false;
-
-  ret = get_objects_addr(ctx);
-  if (ret) {
-    mxt_err(ctx->lc, "Failed to get object information");
+  ret = mxt_frame_acquire_init(ctx->mxt, ctx->mode, &layout);
+  if (ret)
     return ret;
-  }
-
-  mxt_dbg(ctx->lc, "t37_size: %d", ctx->t37_size);
-  ctx->page_size = ctx->t37_size - 2;
-  mxt_dbg(ctx->lc, "page_size: %d", ctx->page_size);
-
-  switch (ctx->mode) {
-  case DELTAS_MODE:
-  case REFS_MODE:
-    ctx->self_cap = false;
-
-    if (id->family == 0xA0 && id->variant == 0x00) {
-      /* mXT1386 data is formatted into stripes */
-      ctx->x_size = 27;
-      ctx->y_size = id->matrix_y_size;
-      ctx->data_values = 27 * ctx->y_size;
-      ctx->passes = 3;
-      ctx->pages_per_pass = 8;
-    } else {
-      ctx->x_size = id->matrix_x_size;
-      ctx->y_size = id->matrix_y_size;
-      ctx->data_values = ctx->x_size * ctx->y_size;
-      ctx->passes = 1;
-      ctx->pages_per_pass = (ctx->data_values*2 + (ctx->page_size - 1)) /
-                            ctx->page_size;
-    }
 
-    ctx->stripe_width = ctx->y_size / ctx->passes;
-    mxt_dbg(ctx->lc, "stripe_width: %d", ctx->stripe_width);
-    break;
-
-  case SELF_CAP_SIGNALS:
-  case SELF_CAP_DELTAS:
-  case SELF_CAP_REFS:
-    ctx->self_cap = true;
-
-    if (id->family != 164) {
-      mxt_err(ctx->lc, "Self cap data not available");
-      return MXT_ERROR_NOT_SUPPORTED;
-    }
-
-    if (ctx->t111_instances == 0) {
-      mxt_err(ctx->lc, "T111 not found");
-      return MXT_ERROR_OBJECT_NOT_FOUND;
-    }
-
-    // Read Ymax Y values, plus Ymax or 2Ymax X values
-    ctx->passes = ctx->t111_instances;
-    ctx->y_size = id->matrix_y_size;
-    ctx->x_size = ctx->y_size * ((id->matrix_x_size > ctx->y_size) ? 2 : 1);
-    ctx->data_values = (ctx->y_size + ctx->x_size) * ctx->passes;
-    ctx->pages_per_pass = ((ctx->y_size + ctx->x_size)*sizeof(uint16_t) +(ctx->page_size - 1)) /
-                          ctx->page_size;
-
-    break;
-
-  case AST_DELTAS:
-  case AST_REFS:
-    ctx->self_cap = false;
-    ctx->active_stylus = true;
-
-    if (id->family != 164) {
-      mxt_err(ctx->lc, "active stylus data not available");
-      return MXT_ERROR_NOT_SUPPORTED;
-    }
-
-    if (ctx->t107_instances == 0) {
-      mxt_err(ctx->lc, "T107 not found");
-      return MXT_ERROR_OBJECT_NOT_FOUND;
-    }
-
-    // Read Ymax Y values, plus Ymax or 2Ymax X values
-    ctx->passes = ctx->t107_instances;
-    ctx->y_size = 2 * id->matrix_y_size;    // Two scans per axis
-    ctx->x_size = ctx->y_size * ((id->matrix_x_size > ctx->y_size) ? 2 : 1);
-    ctx->data_values = (ctx->y_size + ctx->x_size) * ctx->passes;
-    ctx->pages_per_pass = ((ctx->y_size + ctx->x_size)*sizeof(uint16_t) +(ctx->page_size - 1)) /
-                          ctx->page_size;
-    break;
-
-  default:
-    mxt_err(ctx->lc, "Unsupported mode %02X", ctx->mode);
-    return MXT_INTERNAL_ERROR;
-  }
-
-  mxt_dbg(ctx->lc, "passes: %d", ctx->passes);
-  mxt_dbg(ctx->lc, "pages_per_pass: %d", ctx->pages_per_pass);
-  mxt_dbg(ctx->lc, "x_size: %d", ctx->x_size);
-  mxt_dbg(ctx->lc, "y_size: %d", ctx->y_size);
-  mxt_dbg(ctx->lc, "data_values: %d", ctx->data_values);
-
-  /* allocate t37 buffers */
-  ctx->t37_buf = (struct t37_diagnostic_data *)calloc(1, ctx->t37_size);
-  if (!ctx->t37_buf) {
-    mxt_err(ctx->lc, "calloc failure");
-    return MXT_ERROR_NO_MEM;
-  }
+  ctx->self_cap = layout.self_cap;
+  ctx->active_stylus = layout.active_stylus;
+  ctx->x_size = layout.x_size;
+  ctx->y_size = layout.y_size;
+  ctx->passes = layout.passes;
+  ctx->data_values = layout.data_values;
 
   /* allocate data buffer */
   ctx->data_buf = (uint16_t *)calloc(ctx->data_values, sizeof(uint16_t));
   if (!ctx->data_buf) {
     mxt_err(ctx->lc, "calloc failure");
-
-    /* free other buffer in error path */
-    free(ctx->t37_buf);
-    ctx->t37_buf = NULL;
     return MXT_ERROR_NO_MEM;
   }
 
@@ -554,64 +290,21 @@ int mxt_debug_dump_initialise(struct t37_ctx *ctx)
 }
 
 //******************************************************************************
-/// \brief Read one frame of diagnostic data
-/// \return #mxt_rc
-int mxt_read_diagnostic_data_frame(struct t37_ctx* ctx)
-{
-  int ret;
-
-  /* iterate through stripes */
-  for (ctx->pass = 0; ctx->pass < ctx->passes; ctx->pass++) {
-    /* Calculate stripe parameters */
-    ctx->stripe_starty = ctx->stripe_width * ctx->pass;
-    ctx->stripe_endy = ctx->stripe_starty + ctx->stripe_width - 1;
-    ctx->x_ptr = 0;
-    ctx->y_ptr = ctx->stripe_starty;
-
-    for (ctx->page = 0; ctx->page < ctx->pages_per_pass; ctx->page++) {
-      mxt_dbg(ctx->lc, "Frame %d Pass %d Page %d", ctx->frame, ctx->pass,
-              ctx->page);
-
-      ret = mxt_get_t37_page(ctx);
-      if (ret)
-        return ret;
-
-      mxt_debug_insert_data(ctx);
-    }
-  }
-
-  return MXT_SUCCESS;
-}
-
-//******************************************************************************
-/// \brief Read one frame of diagnostic data
+/// \brief Read one frame of diagnostic data in the mode set at initialisation
 /// \return #mxt_rc
-static int mxt_read_diagnostic_data_self_cap(struct t37_ctx* ctx)
+int mxt_read_diagnostic_frame(struct t37_ctx *ctx)
 {
-  int ret;
+  mxt_dbg(ctx->lc, "Frame %d", ctx->frame);
 
-  for (ctx->pass = 0; ctx->pass < ctx->passes; ctx->pass++) {
-    for (ctx->page = 0; ctx->page < ctx->pages_per_pass; ctx->page++) {
-      mxt_dbg(ctx->lc, "Frame %d Pass %d Page %d", ctx->frame, ctx->pass,
-              ctx->page);
-
-      ret = mxt_get_t37_page(ctx);
-      if (ret)
-        return ret;
-
-      mxt_debug_insert_data_self_cap(ctx);
-    }
-  }
-
-  return MXT_SUCCESS;
+  return mxt_frame_acquire(ctx->mxt, ctx->mode, (int16_t *)ctx->data_buf);
 }
 
 //******************************************************************************
-/// \brief Read one frame of diagnostic data
-/// \return #mxt_rc
-static int mxt_read_diagnostic_data_ast(struct t37_ctx* ctx)
+/// \brief Free buffer allocated by mxt_debug_dump_initialise()
+void mxt_debug_dump_free(struct t37_ctx *ctx)
 {
-  return mxt_read_diagnostic_data_self_cap(ctx);
+  free(ctx->data_buf);
+  ctx->data_buf = NULL;
 }
 
 //******************************************************************************
@@ -655,13 +348,7 @@ int mxt_debug_dump(struct mxt_device *mxt, int mode, const char *csv_file,
   t1 = time(NULL);
 
   for (ctx.frame = 1; ctx.frame <= frames; ctx.frame++) {
-    if (ctx.self_cap) {
-      ret = mxt_read_diagnostic_data_self_cap(&ctx);
-    } else if (ctx.active_stylus) {
-      ret = mxt_read_diagnostic_data_ast(&ctx);
-    } else {
-      ret = mxt_read_diagnostic_data_frame(&ctx);
-    }
+    ret = mxt_read_diagnostic_frame(&ctx);
     if (ret)
       goto close;
 
@@ -678,10 +365,7 @@ int mxt_debug_dump(struct mxt_device *mxt, int mode, const char *csv_file,
 close:
   fclose(ctx.hawkeye);
 free:
-  free(ctx.data_buf);
-  ctx.data_buf = NULL;
-  free(ctx.t37_buf);
-  ctx.t37_buf = NULL;
+  mxt_debug_dump_free(&ctx);
 
   return ret;
 }
@@ -100,7 +100,7 @@ static void flash_firmware_command(struct mxt_device *mxt)
     return;
   }
 
-  mxt_flash_firmware(mxt->ctx, mxt, fw_file, "", conn);
+  mxt_flash_firmware(mxt->ctx, mxt, fw_file, "", conn, true);
 }
 
 
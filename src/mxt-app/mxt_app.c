@@ -31,11 +31,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <signal.h>
+#include <pthread.h>
 
 #include "libmaxtouch/libmaxtouch.h"
 #include "libmaxtouch/log.h"
@@ -45,9 +48,15 @@
 #include "broken_line.h"
 #include "sensor_variant.h"
 #include "mxt_app.h"
+#include "bridge.h"
+#include "daemon.h"
+#include "snapshot.h"
 
 #define BUF_SIZE 1024
 
+/* Devices handled at once by --all-devices */
+#define ALL_DEVICES_MAX_WORKERS 8
+
 
 //******************************************************************************
 /// \brief Initialize mXT device and read the info block
@@ -75,6 +84,7 @@ static int mxt_init_chip(struct libmaxtouch_ctx *ctx, struct mxt_device **mxt,
 #ifdef HAVE_LIBUSB
   if ((*mxt)->conn->type == E_USB && usb_is_bootloader(*mxt)) {
     mxt_free_device(*mxt);
+    *mxt = NULL;
     mxt_err(ctx, "USB device in bootloader mode");
     return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
   }
@@ -86,6 +96,364 @@ static int mxt_init_chip(struct libmaxtouch_ctx *ctx, struct mxt_device **mxt,
   return MXT_SUCCESS;
 }
 
+//******************************************************************************
+/// \brief Load configuration file, back it up to NVRAM and reset
+/// \return #mxt_rc
+static int load_config(struct mxt_device *mxt, const char *filename,
+                       uint8_t backup_cmd, bool kernel_update)
+{
+  struct libmaxtouch_ctx *ctx = mxt->ctx;
+  int ret;
+
+  /* The kernel driver resets the device itself */
+  if (kernel_update) {
+    ret = mxt_kernel_load_config(mxt, filename);
+    if (ret == MXT_SUCCESS) {
+      mxt_info(ctx, "Configuration loaded by kernel driver");
+
+      ret = mxt_backup_config(mxt, backup_cmd);
+      if (ret) {
+        mxt_err(ctx, "Error backing up");
+        return ret;
+      }
+
+      mxt_info(ctx, "Configuration backed up");
+      return MXT_SUCCESS;
+    }
+
+    if (ret != MXT_ERROR_NOT_SUPPORTED)
+      return ret;
+  }
+
+  ret = mxt_load_config_file(mxt, filename);
+  if (ret) {
+    mxt_err(ctx, "Error loading the configuration");
+    return ret;
+  }
+
+  mxt_info(ctx, "Configuration loaded");
+
+  ret = mxt_backup_config(mxt, backup_cmd);
+  if (ret) {
+    mxt_err(ctx, "Error backing up");
+    return ret;
+  }
+
+  mxt_info(ctx, "Configuration backed up");
+
+  ret = mxt_reset_chip(mxt, false);
+  if (ret) {
+    mxt_err(ctx, "Error resetting");
+    return ret;
+  }
+
+  mxt_info(ctx, "Chip reset");
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Command run on each device by --all-devices
+struct all_devices_cmd {
+  mxt_app_cmd cmd;
+  const char *filename;
+  uint8_t backup_cmd;
+  bool kernel_update;
+  unsigned char self_test_cmd;
+  uint8_t t37_mode;
+  uint16_t t37_frames;
+};
+
+//******************************************************************************
+/// \brief Work shared between the --all-devices worker threads
+struct all_devices_pool {
+  struct libmaxtouch_ctx *ctx;
+  const struct all_devices_cmd *cmd;
+  struct mxt_conn_info **conns;
+  int *results;
+  int count;
+  int next;                       /* Updated atomically */
+};
+
+/* Device string of the device handled by the calling worker thread */
+static __thread const char *all_devices_name;
+
+/* Log function replaced while the workers run */
+static void (*all_devices_log_fn)(struct libmaxtouch_ctx *ctx,
+                                  enum mxt_log_level level,
+                                  const char *format, va_list args);
+
+//******************************************************************************
+/// \brief Pass a message on to the replaced log function
+static void all_devices_log_prev(struct libmaxtouch_ctx *ctx,
+                                 enum mxt_log_level level,
+                                 const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  all_devices_log_fn(ctx, level, format, args);
+  va_end(args);
+}
+
+//******************************************************************************
+/// \brief Log function prefixing messages with the worker's device
+static void all_devices_log(struct libmaxtouch_ctx *ctx,
+                            enum mxt_log_level level,
+                            const char *format, va_list args)
+{
+  char msg[BUF_SIZE];
+
+  if (!all_devices_name) {
+    all_devices_log_fn(ctx, level, format, args);
+    return;
+  }
+
+  vsnprintf(msg, sizeof(msg), format, args);
+
+  /* Keep the parts of one line from different threads apart */
+  flockfile(stderr);
+  flockfile(stdout);
+  all_devices_log_prev(ctx, level, "%s: %s", all_devices_name, msg);
+  funlockfile(stdout);
+  funlockfile(stderr);
+}
+
+//******************************************************************************
+/// \brief Insert the device into an output file name, so that "dump.csv"
+///        becomes "dump-2-004a.csv"
+/// \return #mxt_rc
+static int all_devices_filename(char *buf, size_t buflen,
+                                const char *filename, const char *name)
+{
+  const char *tag = strrchr(name, '/');
+  const char *colon = strrchr(name, ':');
+  const char *ext = strrchr(filename, '.');
+  const char *dir = strrchr(filename, '/');
+  int len;
+
+  if (!tag || (colon && colon > tag))
+    tag = colon;
+  tag = tag ? tag + 1 : name;
+
+  if (!ext || (dir && dir > ext))
+    ext = filename + strlen(filename);
+
+  len = snprintf(buf, buflen, "%.*s-%s%s",
+                 (int)(ext - filename), filename, tag, ext);
+  if (len < 0 || (size_t)len >= buflen)
+    return MXT_ERROR_NO_MEM;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Run the --all-devices command on one device
+/// \return #mxt_rc
+static int all_devices_run(struct all_devices_pool *pool,
+                           struct mxt_conn_info *conn, const char *name)
+{
+  struct libmaxtouch_ctx *ctx = pool->ctx;
+  const struct all_devices_cmd *cmd = pool->cmd;
+  struct mxt_device *mxt = NULL;
+  struct mxt_id_info *id;
+  char filename[BUF_SIZE];
+  int ret;
+
+  ret = mxt_init_chip(ctx, &mxt, &conn);
+  if (ret)
+    goto free;
+
+  if (cmd->cmd == CMD_SAVE_CFG || cmd->cmd == CMD_DEBUG_DUMP) {
+    ret = all_devices_filename(filename, sizeof(filename), cmd->filename, name);
+    if (ret) {
+      mxt_err(ctx, "File name too long");
+      goto free;
+    }
+  }
+
+  mxt_set_debug(mxt, true);
+
+  switch (cmd->cmd) {
+  case CMD_QUERY:
+    id = mxt->info.id;
+    mxt_info(ctx, "Family %u Variant %u Firmware V%u.%u.%02X Matrix X%uY%u",
+             id->family, id->variant, id->version >> 4, id->version & 0x0F,
+             id->build, id->matrix_x_size, id->matrix_y_size);
+    ret = MXT_SUCCESS;
+    break;
+
+  case CMD_LOAD_CFG:
+    ret = load_config(mxt, cmd->filename, cmd->backup_cmd,
+                      cmd->kernel_update);
+    break;
+
+  case CMD_SAVE_CFG:
+    ret = mxt_save_config_file(mxt, filename);
+    break;
+
+  case CMD_TEST:
+    ret = run_self_tests(mxt, cmd->self_test_cmd);
+    break;
+
+  case CMD_CRC_CHECK:
+    ret = mxt_checkcrc(ctx, mxt, (char *)cmd->filename);
+    break;
+
+  case CMD_DEBUG_DUMP:
+    ret = mxt_debug_dump(mxt, cmd->t37_mode, filename, cmd->t37_frames);
+    break;
+
+  default:
+    ret = MXT_ERROR_BAD_INPUT;
+    break;
+  }
+
+  mxt_set_debug(mxt, false);
+
+free:
+  if (mxt)
+    mxt_free_device(mxt);
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Worker thread taking devices from the pool until none are left
+static void *all_devices_worker(void *arg)
+{
+  struct all_devices_pool *pool = arg;
+  char name[BUF_SIZE];
+  int i;
+
+  while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count) {
+    if (mxt_conn_name(pool->conns[i], name, sizeof(name)))
+      snprintf(name, sizeof(name), "device %d", i);
+
+    all_devices_name = name;
+    pool->results[i] = all_devices_run(pool, pool->conns[i], name);
+    all_devices_name = NULL;
+  }
+
+  return NULL;
+}
+
+//******************************************************************************
+/// \brief Run a command on every device found, several devices at once
+/// \return #mxt_rc of the first device which failed, or MXT_SUCCESS
+static int mxt_all_devices(struct libmaxtouch_ctx *ctx,
+                           const struct all_devices_cmd *cmd)
+{
+  struct all_devices_pool pool = { 0 };
+  pthread_t threads[ALL_DEVICES_MAX_WORKERS];
+  char name[BUF_SIZE];
+  int workers;
+  int started;
+  int ret;
+  int i;
+
+  switch (cmd->cmd) {
+  case CMD_QUERY:
+  case CMD_LOAD_CFG:
+  case CMD_SAVE_CFG:
+  case CMD_TEST:
+  case CMD_CRC_CHECK:
+  case CMD_DEBUG_DUMP:
+    break;
+
+  default:
+    mxt_err(ctx, "--all-devices supports --query, --load, --save, --test, "
+            "--checksum and --debug-dump");
+    return MXT_ERROR_BAD_INPUT;
+  }
+
+  ret = mxt_scan_all(ctx, &pool.conns, &pool.count);
+  if (ret == MXT_ERROR_NO_DEVICE) {
+    mxt_err(ctx, "Unable to find a device");
+    return ret;
+  } else if (ret) {
+    mxt_err(ctx, "Failed to find devices");
+    return ret;
+  }
+
+  pool.results = calloc(pool.count, sizeof(int));
+  if (!pool.results) {
+    ret = MXT_ERROR_NO_MEM;
+    goto free;
+  }
+
+  pool.ctx = ctx;
+  pool.cmd = cmd;
+
+  all_devices_log_fn = ctx->log_fn;
+  ctx->log_fn = all_devices_log;
+
+  workers = MIN(pool.count, ALL_DEVICES_MAX_WORKERS);
+  for (started = 0; started < workers; started++) {
+    if (pthread_create(&threads[started], NULL, all_devices_worker, &pool))
+      break;
+  }
+
+  /* Do the work here if no thread could be started */
+  if (started == 0)
+    all_devices_worker(&pool);
+
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+
+  ctx->log_fn = all_devices_log_fn;
+
+  for (i = 0; i < pool.count; i++) {
+    if (mxt_conn_name(pool.conns[i], name, sizeof(name)))
+      snprintf(name, sizeof(name), "device %d", i);
+
+    if (pool.results[i] == MXT_SUCCESS) {
+      printf("%s: OK\n", name);
+    } else {
+      printf("%s: FAILED (%d)\n", name, pool.results[i]);
+      if (ret == MXT_SUCCESS)
+        ret = pool.results[i];
+    }
+  }
+
+free:
+  free(pool.results);
+  mxt_free_conn_list(pool.conns, pool.count);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief Print transport statistics of all devices used
+static void print_transport_stats(struct libmaxtouch_ctx *ctx,
+                                  struct mxt_device *mxt)
+{
+  struct mxt_transport_stats stats = ctx->transport_stats;
+  const struct mxt_stats_histogram *hist;
+  int op;
+
+  /* Device still open after an error */
+  if (mxt)
+    mxt_stats_merge(&stats, &mxt->stats);
+
+  fprintf(stderr, "Transport statistics:\n"
+          "  bytes read %" PRIu64 ", written %" PRIu64 "\n"
+          "  syscalls %lu, retries %lu, NAKs %lu, EAGAIN %lu\n",
+          stats.bytes_read, stats.bytes_written,
+          stats.syscalls, stats.retries, stats.naks, stats.eagain);
+
+  for (op = 0; op < MXT_STATS_OPS; op++) {
+    hist = &stats.latency[op];
+    if (hist->count == 0)
+      continue;
+
+    fprintf(stderr, "  %-10s n=%lu errors=%lu avg=%" PRIu64 "us "
+            "p50=%" PRIu64 "us p99=%" PRIu64 "us max=%" PRIu64 "us\n",
+            mxt_stats_op_name(op), hist->count, hist->errors,
+            hist->total_us / hist->count,
+            mxt_stats_percentile(hist, 50), mxt_stats_percentile(hist, 99),
+            hist->max_us);
+  }
+}
+
 //******************************************************************************
 /// \brief Print usage for mxt-app
 static void print_usage(char *prog_name)
@@ -107,6 +475,9 @@ static void print_usage(char *prog_name)
           "  --self-cap-tune-nvram      : tune self capacitance settings to NVRAM\n"
           "  --version                  : print version\n"
           "  --block-size BLOCKSIZE     : set the maximum block size used for i2c transfers (default %d)\n"
+          "  --script FILE              : run the commands in FILE, one per line\n"
+          "  --snapshot FILE            : save all object memory and info block to FILE\n"
+          "  --snapshot-diff A B [C...] : show changes between consecutive snapshots\n"
           "\n"
           "Configuration file commands:\n"
           "  --load FILE                : upload cfg from FILE in .xcfg or OBP_RAW format\n"
@@ -124,15 +495,31 @@ static void print_usage(char *prog_name)
           "  --zero                     : zero all configuration settings\n"
           "\n"
           "TCP socket commands:\n"
-          "  -C [--bridge-client] HOST  : connect over TCP to HOST\n"
-          "  -S [--bridge-server]       : start TCP socket server\n"
+          "  -C [--bridge-client] HOST  : connect over TCP to HOST, or to\n"
+          "                               unix socket if HOST is unix:PATH\n"
+          "  -S [--bridge-server] [unix:PATH]\n"
+          "                             : start TCP socket server, or unix\n"
+          "                               socket server at PATH\n"
           "  -p [--port] PORT           : TCP port (default 4000)\n"
+          "  --socket-mode MODE         : unix socket permissions (default 0660)\n"
+          "\n"
+          "Daemon commands:\n"
+          "  --daemon[=PATH]            : stay attached to the device, serving\n"
+          "                               commands from other mxt-app processes\n"
+          "                               on unix socket PATH\n"
+          "  --no-daemon                : access the device directly even if a\n"
+          "                               daemon is running\n"
           "\n"
           "Bootloader commands:\n"
           "  --bootloader-version       : query bootloader version\n"
           "  --flash FIRMWARE           : send FIRMWARE to bootloader\n"
           "  --firmware-version VERSION : check firmware VERSION "
           "before and after flash\n"
+          "  --no-kernel-update         : drive the bootloader or write the\n"
+          "                               config directly even if the kernel\n"
+          "                               driver can do the update\n"
+          "  --firmware-dir DIR         : stage files for the kernel driver in\n"
+          "                               DIR (default " SYSFS_FIRMWARE_DIR ")\n"
           "\n"
           "T68 Serial Data commands:\n"
           "  --t68-file FILE            : upload FILE\n"
@@ -151,6 +538,10 @@ static void print_usage(char *prog_name)
           "  --self-cap-refs            : capture self cap references\n"
           "  --active-stylus-deltas     : capture active stylus deltas\n"
           "  --active-stylus-refs       : capture active stylus references\n"
+          "  --v4l2 DEV                 : capture deltas and references from\n"
+          "                               V4L2 touch device DEV, or auto for\n"
+          "                               that of the kernel driver\n"
+          "  --no-v4l2                  : capture through T37 (default)\n"
           "\n"
           "Broken line detection commands:\n"
           "  --broken-line              : run broken line detection\n"
@@ -172,7 +563,15 @@ static void print_usage(char *prog_name)
           "\n"
           "Device connection options:\n"
           "  -q [--query]               : scan for devices\n"
-          "  -d [--device] DEVICESTRING : DEVICESTRING as output by --query\n\n"
+          "  -d [--device] DEVICESTRING : DEVICESTRING as output by --query\n"
+          "  --sysfs-root DIR           : scan DIR for kernel drivers\n"
+          "                               (default " SYSFS_I2C_ROOT ")\n"
+          "  --i2c-adapters N[,N...]    : also probe i2c-dev adapters N for\n"
+          "                               devices when scanning\n"
+          "  --all-devices              : run --query, --load, --save, --test,\n"
+          "                               --checksum or --debug-dump on every\n"
+          "                               device found, output files are named\n"
+          "                               after each device\n\n"
           "  Examples:\n"
           "    -d i2c-dev:ADAPTER:ADDRESS : raw i2c device, eg \"i2c-dev:2-004a\"\n"
 #ifdef HAVE_LIBUSB
@@ -182,7 +581,11 @@ static void print_usage(char *prog_name)
           "    -d hidraw:PATH             : HIDRAW device, eg \"hidraw:/dev/hidraw0\"\n"
           "\n"
           "Debug options:\n"
-          "  -v [--verbose] LEVEL       : set debug level\n",
+          "  -v [--verbose] LEVEL       : set debug level\n"
+          "  --log-async                : write log from a background thread\n"
+          "  --stats                    : print transport statistics on exit\n"
+          "  --trace FILE               : write timeline of operations to FILE\n"
+          "                               in Chrome trace event format\n",
           MXT_VERSION, prog_name, I2C_DEV_MAX_BLOCK);
 }
 
@@ -203,10 +606,22 @@ int main (int argc, char *argv[])
   uint16_t msg_filter_type = 0;
   uint8_t instance = 0;
   uint8_t verbose = 2;
+  bool log_async = false;
+  bool print_stats = false;
+  bool all_devices = false;
+  bool no_daemon = false;
+  bool kernel_update = true;
+  const char *sysfs_root = NULL;
+  const char *firmware_dir = NULL;
+  const char *i2c_adapters = NULL;
+  char *trace_file = NULL;
+  const char *v4l2_node = NULL;
+  int span;
   uint16_t t37_frames = 1;
   uint8_t t37_mode = DELTAS_MODE;
   bool format = false;
   uint16_t port = 4000;
+  unsigned int socket_mode = BRIDGE_UNIX_MODE;
   int i2c_block_size = I2C_DEV_MAX_BLOCK;
   uint8_t t68_datatype = 1;
   unsigned char databuf;
@@ -232,12 +647,14 @@ int main (int argc, char *argv[])
     int option_index = 0;
 
     static struct option long_options[] = {
+      {"all-devices",      no_argument,       0, 0},
       {"backup",           optional_argument, 0, 0},
       {"block-size",       required_argument, 0, 0},
       {"bootloader-version", no_argument,     0, 0},
       {"bridge-client",    required_argument, 0, 'C'},
       {"calibrate",        no_argument,       0, 0},
       {"checksum",         required_argument, 0, 0},
+      {"daemon",           optional_argument, 0, 0},
       {"debug-dump",       required_argument, 0, 0},
       {"device",           required_argument, 0, 'd'},
       {"t68-file",         required_argument, 0, 0},
@@ -245,14 +662,20 @@ int main (int argc, char *argv[])
       {"msg-filter",       required_argument, 0, 'F'},
       {"format",           no_argument,       0, 'f'},
       {"flash",            required_argument, 0, 0},
+      {"firmware-dir",     required_argument, 0, 0},
       {"firmware-version", required_argument, 0, 0},
       {"frames",           required_argument, 0, 0},
       {"help",             no_argument,       0, 'h'},
+      {"i2c-adapters",     required_argument, 0, 0},
       {"info",             no_argument,       0, 'i'},
       {"instance",         required_argument, 0, 'I'},
       {"load",             required_argument, 0, 0},
+      {"log-async",        no_argument,       0, 0},
       {"save",             required_argument, 0, 0},
       {"messages",         optional_argument, 0, 'M'},
+      {"no-daemon",        no_argument,       0, 0},
+      {"no-kernel-update", no_argument,       0, 0},
+      {"no-v4l2",          no_argument,       0, 0},
       {"broken-line",      no_argument,       0, 0},
       {"dualx",            no_argument,       0, 0},
       {"x-center-threshold",  required_argument, 0,0},
@@ -274,6 +697,13 @@ int main (int argc, char *argv[])
       {"reset-bootloader", no_argument,       0, 0},
       {"register",         required_argument, 0, 'r'},
       {"references",       no_argument,       0, 0},
+      {"socket-mode",      required_argument, 0, 0},
+      {"stats",            no_argument,       0, 0},
+      {"sysfs-root",       required_argument, 0, 0},
+      {"trace",            required_argument, 0, 0},
+      {"script",           required_argument, 0, 0},
+      {"snapshot",         required_argument, 0, 0},
+      {"snapshot-diff",    required_argument, 0, 0},
       {"self-cap-tune-config", no_argument,       0, 0},
       {"self-cap-tune-nvram",  no_argument,       0, 0},
       {"self-cap-signals", no_argument,       0, 0},
@@ -281,10 +711,11 @@ int main (int argc, char *argv[])
       {"self-cap-refs",    no_argument,       0, 0},
       {"active-stylus-deltas",  no_argument,       0, 0},
       {"active-stylus-refs",    no_argument,       0, 0},
-      {"bridge-server",    no_argument,       0, 'S'},
+      {"bridge-server",    optional_argument, 0, 'S'},
       {"test",             optional_argument, 0, 't'},
       {"type",             required_argument, 0, 'T'},
       {"verbose",          required_argument, 0, 'v'},
+      {"v4l2",             required_argument, 0, 0},
       {"version",          no_argument,       0, 0},
       {"write",            no_argument,       0, 'W'},
       {"zero",             no_argument,       0, 0},
@@ -292,7 +723,7 @@ int main (int argc, char *argv[])
     };
 
     c = getopt_long(argc, argv,
-                    "C:d:D:fF:ghiI:M::m:n:p:qRr:St::T:v:W",
+                    "C:d:D:fF:ghiI:M::m:n:p:qRr:S::t::T:v:W",
                     long_options, &option_index);
     if (c == -1)
       break;
@@ -490,6 +921,33 @@ int main (int argc, char *argv[])
           print_usage(argv[0]);
           return MXT_ERROR_BAD_INPUT;
         }
+      } else if (!strcmp(long_options[option_index].name, "script")) {
+        if (cmd == CMD_NONE) {
+          cmd = CMD_SCRIPT;
+          strncpy(strbuf, optarg, sizeof(strbuf));
+          strbuf[sizeof(strbuf) - 1] = '\0';
+        } else {
+          print_usage(argv[0]);
+          return MXT_ERROR_BAD_INPUT;
+        }
+      } else if (!strcmp(long_options[option_index].name, "snapshot")) {
+        if (cmd == CMD_NONE) {
+          cmd = CMD_SNAPSHOT;
+          strncpy(strbuf, optarg, sizeof(strbuf));
+          strbuf[sizeof(strbuf) - 1] = '\0';
+        } else {
+          print_usage(argv[0]);
+          return MXT_ERROR_BAD_INPUT;
+        }
+      } else if (!strcmp(long_options[option_index].name, "snapshot-diff")) {
+        if (cmd == CMD_NONE) {
+          cmd = CMD_SNAPSHOT_DIFF;
+          strncpy(strbuf, optarg, sizeof(strbuf));
+          strbuf[sizeof(strbuf) - 1] = '\0';
+        } else {
+          print_usage(argv[0]);
+          return MXT_ERROR_BAD_INPUT;
+        }
       } else if (!strcmp(long_options[option_index].name, "checksum")) {
         if (cmd == CMD_NONE) {
           cmd = CMD_CRC_CHECK;
@@ -522,6 +980,51 @@ int main (int argc, char *argv[])
         t37_mode = AST_DELTAS;
       } else if (!strcmp(long_options[option_index].name, "active-stylus-refs")) {
         t37_mode = AST_REFS;
+      } else if (!strcmp(long_options[option_index].name, "v4l2")) {
+        v4l2_node = optarg;
+      } else if (!strcmp(long_options[option_index].name, "no-v4l2")) {
+        v4l2_node = "";
+      } else if (!strcmp(long_options[option_index].name, "socket-mode")) {
+        char *end;
+        long mode;
+
+        errno = 0;
+        mode = strtol(optarg, &end, 8);
+        if (errno || end == optarg || *end != '\0' || mode < 0 || mode > 0777) {
+          fprintf(stderr, "Invalid socket mode %s\n", optarg);
+          print_usage(argv[0]);
+          return MXT_ERROR_BAD_INPUT;
+        }
+        socket_mode = mode;
+      } else if (!strcmp(long_options[option_index].name, "log-async")) {
+        log_async = true;
+      } else if (!strcmp(long_options[option_index].name, "stats")) {
+        print_stats = true;
+      } else if (!strcmp(long_options[option_index].name, "all-devices")) {
+        all_devices = true;
+      } else if (!strcmp(long_options[option_index].name, "no-daemon")) {
+        no_daemon = true;
+      } else if (!strcmp(long_options[option_index].name, "no-kernel-update")) {
+        kernel_update = false;
+      } else if (!strcmp(long_options[option_index].name, "sysfs-root")) {
+        sysfs_root = optarg;
+      } else if (!strcmp(long_options[option_index].name, "firmware-dir")) {
+        firmware_dir = optarg;
+      } else if (!strcmp(long_options[option_index].name, "i2c-adapters")) {
+        i2c_adapters = optarg;
+      } else if (!strcmp(long_options[option_index].name, "daemon")) {
+        if (cmd == CMD_NONE) {
+          cmd = CMD_DAEMON;
+          if (optarg) {
+            strncpy(strbuf, optarg, sizeof(strbuf));
+            strbuf[sizeof(strbuf) - 1] = '\0';
+          }
+        } else {
+          print_usage(argv[0]);
+          return MXT_ERROR_BAD_INPUT;
+        }
+      } else if (!strcmp(long_options[option_index].name, "trace")) {
+        trace_file = optarg;
       } else if (!strcmp(long_options[option_index].name, "block-size")) {
         i2c_block_size = atoi(optarg);
       } else if (!strcmp(long_options[option_index].name, "version")) {
@@ -681,6 +1184,22 @@ int main (int argc, char *argv[])
     case 'S':
       if (cmd == CMD_NONE) {
         cmd = CMD_BRIDGE_SERVER;
+
+        /* Accept "-S unix:PATH" as well as "--bridge-server=unix:PATH" */
+        if (!optarg && optind < argc
+            && !strncmp(argv[optind], BRIDGE_UNIX_PREFIX,
+                        strlen(BRIDGE_UNIX_PREFIX)))
+          optarg = argv[optind++];
+
+        if (optarg) {
+          if (strncmp(optarg, BRIDGE_UNIX_PREFIX, strlen(BRIDGE_UNIX_PREFIX))) {
+            print_usage(argv[0]);
+            return MXT_ERROR_BAD_INPUT;
+          }
+
+          strncpy(strbuf, optarg, sizeof(strbuf));
+          strbuf[sizeof(strbuf) - 1] = '\0';
+        }
       } else {
         print_usage(argv[0]);
         return MXT_ERROR_BAD_INPUT;
@@ -743,6 +1262,35 @@ int main (int argc, char *argv[])
     }
   }
 
+  /* Hand short commands to a daemon which already has the device open */
+  if (!no_daemon && !all_devices && !conn && !msgs_enabled && !print_stats
+      && !trace_file && !log_async && i2c_block_size == I2C_DEV_MAX_BLOCK
+      && !sysfs_root && !i2c_adapters && mxt_daemon_cmd_supported(cmd)) {
+    struct daemon_request *req = calloc(1, sizeof(*req));
+    int cmd_ret;
+
+    if (!req)
+      return MXT_ERROR_NO_MEM;
+
+    req->cmd = cmd;
+    req->object_type = object_type;
+    req->address = address;
+    req->count = count;
+    req->instance = instance;
+    req->format = format;
+    req->verbose = verbose;
+    req->backup_cmd = backup_cmd;
+    strncpy(req->filename, strbuf, sizeof(req->filename) - 1);
+
+    ret = mxt_daemon_client(req, argc, argv, &cmd_ret);
+    free(req);
+
+    if (ret == MXT_SUCCESS)
+      return cmd_ret;
+    else if (ret != MXT_ERROR_NO_DEVICE)
+      return ret;
+  }
+
   struct mxt_device *mxt = NULL;
   struct libmaxtouch_ctx *ctx;
 
@@ -754,6 +1302,21 @@ int main (int argc, char *argv[])
 
   /* Set debug level */
   mxt_set_log_level(ctx, verbose);
+
+  if (log_async) {
+    ret = mxt_log_async_start(ctx, STDERR_FILENO);
+    if (ret)
+      mxt_warn(ctx, "Failed to start log thread");
+  }
+
+  if (trace_file) {
+    ret = mxt_trace_start(ctx, MXT_TRACE_DEFAULT_SPANS);
+    if (ret) {
+      mxt_err(ctx, "Failed to allocate trace buffer");
+      goto free;
+    }
+  }
+
   mxt_verb(ctx, "verbose:%u", verbose);
 
   /* Debug does not work until mxt_set_verbose() is called */
@@ -765,6 +1328,15 @@ int main (int argc, char *argv[])
     ctx->i2c_block_size = i2c_block_size;
   }
 
+  if (sysfs_root)
+    ctx->sysfs_root = sysfs_root;
+
+  if (firmware_dir)
+    ctx->firmware_dir = firmware_dir;
+
+  if (i2c_adapters)
+    ctx->i2c_dev_adapters = i2c_adapters;
+
   if (cmd == CMD_WRITE || cmd == CMD_READ) {
     mxt_verb(ctx, "instance:%u", instance);
     mxt_verb(ctx, "count:%u", count);
@@ -773,19 +1345,68 @@ int main (int argc, char *argv[])
     mxt_verb(ctx, "format:%s", format ? "true" : "false");
   }
 
-  if (cmd == CMD_QUERY) {
+  if (all_devices) {
+    struct all_devices_cmd all_cmd = {
+      .cmd = cmd,
+      .filename = strbuf,
+      .backup_cmd = backup_cmd,
+      .kernel_update = kernel_update,
+      .self_test_cmd = self_test_cmd,
+      .t37_mode = t37_mode,
+      .t37_frames = t37_frames,
+    };
+
+    if (conn) {
+      mxt_err(ctx, "--all-devices cannot be used with --device");
+      conn = mxt_unref_conn(conn);
+      ret = MXT_ERROR_BAD_INPUT;
+      goto free;
+    }
+
+    span = mxt_trace_begin(ctx, "all-devices", cmd);
+    ret = mxt_all_devices(ctx, &all_cmd);
+    mxt_trace_end(ctx, span);
+    goto free;
+
+  } else if (cmd == CMD_QUERY) {
     ret = mxt_scan(ctx, &conn, true);
     goto free;
 
+  } else if (cmd == CMD_SNAPSHOT_DIFF) {
+    /* First file is the option argument, the rest follow the options */
+    char **files = calloc(argc - optind + 1, sizeof(char *));
+
+    mxt_verb(ctx, "CMD_SNAPSHOT_DIFF");
+    if (!files) {
+      ret = MXT_ERROR_NO_MEM;
+      goto free;
+    }
+
+    files[0] = strbuf;
+    memcpy(&files[1], &argv[optind], (argc - optind) * sizeof(char *));
+    ret = mxt_snapshot_diff(ctx, argc - optind + 1, files);
+    free(files);
+    goto free;
+
   } else if (cmd != CMD_FLASH && cmd != CMD_BOOTLOADER_VERSION) {
+    span = mxt_trace_begin(ctx, "init", MXT_TRACE_NO_ARG);
     ret = mxt_init_chip(ctx, &mxt, &conn);
+    mxt_trace_end(ctx, span);
     if (ret && cmd != CMD_CRC_CHECK )
       goto free;
 
     if (mxt)
       mxt_set_debug(mxt, true);
+
+    if (mxt && v4l2_node) {
+      ret = mxt_frame_set_v4l2_node(mxt, v4l2_node);
+      if (ret)
+        goto free;
+    }
   }
 
+  span = mxt_trace_begin(ctx, "command", cmd);
+
   switch (cmd) {
   case CMD_WRITE:
     mxt_verb(ctx, "Write command");
@@ -813,13 +1434,21 @@ int main (int argc, char *argv[])
 
   case CMD_BRIDGE_SERVER:
     mxt_verb(ctx, "CMD_BRIDGE_SERVER");
-    mxt_verb(ctx, "port:%u", port);
-    ret = mxt_socket_server(mxt, port);
+    if (!strncmp(strbuf, BRIDGE_UNIX_PREFIX, strlen(BRIDGE_UNIX_PREFIX))) {
+      ret = mxt_socket_server_unix(mxt, strbuf + strlen(BRIDGE_UNIX_PREFIX),
+                                   socket_mode);
+    } else {
+      mxt_verb(ctx, "port:%u", port);
+      ret = mxt_socket_server(mxt, port);
+    }
     break;
 
   case CMD_BRIDGE_CLIENT:
     mxt_verb(ctx, "CMD_BRIDGE_CLIENT");
-    ret = mxt_socket_client(mxt, strbuf, port);
+    if (!strncmp(strbuf, BRIDGE_UNIX_PREFIX, strlen(BRIDGE_UNIX_PREFIX)))
+      ret = mxt_socket_client_unix(mxt, strbuf + strlen(BRIDGE_UNIX_PREFIX));
+    else
+      ret = mxt_socket_client(mxt, strbuf, port);
     break;
 
   case CMD_SERIAL_DATA:
@@ -835,7 +1464,7 @@ int main (int argc, char *argv[])
 
   case CMD_FLASH:
     mxt_verb(ctx, "CMD_FLASH");
-    ret = mxt_flash_firmware(ctx, mxt, strbuf, strbuf2, conn);
+    ret = mxt_flash_firmware(ctx, mxt, strbuf, strbuf2, conn, kernel_update);
     break;
 
   case CMD_RESET:
@@ -898,26 +1527,7 @@ int main (int argc, char *argv[])
   case CMD_LOAD_CFG:
     mxt_verb(ctx, "CMD_LOAD_CFG");
     mxt_verb(ctx, "filename:%s", strbuf);
-    ret = mxt_load_config_file(mxt, strbuf);
-    if (ret) {
-      mxt_err(ctx, "Error loading the configuration");
-    } else {
-      mxt_info(ctx, "Configuration loaded");
-
-      ret = mxt_backup_config(mxt, backup_cmd);
-      if (ret) {
-        mxt_err(ctx, "Error backing up");
-      } else {
-        mxt_info(ctx, "Configuration backed up");
-
-        ret = mxt_reset_chip(mxt, false);
-        if (ret) {
-          mxt_err(ctx, "Error resetting");
-        } else {
-          mxt_info(ctx, "Chip reset");
-        }
-      }
-    }
+    ret = load_config(mxt, strbuf, backup_cmd, kernel_update);
     break;
 
   case CMD_SAVE_CFG:
@@ -938,6 +1548,34 @@ int main (int argc, char *argv[])
     ret = mxt_checkcrc(ctx, mxt, strbuf);
     break;
 
+  case CMD_SCRIPT:
+    mxt_verb(ctx, "CMD_SCRIPT");
+    mxt_verb(ctx, "filename:%s", strbuf);
+    ret = mxt_run_script(mxt, strbuf);
+    break;
+
+  case CMD_SNAPSHOT:
+    mxt_verb(ctx, "CMD_SNAPSHOT");
+    mxt_verb(ctx, "filename:%s", strbuf);
+    ret = mxt_snapshot(mxt, strbuf);
+    break;
+
+  case CMD_DAEMON:
+    mxt_verb(ctx, "CMD_DAEMON");
+    if (strbuf[0] == '\0') {
+      ret = mxt_daemon_socket_path(strbuf, sizeof(strbuf));
+      if (ret == MXT_ERROR_NOENT) {
+        mxt_err(ctx, "XDG_RUNTIME_DIR is not set, give --daemon=PATH");
+        break;
+      } else if (ret) {
+        mxt_err(ctx, "Daemon socket path too long");
+        break;
+      }
+    }
+
+    ret = mxt_daemon(mxt, strbuf, socket_mode);
+    break;
+
   case CMD_NONE:
   default:
     mxt_verb(ctx, "cmd: %d", cmd);
@@ -950,6 +1588,8 @@ int main (int argc, char *argv[])
     break;
   }
 
+  mxt_trace_end(ctx, span);
+
   if (cmd == CMD_MESSAGES || (msgs_enabled && ret == MXT_SUCCESS)) {
     mxt_verb(ctx, "CMD_MESSAGES");
     mxt_verb(ctx, "msgs_timeout:%d", msgs_timeout);
@@ -957,16 +1597,25 @@ int main (int argc, char *argv[])
     if (cmd == CMD_MESSAGES && !msg_filter_type)
       msg_filter_type = object_type;
 
+    span = mxt_trace_begin(ctx, "messages", MXT_TRACE_NO_ARG);
     ret = print_raw_messages(mxt, msgs_timeout, msg_filter_type);
+    mxt_trace_end(ctx, span);
   }
 
   if (cmd != CMD_FLASH && cmd != CMD_BOOTLOADER_VERSION && mxt) {
     mxt_set_debug(mxt, false);
     mxt_free_device(mxt);
+    mxt = NULL;
     mxt_unref_conn(conn);
   }
 
 free:
+  if (print_stats)
+    print_transport_stats(ctx, mxt);
+
+  if (trace_file && ctx->trace)
+    mxt_trace_write(ctx, trace_file);
+
   mxt_free(ctx);
 
   return ret;
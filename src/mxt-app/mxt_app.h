@@ -43,17 +43,6 @@
 #define T9_YSIZE_OFFSET        0x04
 #define T9_XSIZE_OFFSET        0x03
 
-/* T6 Debug Diagnostics Commands */
-#define PAGE_UP           0x01
-#define PAGE_DOWN         0x02
-#define DELTAS_MODE       0x10
-#define REFS_MODE         0x11
-#define SELF_CAP_SIGNALS  0xF5
-#define SELF_CAP_DELTAS   0xF7
-#define SELF_CAP_REFS     0xF8
-#define AST_DELTAS        0xFB
-#define AST_REFS          0xFC
-
 /* T25 Self Test Commands */
 #define SELF_TEST_ANALOG       0x01
 #define SELF_TEST_PIN_FAULT    0x11
@@ -99,6 +88,10 @@ typedef enum mxt_app_cmd_t {
   CMD_BROKEN_LINE,
   CMD_SENSOR_VARIANT,
   CMD_CRC_CHECK,
+  CMD_DAEMON,
+  CMD_SCRIPT,
+  CMD_SNAPSHOT,
+  CMD_SNAPSHOT_DIFF,
 } mxt_app_cmd;
 
 //******************************************************************************
@@ -122,30 +115,14 @@ struct t37_ctx {
 
   int data_values;
   int passes;
-  int pages_per_pass;
-  int stripe_width;
-  int stripe_starty;
-  int stripe_endy;
-  uint8_t page_size;
   uint8_t mode;
 
-  int diag_cmd_addr;
-  int t37_addr;
-  int t37_size;
-  uint8_t t111_instances;
-  uint8_t t107_instances;
-
   uint16_t frame;
-  int pass;
-  int page;
-  int x_ptr;
-  int y_ptr;
 
   double mean;
   double variance;
   double std_dev;
 
-  struct t37_diagnostic_data *t37_buf;
   uint16_t *data_buf;
 
   FILE *hawkeye;
@@ -161,9 +138,11 @@ struct mxt_touchscreen_info {
   uint8_t ysize;
 };
 
-int mxt_flash_firmware(struct libmaxtouch_ctx *ctx, struct mxt_device *mxt, const char *filename, const char *new_version, struct mxt_conn_info *conn);
+int mxt_flash_firmware(struct libmaxtouch_ctx *ctx, struct mxt_device *mxt, const char *filename, const char *new_version, struct mxt_conn_info *conn, bool kernel_update);
 int mxt_socket_server(struct mxt_device *mxt, uint16_t port);
 int mxt_socket_client(struct mxt_device *mxt, char *ip_address, uint16_t port);
+int mxt_socket_server_unix(struct mxt_device *mxt, const char *path, unsigned int mode);
+int mxt_socket_client_unix(struct mxt_device *mxt, const char *path);
 int mxt_debug_dump(struct mxt_device *mxt, int mode, const char *csv_file, uint16_t frames);
 void mxt_dd_menu(struct mxt_device *mxt);
 int mxt_store_golden_refs(struct mxt_device *mxt);
@@ -175,8 +154,10 @@ int print_raw_messages(struct mxt_device *mxt, int timeout, uint16_t object_type
 int print_raw_messages_t44(struct mxt_device *mxt);
 void print_t6_status(uint8_t status);
 int mxt_self_cap_tune(struct mxt_device *mxt, mxt_app_cmd cmd);
-int mxt_read_diagnostic_data_frame(struct t37_ctx *ctx);
+int mxt_run_script(struct mxt_device *mxt, const char *filename);
 int mxt_debug_dump_initialise(struct t37_ctx *ctx);
+int mxt_read_diagnostic_frame(struct t37_ctx *ctx);
+void mxt_debug_dump_free(struct t37_ctx *ctx);
 sig_atomic_t mxt_get_sigint_flag(void);
 int mxt_read_messages_sigint(struct mxt_device *mxt, int timeout_seconds, void *context, int (*msg_func)(struct mxt_device *mxt, uint8_t *msg, void *context, uint8_t size));
 int mxt_bootloader_version(struct libmaxtouch_ctx *ctx, struct mxt_device *mxt, struct mxt_conn_info *conn);
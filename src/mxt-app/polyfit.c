@@ -31,6 +31,7 @@
 #include <stdbool.h>
 #include <math.h>
 
+#include "libmaxtouch/libmaxtouch.h"
 #include "libmaxtouch/log.h"
 
 #include "sensor_variant.h"
@@ -0,0 +1,438 @@
+//------------------------------------------------------------------------------
+/// \file   script.c
+/// \brief  Run a file of commands against one device
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/log.h"
+#include "libmaxtouch/utilfuncs.h"
+#include "libmaxtouch/info_block.h"
+#include "libmaxtouch/msg.h"
+#include "libmaxtouch/hex.h"
+#include "libmaxtouch/stats.h"
+
+#include "mxt_app.h"
+#include "script.h"
+
+/* Longest script line */
+#define SCRIPT_LINE_MAX       1024
+
+/* Most words on a script line */
+#define SCRIPT_MAX_ARGS       64
+
+/* Bytes written by one write command */
+#define SCRIPT_WRITE_MAX      256
+
+//******************************************************************************
+/// \brief State of a wait-msg command
+struct script_wait {
+  uint16_t object_type;
+  bool found;
+};
+
+//******************************************************************************
+/// \brief Diagnostic modes accepted by the dump command
+static const struct {
+  const char *name;
+  uint8_t mode;
+} script_dump_modes[] = {
+  { "deltas",              DELTAS_MODE },
+  { "refs",                REFS_MODE },
+  { "self-cap-signals",    SELF_CAP_SIGNALS },
+  { "self-cap-deltas",     SELF_CAP_DELTAS },
+  { "self-cap-refs",       SELF_CAP_REFS },
+  { "active-stylus-deltas", AST_DELTAS },
+  { "active-stylus-refs",  AST_REFS },
+};
+
+//******************************************************************************
+/// \brief Parse a number in decimal, or hex with 0x prefix
+/// \return #mxt_rc
+int script_parse_num(const char *str, unsigned long max, unsigned long *value)
+{
+  char *end;
+
+  errno = 0;
+  *value = strtoul(str, &end, 0);
+  if (errno || end == str || *end != '\0' || *value > max)
+    return MXT_ERROR_BAD_INPUT;
+
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Parse an object given as TYPE or TYPE:INSTANCE, eg "T7" or "T100:1"
+/// \return #mxt_rc
+int script_parse_object(const char *str, uint16_t *type, uint8_t *instance)
+{
+  char buf[16];
+  char *colon;
+  unsigned long value;
+
+  if ((str[0] != 'T' && str[0] != 't') || strlen(str) >= sizeof(buf))
+    return MXT_ERROR_BAD_INPUT;
+
+  strcpy(buf, str + 1);
+
+  *instance = 0;
+  colon = strchr(buf, ':');
+  if (colon) {
+    *colon = '\0';
+    if (script_parse_num(colon + 1, UINT8_MAX, &value))
+      return MXT_ERROR_BAD_INPUT;
+
+    *instance = value;
+  }
+
+  if (script_parse_num(buf, UINT16_MAX, &value) || value == 0)
+    return MXT_ERROR_BAD_INPUT;
+
+  *type = value;
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief Work out the register address from "TYPE[:INSTANCE] OFFSET" or
+///        "ADDRESS", consuming the words used
+/// \return #mxt_rc
+int script_parse_address(struct mxt_device *mxt, int argc, char **argv,
+                         int *used, uint16_t *address,
+                         uint16_t *object_type, uint8_t *instance)
+{
+  unsigned long value;
+  uint16_t object_address;
+
+  if (argc < 1)
+    return MXT_ERROR_BAD_INPUT;
+
+  if (script_parse_object(argv[0], object_type, instance) == MXT_SUCCESS) {
+    object_address = mxt_get_object_address(mxt, *object_type, *instance);
+    if (object_address == OBJECT_NOT_FOUND) {
+      mxt_err(mxt->ctx, "No such object %s", argv[0]);
+      return MXT_ERROR_OBJECT_NOT_FOUND;
+    }
+
+    *address = 0;
+    *used = 1;
+    if (argc > 1) {
+      if (script_parse_num(argv[1], UINT16_MAX, &value))
+        return MXT_ERROR_BAD_INPUT;
+
+      *address = value;
+      *used = 2;
+    }
+
+    return MXT_SUCCESS;
+  }
+
+  *object_type = 0;
+  *instance = 0;
+  if (script_parse_num(argv[0], UINT16_MAX, &value))
+    return MXT_ERROR_BAD_INPUT;
+
+  *address = value;
+  *used = 1;
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief read TYPE[:INSTANCE] [OFFSET [COUNT]] | read ADDRESS COUNT
+/// \return #mxt_rc
+static int script_read(struct mxt_device *mxt, int argc, char **argv)
+{
+  uint16_t object_type;
+  uint16_t address;
+  uint8_t instance;
+  unsigned long count = 0;
+  int used;
+  int ret;
+
+  ret = script_parse_address(mxt, argc, argv, &used, &address,
+                             &object_type, &instance);
+  if (ret)
+    return ret;
+
+  if (argc > used + 1)
+    return MXT_ERROR_BAD_INPUT;
+
+  /* Objects are read to their end by default, addresses need a count */
+  if (argc == used + 1) {
+    if (script_parse_num(argv[used], UINT16_MAX, &count) || count == 0)
+      return MXT_ERROR_BAD_INPUT;
+  } else if (object_type == 0) {
+    return MXT_ERROR_BAD_INPUT;
+  }
+
+  return mxt_read_object(mxt, object_type, instance, address, count, false);
+}
+
+//******************************************************************************
+/// \brief write TYPE[:INSTANCE] OFFSET HEX... | write ADDRESS HEX...
+/// \return #mxt_rc
+static int script_write(struct mxt_device *mxt, int argc, char **argv)
+{
+  uint8_t databuf[SCRIPT_WRITE_MAX];
+  uint16_t object_type;
+  uint16_t address;
+  uint8_t instance;
+  uint16_t count;
+  size_t len = 0;
+  int used;
+  int ret;
+  int i;
+
+  ret = script_parse_address(mxt, argc, argv, &used, &address,
+                             &object_type, &instance);
+  if (ret)
+    return ret;
+
+  /* Objects need the offset, so the data is not taken for it */
+  if (object_type && used == 1)
+    return MXT_ERROR_BAD_INPUT;
+
+  if (argc <= used)
+    return MXT_ERROR_BAD_INPUT;
+
+  for (i = used; i < argc; i++) {
+    ret = mxt_convert_hex(argv[i], databuf + len, &count,
+                          sizeof(databuf) - len);
+    if (ret || count == 0)
+      return MXT_ERROR_BAD_INPUT;
+
+    len += count;
+  }
+
+  if (object_type) {
+    if (address + len > mxt_get_object_size(mxt, object_type)) {
+      mxt_err(mxt->ctx, "Write past end of T%u", object_type);
+      return MXT_ERROR_BAD_INPUT;
+    }
+
+    address += mxt_get_object_address(mxt, object_type, instance);
+  }
+
+  return mxt_write_register(mxt, databuf, address, len);
+}
+
+//******************************************************************************
+/// \brief Print the message waited for
+/// \return #mxt_rc
+static int script_wait_msg_fn(struct mxt_device *mxt, uint8_t *msg,
+                              void *context, uint8_t size)
+{
+  struct script_wait *wait = context;
+  char hexbuf[256 * 3 + 1];
+  uint16_t type = mxt_report_id_to_type(mxt, msg[0]);
+
+  if (wait->found || (wait->object_type && type != wait->object_type))
+    return MXT_MSG_CONTINUE;
+
+  *mxt_hex_encode_spaced(hexbuf, msg, size) = '\0';
+  printf("T%u: %s\n", type, hexbuf);
+
+  wait->found = true;
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief wait-msg TYPE|any TIMEOUT_MS
+/// \return #mxt_rc
+static int script_wait_msg(struct mxt_device *mxt, int argc, char **argv)
+{
+  struct script_wait wait = { 0 };
+  unsigned long timeout_ms;
+  uint64_t start_us = mxt_stats_now_us();
+  uint8_t instance;
+  int flag = 0;
+  int ret;
+
+  if (argc != 2 || script_parse_num(argv[1], INT32_MAX, &timeout_ms))
+    return MXT_ERROR_BAD_INPUT;
+
+  if (strcmp(argv[0], "any")
+      && script_parse_object(argv[0], &wait.object_type, &instance))
+    return MXT_ERROR_BAD_INPUT;
+
+  do {
+    /* Timeout of zero reads the pending messages once */
+    ret = mxt_read_messages(mxt, 0, &wait, script_wait_msg_fn, &flag);
+    if (ret)
+      return ret;
+
+    if (wait.found)
+      return MXT_SUCCESS;
+  } while (mxt_stats_now_us() - start_us < timeout_ms * 1000);
+
+  mxt_err(mxt->ctx, "Timeout waiting for %s message", argv[0]);
+  return MXT_ERROR_TIMEOUT;
+}
+
+//******************************************************************************
+/// \brief dump MODE FRAMES FILE
+/// \return #mxt_rc
+static int script_dump(struct mxt_device *mxt, int argc, char **argv)
+{
+  unsigned long frames;
+  size_t i;
+
+  if (argc != 3 || script_parse_num(argv[1], UINT16_MAX, &frames)
+      || frames == 0)
+    return MXT_ERROR_BAD_INPUT;
+
+  for (i = 0; i < sizeof(script_dump_modes) / sizeof(script_dump_modes[0]); i++) {
+    if (!strcmp(argv[0], script_dump_modes[i].name))
+      return mxt_debug_dump(mxt, script_dump_modes[i].mode, argv[2], frames);
+  }
+
+  return MXT_ERROR_BAD_INPUT;
+}
+
+//******************************************************************************
+/// \brief Run one script line split into words
+/// \return #mxt_rc
+static int script_step(struct mxt_device *mxt, int argc, char **argv)
+{
+  const char *cmd = argv[0];
+  unsigned long value;
+
+  argc--;
+  argv++;
+
+  if (!strcmp(cmd, "read")) {
+    return script_read(mxt, argc, argv);
+  } else if (!strcmp(cmd, "write")) {
+    return script_write(mxt, argc, argv);
+  } else if (!strcmp(cmd, "wait-msg")) {
+    return script_wait_msg(mxt, argc, argv);
+  } else if (!strcmp(cmd, "sleep")) {
+    if (argc != 1 || script_parse_num(argv[0], UINT32_MAX / 1000, &value))
+      return MXT_ERROR_BAD_INPUT;
+
+    usleep(value * 1000);
+    return MXT_SUCCESS;
+  } else if (!strcmp(cmd, "dump")) {
+    return script_dump(mxt, argc, argv);
+  } else if (!strcmp(cmd, "calibrate") && argc == 0) {
+    return mxt_calibrate_chip(mxt);
+  } else if (!strcmp(cmd, "backup") && argc == 0) {
+    return mxt_backup_config(mxt, BACKUPNV_COMMAND);
+  } else if (!strcmp(cmd, "reset") && argc == 0) {
+    return mxt_reset_chip(mxt, false);
+  } else if (!strcmp(cmd, "crc") && argc == 1) {
+    return mxt_checkcrc(mxt->ctx, mxt, argv[0]);
+  }
+
+  return MXT_ERROR_BAD_INPUT;
+}
+
+//******************************************************************************
+/// \brief Run each line of a script file against the device, printing the
+///        time taken by each step
+///
+/// Blank lines and lines starting with '#' are ignored. The script stops at
+/// the first step which fails.
+/// \return #mxt_rc
+int mxt_run_script(struct mxt_device *mxt, const char *filename)
+{
+  char line[SCRIPT_LINE_MAX];
+  char *argv[SCRIPT_MAX_ARGS];
+  char *saveptr;
+  uint64_t script_start_us;
+  uint64_t start_us;
+  uint64_t step_us;
+  int line_num = 0;
+  int steps = 0;
+  int argc;
+  int ret = MXT_SUCCESS;
+  FILE *fp;
+
+  fp = fopen(filename, "r");
+  if (!fp) {
+    mxt_err(mxt->ctx, "Error opening %s: %s", filename, strerror(errno));
+    return mxt_errno_to_rc(errno);
+  }
+
+  script_start_us = mxt_stats_now_us();
+
+  while (fgets(line, sizeof(line), fp)) {
+    line_num++;
+
+    if (!strchr(line, '\n') && !feof(fp)) {
+      mxt_err(mxt->ctx, "%s:%d: line too long", filename, line_num);
+      ret = MXT_ERROR_BAD_INPUT;
+      break;
+    }
+
+    argc = 0;
+    argv[argc] = strtok_r(line, " \t\r\n", &saveptr);
+    while (argv[argc] && argc < SCRIPT_MAX_ARGS - 1)
+      argv[++argc] = strtok_r(NULL, " \t\r\n", &saveptr);
+
+    if (argv[argc]) {
+      mxt_err(mxt->ctx, "%s:%d: too many words", filename, line_num);
+      ret = MXT_ERROR_BAD_INPUT;
+      break;
+    }
+
+    if (argc == 0 || argv[0][0] == '#')
+      continue;
+
+    start_us = mxt_stats_now_us();
+    ret = script_step(mxt, argc, argv);
+    step_us = mxt_stats_now_us() - start_us;
+    steps++;
+
+    printf("step %d line %d %s: %" PRIu64 ".%03" PRIu64 " ms\n",
+           steps, line_num, argv[0], step_us / 1000, step_us % 1000);
+
+    if (ret == MXT_ERROR_BAD_INPUT) {
+      mxt_err(mxt->ctx, "%s:%d: bad command \"%s\"",
+              filename, line_num, argv[0]);
+      break;
+    } else if (ret) {
+      mxt_err(mxt->ctx, "%s:%d: %s failed (%d)",
+              filename, line_num, argv[0], ret);
+      break;
+    }
+  }
+
+  step_us = mxt_stats_now_us() - script_start_us;
+  printf("%d steps: %" PRIu64 ".%03" PRIu64 " ms\n",
+         steps, step_us / 1000, step_us % 1000);
+
+  fclose(fp);
+  return ret;
+}
@@ -80,7 +80,7 @@ static int self_test_handle_messages(struct mxt_device *mxt, uint8_t *msg,
       break;
     case SELF_TEST_PIN_FAULT_2:
       if (msg[3] == 0 && msg[4] == 0)
-        mxt_err(mxt->ctx, "FAIL: Pin fault SEQ_NUM=%d driven shield line failed");
+        mxt_err(mxt->ctx, "FAIL: Pin fault SEQ_NUM=%d driven shield line failed", msg[2]);
       else if (msg[3] > 0)
         mxt_err(mxt->ctx, "FAIL: Pin fault SEQ_NUM=%d X%d", msg[2], msg[3] - 1);
       else if (msg[4] > 0)
@@ -221,6 +221,8 @@ int sensor_variant_algorithm(struct t37_ctx *frame,
   int x,y;
   uint32_t total_failed = 0;
   uint16_t num_x = ts->xsize;
+  int num_pos;
+  double *pos = NULL;
 
   mxt_dbg(frame->lc, "debug frame: x_size: %d, y_size: %d",
           frame->x_size, frame->y_size);
@@ -249,16 +251,24 @@ int sensor_variant_algorithm(struct t37_ctx *frame,
     goto free;
   }
 
-  /* Test X lines */
-  for (x = 0; x < num_x; x++)
-    xval[x] = (double)x;
+  /* Line positions, used as the fit abscissa for both directions */
+  num_pos = (num_x > ts->ysize) ? num_x : ts->ysize;
+  pos = calloc(num_pos, sizeof(double));
+  if (!pos) {
+    ret = MXT_ERROR_NO_MEM;
+    goto free;
+  }
+
+  for (x = 0; x < num_pos; x++)
+    pos[x] = (double)x;
 
+  /* Test X lines */
   for (x = 0; x < num_x; x++) {
     uint32_t failures;
     double coeff[POLY_DEGREE + 1];
     get_xline_data(frame, x, ts->ysize, yval);
 
-    ret = check_line(frame->lc, sv_opts, xval, yval, ts->ysize,
+    ret = check_line(frame->lc, sv_opts, pos, yval, ts->ysize,
                      &failures, status + (x * ts->ysize), coeff);
     if (ret)
       goto free;
@@ -270,16 +280,13 @@ int sensor_variant_algorithm(struct t37_ctx *frame,
   }
 
   /* Test Y lines */
-  for (y = 0; y < ts->ysize; y++)
-    yval[y] = (double)y;
-
   for (y = 0; y < ts->ysize; y++) {
     uint32_t failures;
     double coeff[POLY_DEGREE + 1];
     bool yline_status[num_x];
     get_yline_data(frame, y, num_x, xval);
 
-    ret = check_line(frame->lc, sv_opts, yval, xval, num_x,
+    ret = check_line(frame->lc, sv_opts, pos, xval, num_x,
                      &failures, yline_status, coeff);
     if (ret)
       goto free;
@@ -326,6 +333,7 @@ int sensor_variant_algorithm(struct t37_ctx *frame,
   }
 
 free:
+  free(pos);
   free(xval);
   free(yval);
   free(status);
@@ -383,6 +391,11 @@ int mxt_sensor_variant(struct mxt_device *mxt, struct sensor_variant_options *sv
 
   mxt_info(mxt->ctx, "Acquiring one frame of reference data");
 
+  /* get_value() takes matrix coordinates, so V4L2 frames cannot be used */
+  ret = mxt_frame_set_v4l2_node(mxt, NULL);
+  if (ret)
+    return ret;
+
   struct t37_ctx *frame = calloc(1, sizeof(struct t37_ctx));
   if (!frame)
     return MXT_ERROR_NO_MEM;
@@ -395,7 +408,7 @@ int mxt_sensor_variant(struct mxt_device *mxt, struct sensor_variant_options *sv
   if (ret)
     return ret;
 
-  ret = mxt_read_diagnostic_data_frame(frame);
+  ret = mxt_read_diagnostic_frame(frame);
   if (ret)
     goto free;
 
@@ -419,10 +432,7 @@ int mxt_sensor_variant(struct mxt_device *mxt, struct sensor_variant_options *sv
 free:
   free(mxt_ts_info);
   mxt_ts_info = NULL;
-  free(frame->data_buf);
-  frame->data_buf = NULL;
-  free(frame->t37_buf);
-  frame->t37_buf = NULL;
+  mxt_debug_dump_free(frame);
   free(frame);
 
   return ret;
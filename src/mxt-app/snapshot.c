@@ -0,0 +1,521 @@
+//------------------------------------------------------------------------------
+/// \file   snapshot.c
+/// \brief  Snapshots of the whole object memory map and their comparison
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/log.h"
+#include "libmaxtouch/utilfuncs.h"
+#include "libmaxtouch/info_block.h"
+#include "libmaxtouch/trace.h"
+
+#include "snapshot.h"
+
+/* Changed bytes printed for each range */
+#define SNAPSHOT_DIFF_BYTES   16
+
+//******************************************************************************
+/// \brief Range of memory read in one go, or one instance of an object
+struct snapshot_range {
+  uint32_t start;
+  uint32_t end;                   /* Exclusive */
+  uint8_t type;
+  uint8_t instance;
+};
+
+//******************************************************************************
+/// \brief Order ranges by start address
+static int snapshot_range_cmp(const void *a, const void *b)
+{
+  const struct snapshot_range *ra = a;
+  const struct snapshot_range *rb = b;
+
+  return (int)ra->start - (int)rb->start;
+}
+
+//******************************************************************************
+/// \brief Size of info block with object table and CRC
+static uint32_t snapshot_info_size(const struct mxt_id_info *id)
+{
+  return sizeof(struct mxt_id_info)
+         + id->num_objects * sizeof(struct mxt_object)
+         + sizeof(struct mxt_raw_crc);
+}
+
+//******************************************************************************
+/// \brief  List address ranges of objects in the object table
+/// \param  per_instance  One range per instance rather than per object
+/// \return Number of ranges, or -1 on error
+static int snapshot_ranges(const uint8_t *info, bool per_instance,
+                           struct snapshot_range **ranges_out)
+{
+  const struct mxt_id_info *id = (const struct mxt_id_info *)info;
+  const struct mxt_object *objects =
+    (const struct mxt_object *)(info + sizeof(struct mxt_id_info));
+  struct snapshot_range *ranges;
+  uint32_t start;
+  int count = 0;
+  int i;
+  int j;
+
+  ranges = calloc(id->num_objects * (per_instance ? 256 : 1) + 1,
+                  sizeof(*ranges));
+  if (!ranges)
+    return -1;
+
+  for (i = 0; i < id->num_objects; i++) {
+    const struct mxt_object *obj = &objects[i];
+
+    start = obj->start_pos_lsb | (obj->start_pos_msb << 8);
+
+    if (!per_instance) {
+      ranges[count].start = start;
+      ranges[count].end = start + MXT_SIZE(*obj) * MXT_INSTANCES(*obj);
+      ranges[count].type = obj->type;
+      count++;
+      continue;
+    }
+
+    for (j = 0; j < MXT_INSTANCES(*obj); j++) {
+      ranges[count].start = start + j * MXT_SIZE(*obj);
+      ranges[count].end = ranges[count].start + MXT_SIZE(*obj);
+      ranges[count].type = obj->type;
+      ranges[count].instance = j;
+      count++;
+    }
+  }
+
+  qsort(ranges, count, sizeof(*ranges), snapshot_range_cmp);
+
+  *ranges_out = ranges;
+  return count;
+}
+
+//******************************************************************************
+/// \brief  Read the whole object memory map into a file, with the info block
+///         and the time as header
+///
+/// Objects next to each other are read together, so each read is as large
+/// as the transport allows. The message processor is left out, since reading
+/// it would take messages from the device. The device is locked throughout.
+/// \return #mxt_rc
+int mxt_snapshot(struct mxt_device *mxt, const char *filename)
+{
+  struct libmaxtouch_ctx *ctx = mxt->ctx;
+  struct mxt_snapshot_header hdr;
+  struct snapshot_range *ranges = NULL;
+  struct timespec now;
+  uint8_t *image = NULL;
+  uint32_t info_size;
+  uint32_t image_size = 0;
+  uint32_t start;
+  uint32_t end;
+  int count;
+  int reads = 0;
+  int next;
+  int span;
+  int ret;
+  int i;
+  FILE *fp;
+
+  info_size = snapshot_info_size(mxt->info.id);
+
+  count = snapshot_ranges(mxt->info.raw_info, false, &ranges);
+  if (count < 0)
+    return MXT_ERROR_NO_MEM;
+
+  for (i = 0; i < count; i++) {
+    if (ranges[i].end > image_size)
+      image_size = ranges[i].end;
+  }
+
+  if (image_size > SNAPSHOT_IMAGE_MAX) {
+    mxt_err(ctx, "Object table exceeds address space");
+    ret = MXT_ERROR_UNEXPECTED_DEVICE_STATE;
+    goto free;
+  }
+
+  if (image_size < info_size)
+    image_size = info_size;
+
+  image = calloc(image_size, 1);
+  if (!image) {
+    ret = MXT_ERROR_NO_MEM;
+    goto free;
+  }
+
+  memcpy(image, mxt->info.raw_info, info_size);
+
+  mxt_lock_device(mxt);
+  clock_gettime(CLOCK_REALTIME, &now);
+  span = mxt_trace_begin(ctx, "snapshot", image_size);
+
+  ret = MXT_SUCCESS;
+
+  for (i = 0; i < count; i = next) {
+    next = i + 1;
+    if (ranges[i].type == GEN_MESSAGEPROCESSOR_T5)
+      continue;
+
+    /* Extend over following objects which are contiguous */
+    start = ranges[i].start;
+    end = ranges[i].end;
+    for (; next < count; next++) {
+      if (ranges[next].type == GEN_MESSAGEPROCESSOR_T5
+          || ranges[next].start > end)
+        break;
+
+      if (ranges[next].end > end)
+        end = ranges[next].end;
+    }
+
+    mxt_dbg(ctx, "Reading %u bytes at %u", end - start, start);
+
+    ret = mxt_read_register(mxt, image + start, start, end - start);
+    if (ret) {
+      mxt_err(ctx, "Failed to read %u bytes at %u", end - start, start);
+      break;
+    }
+
+    reads++;
+  }
+
+  mxt_trace_end(ctx, span);
+  mxt_unlock_device(mxt);
+
+  if (ret)
+    goto free;
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+  hdr.time_sec = htole64(now.tv_sec);
+  hdr.time_nsec = htole32(now.tv_nsec);
+  hdr.info_size = htole32(info_size);
+  hdr.image_size = htole32(image_size);
+
+  fp = fopen(filename, "w");
+  if (!fp) {
+    mxt_err(ctx, "Cannot open %s, error %s (%d)",
+            filename, strerror(errno), errno);
+    ret = mxt_errno_to_rc(errno);
+    goto free;
+  }
+
+  if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1
+      || fwrite(mxt->info.raw_info, info_size, 1, fp) != 1
+      || fwrite(image, image_size, 1, fp) != 1) {
+    mxt_err(ctx, "Error writing %s", filename);
+    ret = MXT_ERROR_IO;
+    fclose(fp);
+    goto free;
+  }
+
+  if (fclose(fp)) {
+    mxt_err(ctx, "Error writing %s", filename);
+    ret = mxt_errno_to_rc(errno);
+    goto free;
+  }
+
+  mxt_info(ctx, "Saved %u bytes of memory in %d reads to %s",
+           image_size, reads, filename);
+  ret = MXT_SUCCESS;
+
+free:
+  free(image);
+  free(ranges);
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Map snapshot file and check its header
+/// \return #mxt_rc
+int mxt_snapshot_open(struct libmaxtouch_ctx *ctx, const char *filename,
+                      struct mxt_snapshot *snap)
+{
+  const struct mxt_snapshot_header *hdr;
+  const struct mxt_id_info *id;
+  struct stat st;
+  int fd;
+  int ret;
+
+  memset(snap, 0, sizeof(*snap));
+  snap->filename = filename;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    mxt_err(ctx, "Cannot open %s, error %s (%d)",
+            filename, strerror(errno), errno);
+    return mxt_errno_to_rc(errno);
+  }
+
+  if (fstat(fd, &st)) {
+    ret = mxt_errno_to_rc(errno);
+    goto close;
+  }
+
+  if (st.st_size < (off_t)sizeof(*hdr)) {
+    ret = MXT_ERROR_FILE_FORMAT;
+    goto close;
+  }
+
+  snap->map_len = st.st_size;
+  snap->map = mmap(NULL, snap->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (snap->map == MAP_FAILED) {
+    snap->map = NULL;
+    ret = mxt_errno_to_rc(errno);
+    goto close;
+  }
+
+  hdr = snap->map;
+  snap->time_sec = le64toh(hdr->time_sec);
+  snap->time_nsec = le32toh(hdr->time_nsec);
+  snap->info_size = le32toh(hdr->info_size);
+  snap->image_size = le32toh(hdr->image_size);
+  snap->info = (const uint8_t *)snap->map + sizeof(*hdr);
+  snap->image = snap->info + snap->info_size;
+  id = (const struct mxt_id_info *)snap->info;
+
+  if (memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(hdr->magic))
+      || snap->image_size > SNAPSHOT_IMAGE_MAX
+      || snap->info_size < sizeof(*id) + sizeof(struct mxt_raw_crc)
+      || snap->map_len != sizeof(*hdr) + snap->info_size + snap->image_size
+      || snap->info_size != snapshot_info_size(id)
+      || snap->image_size < snap->info_size) {
+    ret = MXT_ERROR_FILE_FORMAT;
+    goto close;
+  }
+
+  ret = MXT_SUCCESS;
+
+close:
+  close(fd);
+
+  if (ret) {
+    if (ret == MXT_ERROR_FILE_FORMAT)
+      mxt_err(ctx, "%s is not a snapshot", filename);
+
+    mxt_snapshot_close(snap);
+  }
+
+  return ret;
+}
+
+//******************************************************************************
+/// \brief  Unmap snapshot
+void mxt_snapshot_close(struct mxt_snapshot *snap)
+{
+  if (snap->map)
+    munmap(snap->map, snap->map_len);
+
+  snap->map = NULL;
+}
+
+//******************************************************************************
+/// \brief  Print one range of changed bytes
+static void snapshot_print_range(FILE *out, const struct mxt_snapshot *a,
+                                 const struct mxt_snapshot *b, uint32_t start,
+                                 uint32_t end, const struct snapshot_range *r)
+{
+  const char *name;
+  uint32_t len = end - start;
+  uint32_t shown = len < SNAPSHOT_DIFF_BYTES ? len : SNAPSHOT_DIFF_BYTES;
+  uint32_t i;
+
+  if (r) {
+    name = mxt_get_object_name(r->type);
+    if (name)
+      fprintf(out, "%s[%u] ", name, r->instance);
+    else
+      fprintf(out, "UNKNOWN_T%u[%u] ", r->type, r->instance);
+
+    start -= r->start;
+    end -= r->start;
+  } else {
+    fprintf(out, "@");
+  }
+
+  if (len == 1)
+    fprintf(out, "%u:", start);
+  else
+    fprintf(out, "%u-%u:", start, end - 1);
+
+  start = r ? start + r->start : start;
+
+  for (i = 0; i < shown; i++)
+    fprintf(out, " %02X", a->image[start + i]);
+  fprintf(out, "%s ->", shown < len ? " ..." : "");
+
+  for (i = 0; i < shown; i++)
+    fprintf(out, " %02X", b->image[start + i]);
+  fprintf(out, "%s\n", shown < len ? " ..." : "");
+}
+
+//******************************************************************************
+/// \brief  Print changed ranges between two snapshots of the same device,
+///         by object instance and offset within it
+///
+/// Equal memory is skipped a word at a time.
+/// \param  changes  Returns number of changed ranges
+/// \return #mxt_rc
+int mxt_snapshot_compare(const struct mxt_snapshot *a,
+                         const struct mxt_snapshot *b,
+                         FILE *out, int *changes)
+{
+  const uint8_t *ia = a->image;
+  const uint8_t *ib = b->image;
+  struct snapshot_range *ranges;
+  const struct snapshot_range *r;
+  uint64_t wa;
+  uint64_t wb;
+  uint32_t len;
+  uint32_t addr;
+  uint32_t end;
+  uint32_t limit;
+  int count;
+  int n = 0;
+
+  *changes = 0;
+
+  if (a->info_size != b->info_size
+      || memcmp(a->info, b->info, a->info_size)
+      || a->image_size != b->image_size)
+    return MXT_ERROR_UNEXPECTED_DEVICE_STATE;
+
+  count = snapshot_ranges(a->info, true, &ranges);
+  if (count < 0)
+    return MXT_ERROR_NO_MEM;
+
+  len = a->image_size;
+  addr = 0;
+
+  while (addr < len) {
+    while (addr + sizeof(wa) <= len) {
+      memcpy(&wa, ia + addr, sizeof(wa));
+      memcpy(&wb, ib + addr, sizeof(wb));
+      if (wa != wb)
+        break;
+
+      addr += sizeof(wa);
+    }
+
+    while (addr < len && ia[addr] == ib[addr])
+      addr++;
+
+    if (addr >= len)
+      break;
+
+    /* Ranges are sorted and changes are found in address order */
+    while (n < count && ranges[n].end <= addr)
+      n++;
+
+    if (n < count && ranges[n].start <= addr) {
+      r = &ranges[n];
+      limit = r->end;
+    } else {
+      r = NULL;
+      limit = (n < count) ? ranges[n].start : len;
+    }
+
+    for (end = addr + 1; end < limit && ia[end] != ib[end]; end++)
+      ;
+
+    snapshot_print_range(out, a, b, addr, end, r);
+    (*changes)++;
+    addr = end;
+  }
+
+  free(ranges);
+  return MXT_SUCCESS;
+}
+
+//******************************************************************************
+/// \brief  Compare each snapshot with the one before it
+/// \return #mxt_rc
+int mxt_snapshot_diff(struct libmaxtouch_ctx *ctx, int count,
+                      char *filenames[])
+{
+  struct mxt_snapshot snaps[2];
+  struct mxt_snapshot *prev = &snaps[0];
+  struct mxt_snapshot *cur = &snaps[1];
+  struct mxt_snapshot *tmp;
+  double elapsed;
+  int changes;
+  int ret;
+  int i;
+
+  if (count < 2) {
+    mxt_err(ctx, "Need two snapshots to compare");
+    return MXT_ERROR_BAD_INPUT;
+  }
+
+  ret = mxt_snapshot_open(ctx, filenames[0], prev);
+  if (ret)
+    return ret;
+
+  for (i = 1; i < count; i++) {
+    ret = mxt_snapshot_open(ctx, filenames[i], cur);
+    if (ret)
+      break;
+
+    elapsed = (double)((int64_t)cur->time_sec - (int64_t)prev->time_sec)
+              + ((double)cur->time_nsec - (double)prev->time_nsec) / 1e9;
+
+    printf("%s -> %s (%+.3f s)\n", prev->filename, cur->filename, elapsed);
+
+    ret = mxt_snapshot_compare(prev, cur, stdout, &changes);
+    if (ret == MXT_ERROR_UNEXPECTED_DEVICE_STATE) {
+      mxt_err(ctx, "Info blocks differ, %s and %s are not comparable",
+              prev->filename, cur->filename);
+    } else if (ret) {
+      break;
+    } else {
+      printf("%d ranges changed\n", changes);
+    }
+
+    mxt_snapshot_close(prev);
+    tmp = prev;
+    prev = cur;
+    cur = tmp;
+  }
+
+  mxt_snapshot_close(prev);
+  mxt_snapshot_close(cur);
+  return ret;
+}
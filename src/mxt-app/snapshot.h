@@ -0,0 +1,77 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file   snapshot.h
+/// \brief  Snapshots of the whole object memory map and their comparison
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+struct mxt_device;
+struct libmaxtouch_ctx;
+
+/* Identifies snapshot files */
+#define SNAPSHOT_MAGIC           "MXTSNAP1"
+
+/* Largest memory map the 16 bit address space allows */
+#define SNAPSHOT_IMAGE_MAX       0x10000
+
+//******************************************************************************
+/// \brief Snapshot file header, little endian
+///
+/// Followed by info_size bytes of info block and image_size bytes of memory
+/// from address 0. Memory which was not read, such as the message processor,
+/// is zero.
+struct mxt_snapshot_header {
+  char magic[8];
+  uint64_t time_sec;              /* Time taken, CLOCK_REALTIME */
+  uint32_t time_nsec;
+  uint32_t info_size;
+  uint32_t image_size;
+  uint32_t reserved;
+} __attribute__((packed));
+
+//******************************************************************************
+/// \brief Snapshot mapped from a file
+struct mxt_snapshot {
+  const char *filename;
+  uint64_t time_sec;
+  uint32_t time_nsec;
+  uint32_t info_size;
+  uint32_t image_size;
+  const uint8_t *info;
+  const uint8_t *image;
+  void *map;
+  size_t map_len;
+};
+
+int mxt_snapshot(struct mxt_device *mxt, const char *filename);
+int mxt_snapshot_open(struct libmaxtouch_ctx *ctx, const char *filename, struct mxt_snapshot *snap);
+void mxt_snapshot_close(struct mxt_snapshot *snap);
+int mxt_snapshot_compare(const struct mxt_snapshot *a, const struct mxt_snapshot *b, FILE *out, int *changes);
+int mxt_snapshot_diff(struct libmaxtouch_ctx *ctx, int count, char *filenames[]);
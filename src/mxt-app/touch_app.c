@@ -41,6 +41,7 @@
 #include "libmaxtouch/libmaxtouch.h"
 #include "libmaxtouch/info_block.h"
 #include "libmaxtouch/log.h"
+#include "libmaxtouch/hex.h"
 
 #include "mxt_app.h"
 
@@ -51,17 +52,18 @@ static int print_message_hex(struct mxt_device *mxt, uint8_t *msg,
                              void *context, uint8_t size)
 {
   const uint16_t object_type = *((uint16_t*)context);
-  int j;
-  int len;
+  const size_t prefix_len = strlen(MSG_PREFIX);
+  char msg_string[255];
 
   if (object_type == 0 || object_type == mxt_report_id_to_type(mxt, msg[0])) {
-    len = snprintf(mxt->msg_string, sizeof(mxt->msg_string), MSG_PREFIX);
-    for (j = 0; j < size; j++) {
-      len += snprintf(mxt->msg_string + len, sizeof(mxt->msg_string) - len,
-                      "%02X ", msg[j]);
-    }
+    /* Messages which would not fit are truncated */
+    if (size > (sizeof(msg_string) - prefix_len - 1) / 3)
+      size = (sizeof(msg_string) - prefix_len - 1) / 3;
 
-    printf("%s\n", mxt->msg_string);
+    strcpy(msg_string, MSG_PREFIX);
+    *mxt_hex_encode_spaced(msg_string + prefix_len, msg, size) = '\0';
+
+    printf("%s\n", msg_string);
     fflush(stdout);
   }
 
@@ -0,0 +1,445 @@
+//------------------------------------------------------------------------------
+/// \file   bridge_loopback.c
+/// \brief  Bridge protocol latency and throughput test client
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+#include <endian.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+#include "mxt-app/bridge.h"
+
+#define LINE_MAX_LEN 10000
+
+//******************************************************************************
+/// \brief Round trip statistics for one protocol mode
+struct loopback_stats {
+  uint64_t min_ns;
+  uint64_t max_ns;
+  uint64_t total_ns;
+  uint64_t payload_bytes;
+  uint64_t wire_bytes;
+  unsigned int iterations;
+};
+
+//******************************************************************************
+/// \brief Monotonic time in nanoseconds
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//******************************************************************************
+/// \brief Read exactly count bytes
+static int read_full(int fd, void *buf, size_t count)
+{
+  uint8_t *p = buf;
+  ssize_t n;
+
+  while (count > 0) {
+    n = read(fd, p, count);
+    if (n == 0) {
+      fprintf(stderr, "Server closed connection\n");
+      return -1;
+    } else if (n < 0) {
+      if (errno == EINTR)
+        continue;
+
+      fprintf(stderr, "Read error: %s\n", strerror(errno));
+      return -1;
+    }
+
+    p += n;
+    count -= n;
+  }
+
+  return 0;
+}
+
+//******************************************************************************
+/// \brief Write all bytes
+static int write_full(int fd, const void *buf, size_t count)
+{
+  const uint8_t *p = buf;
+  ssize_t n;
+
+  while (count > 0) {
+    n = write(fd, p, count);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+
+      fprintf(stderr, "Write error: %s\n", strerror(errno));
+      return -1;
+    }
+
+    p += n;
+    count -= n;
+  }
+
+  return 0;
+}
+
+//******************************************************************************
+/// \brief Read a newline terminated line, returns length or -1
+static int read_line(int fd, char *line, size_t size)
+{
+  size_t n = 0;
+  char c;
+
+  while (n < size - 1) {
+    if (read_full(fd, &c, 1))
+      return -1;
+
+    if (c == '\n')
+      break;
+
+    if (c != '\r')
+      line[n++] = c;
+  }
+
+  line[n] = '\0';
+  return n;
+}
+
+//******************************************************************************
+/// \brief Record a single round trip
+static void stats_add(struct loopback_stats *stats, uint64_t ns,
+                      size_t payload, size_t wire)
+{
+  if (stats->iterations == 0 || ns < stats->min_ns)
+    stats->min_ns = ns;
+
+  if (ns > stats->max_ns)
+    stats->max_ns = ns;
+
+  stats->total_ns += ns;
+  stats->payload_bytes += payload;
+  stats->wire_bytes += wire;
+  stats->iterations++;
+}
+
+//******************************************************************************
+/// \brief Print statistics for one mode
+static void stats_print(const char *mode, struct loopback_stats *stats)
+{
+  double secs = stats->total_ns / 1e9;
+
+  if (stats->iterations == 0)
+    return;
+
+  printf("%-6s %8u reads  latency us min %8.1f avg %8.1f max %8.1f  "
+         "payload %8.1f KiB/s  wire %8.1f KiB/s\n",
+         mode, stats->iterations,
+         stats->min_ns / 1e3,
+         stats->total_ns / 1e3 / stats->iterations,
+         stats->max_ns / 1e3,
+         stats->payload_bytes / 1024.0 / secs,
+         stats->wire_bytes / 1024.0 / secs);
+}
+
+//******************************************************************************
+/// \brief Time REA round trips using the ASCII protocol
+static int run_ascii(int fd, uint16_t address, uint16_t count,
+                     unsigned int iterations, struct loopback_stats *stats)
+{
+  char *line;
+  char cmd[32];
+  int cmd_len;
+  int len;
+  unsigned int i;
+  uint64_t start;
+
+  line = malloc(LINE_MAX_LEN);
+  if (!line)
+    return -1;
+
+  cmd_len = snprintf(cmd, sizeof(cmd), "REA %u %u\n", address, count);
+
+  for (i = 0; i < iterations; i++) {
+    start = now_ns();
+
+    if (write_full(fd, cmd, cmd_len))
+      goto fail;
+
+    /* Skip any message pushes */
+    do {
+      len = read_line(fd, line, LINE_MAX_LEN);
+      if (len < 0)
+        goto fail;
+    } while (strncmp(line, "RRP ", 4));
+
+    if (!strcmp(line, "RRP ERR")) {
+      fprintf(stderr, "Server returned read error\n");
+      goto fail;
+    }
+
+    stats_add(stats, now_ns() - start, count, cmd_len + len + 1);
+  }
+
+  free(line);
+  return 0;
+
+fail:
+  free(line);
+  return -1;
+}
+
+//******************************************************************************
+/// \brief Time REA round trips using binary frames
+static int run_binary(int fd, uint16_t address, uint16_t count,
+                      unsigned int iterations, struct loopback_stats *stats)
+{
+  struct bridge_frame_hdr req;
+  struct bridge_frame_hdr rsp;
+  uint8_t *payload;
+  uint16_t length;
+  unsigned int i;
+  uint64_t start;
+
+  payload = malloc(BRIDGE_FRAME_MAX_PAYLOAD);
+  if (!payload)
+    return -1;
+
+  memset(&req, 0, sizeof(req));
+  req.opcode = BRIDGE_OP_REA;
+  req.address = htole16(address);
+  req.count = htole16(count);
+
+  for (i = 0; i < iterations; i++) {
+    req.seq = htole16(i);
+    start = now_ns();
+
+    if (write_full(fd, &req, BRIDGE_FRAME_HDR_LEN))
+      goto fail;
+
+    /* Skip any message pushes */
+    do {
+      if (read_full(fd, &rsp, BRIDGE_FRAME_HDR_LEN))
+        goto fail;
+
+      length = le16toh(rsp.length);
+      if (length && read_full(fd, payload, length))
+        goto fail;
+    } while (rsp.opcode != BRIDGE_OP_RRP);
+
+    if (rsp.status != BRIDGE_STATUS_OK) {
+      fprintf(stderr, "Server returned read error\n");
+      goto fail;
+    }
+
+    if (le16toh(rsp.seq) != (uint16_t)i) {
+      fprintf(stderr, "Sequence mismatch\n");
+      goto fail;
+    }
+
+    stats_add(stats, now_ns() - start, count,
+              2 * BRIDGE_FRAME_HDR_LEN + length);
+  }
+
+  free(payload);
+  return 0;
+
+fail:
+  free(payload);
+  return -1;
+}
+
+//******************************************************************************
+/// \brief Connect to bridge server
+static int connect_server(const char *host, uint16_t port)
+{
+  struct hostent *server;
+  struct sockaddr_in serv_addr;
+  struct sockaddr_un unix_addr;
+  const char *path;
+  int one = 1;
+  int fd;
+
+  if (!strncmp(host, BRIDGE_UNIX_PREFIX, strlen(BRIDGE_UNIX_PREFIX))) {
+    path = host + strlen(BRIDGE_UNIX_PREFIX);
+
+    memset(&unix_addr, 0, sizeof(unix_addr));
+    unix_addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(unix_addr.sun_path)) {
+      fprintf(stderr, "Socket path too long\n");
+      return -1;
+    }
+    strcpy(unix_addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      fprintf(stderr, "Socket error: %s\n", strerror(errno));
+      return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&unix_addr, sizeof(unix_addr)) < 0) {
+      fprintf(stderr, "Connect error: %s\n", strerror(errno));
+      close(fd);
+      return -1;
+    }
+
+    return fd;
+  }
+
+  server = gethostbyname(host);
+  if (!server) {
+    fprintf(stderr, "No such host %s\n", host);
+    return -1;
+  }
+
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    fprintf(stderr, "Socket error: %s\n", strerror(errno));
+    return -1;
+  }
+
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  memset(&serv_addr, 0, sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  memcpy(&serv_addr.sin_addr.s_addr, server->h_addr, server->h_length);
+  serv_addr.sin_port = htons(port);
+
+  if (connect(fd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+    fprintf(stderr, "Connect error: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+//******************************************************************************
+/// \brief Print usage
+static void print_usage(const char *prog_name)
+{
+  fprintf(stderr, "Usage: %s [options] [HOST]\n\n"
+          "Measure bridge round trip latency and throughput against a\n"
+          "running \"mxt-app --bridge-server\" (default HOST localhost).\n"
+          "HOST may be unix:PATH to connect to a unix domain socket.\n\n"
+          "  -p PORT       : TCP port (default 4000)\n"
+          "  -r REGISTER   : register address to read (default 0)\n"
+          "  -n COUNT      : bytes per read (default 64)\n"
+          "  -i ITERATIONS : round trips per mode (default 1000)\n",
+          prog_name);
+}
+
+//******************************************************************************
+/// \brief Main function for bridge loopback test client
+int main(int argc, char *argv[])
+{
+  struct loopback_stats ascii_stats = { 0 };
+  struct loopback_stats binary_stats = { 0 };
+  const char *host = "localhost";
+  uint16_t port = 4000;
+  uint16_t address = 0;
+  uint16_t count = 64;
+  unsigned int iterations = 1000;
+  char line[64];
+  int fd;
+  int c;
+  int ret = EXIT_FAILURE;
+
+  while ((c = getopt(argc, argv, "hi:n:p:r:")) != -1) {
+    switch (c) {
+    case 'i':
+      iterations = strtoul(optarg, NULL, 0);
+      break;
+    case 'n':
+      count = strtoul(optarg, NULL, 0);
+      break;
+    case 'p':
+      port = strtoul(optarg, NULL, 0);
+      break;
+    case 'r':
+      address = strtoul(optarg, NULL, 0);
+      break;
+    case 'h':
+    default:
+      print_usage(argv[0]);
+      return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  if (optind < argc)
+    host = argv[optind];
+
+  fd = connect_server(host, port);
+  if (fd < 0)
+    return EXIT_FAILURE;
+
+  /* Wait for chip attach */
+  do {
+    if (read_line(fd, line, sizeof(line)) < 0)
+      goto close;
+  } while (strcmp(line, "CAT"));
+
+  if (run_ascii(fd, address, count, iterations, &ascii_stats))
+    goto close;
+
+  if (write_full(fd, BRIDGE_BINARY_CMD "\n", strlen(BRIDGE_BINARY_CMD) + 1))
+    goto close;
+
+  do {
+    if (read_line(fd, line, sizeof(line)) < 0)
+      goto close;
+  } while (strcmp(line, BRIDGE_BINARY_OK));
+
+  if (run_binary(fd, address, count, iterations, &binary_stats))
+    goto close;
+
+  stats_print("ascii", &ascii_stats);
+  stats_print("binary", &binary_stats);
+
+  if (binary_stats.total_ns > 0)
+    printf("binary speedup %.2fx\n",
+           (double)ascii_stats.total_ns / binary_stats.total_ns);
+
+  ret = EXIT_SUCCESS;
+
+close:
+  close(fd);
+  return ret;
+}
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+/// \file   hex_bench.c
+/// \brief  Hex codec throughput benchmark
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/hex.h"
+
+//******************************************************************************
+/// \brief Monotonic time in nanoseconds
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//******************************************************************************
+/// \brief Print throughput of one codec in MB/s of binary data
+static void report(const char *name, size_t bytes, unsigned int iterations,
+                   uint64_t ns)
+{
+  printf("%-16s %10.1f MB/s\n", name,
+         (double)bytes * iterations * 1000.0 / (ns ? ns : 1));
+}
+
+//******************************************************************************
+/// \brief Encode with one sprintf per byte, as before the shared codec
+static void sprintf_encode(char *out, const uint8_t *in, size_t len)
+{
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    sprintf(out + 2 * i, "%02X", in[i]);
+}
+
+//******************************************************************************
+/// \brief Decode with one sscanf per byte
+static int sscanf_decode(uint8_t *out, const char *in, size_t len)
+{
+  unsigned int value;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    if (sscanf(in + 2 * i, "%2x", &value) != 1)
+      return -1;
+
+    out[i] = value;
+  }
+
+  return 0;
+}
+
+static void print_usage(const char *prog_name)
+{
+  fprintf(stderr, "Usage: %s [options]\n\n"
+          "Measure hex encode and decode throughput.\n\n"
+          "  -n COUNT      : bytes per buffer (default 4096)\n"
+          "  -i ITERATIONS : conversions per codec (default 10000)\n",
+          prog_name);
+}
+
+//******************************************************************************
+/// \brief Main function for hex codec benchmark
+int main(int argc, char *argv[])
+{
+  size_t count = 4096;
+  unsigned int iterations = 10000;
+  unsigned int i;
+  uint8_t *data, *decoded;
+  char *hex;
+  uint64_t start;
+  int ret = EXIT_FAILURE;
+  int c;
+
+  while ((c = getopt(argc, argv, "hi:n:")) != -1) {
+    switch (c) {
+    case 'i':
+      iterations = strtoul(optarg, NULL, 0);
+      break;
+    case 'n':
+      count = strtoul(optarg, NULL, 0);
+      break;
+    case 'h':
+    default:
+      print_usage(argv[0]);
+      return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  data = malloc(count);
+  decoded = malloc(count);
+  hex = malloc(count * 2 + 1);
+  if (!data || !decoded || !hex) {
+    fprintf(stderr, "Failed to allocate memory\n");
+    goto free;
+  }
+
+  for (i = 0; i < count; i++)
+    data[i] = rand();
+
+  printf("%zu bytes, %u iterations\n", count, iterations);
+
+  start = now_ns();
+  for (i = 0; i < iterations; i++)
+    sprintf_encode(hex, data, count);
+  report("sprintf encode", count, iterations, now_ns() - start);
+
+  start = now_ns();
+  for (i = 0; i < iterations; i++)
+    mxt_hex_encode(hex, data, count);
+  report("encode", count, iterations, now_ns() - start);
+
+  start = now_ns();
+  for (i = 0; i < iterations; i++)
+    sscanf_decode(decoded, hex, count);
+  report("sscanf decode", count, iterations, now_ns() - start);
+
+  start = now_ns();
+  for (i = 0; i < iterations; i++) {
+    if (mxt_hex_decode(decoded, hex, count) != MXT_SUCCESS) {
+      fprintf(stderr, "Decode failed\n");
+      goto free;
+    }
+  }
+  report("decode", count, iterations, now_ns() - start);
+
+  if (memcmp(data, decoded, count)) {
+    fprintf(stderr, "Round trip mismatch\n");
+    goto free;
+  }
+
+  ret = EXIT_SUCCESS;
+
+free:
+  free(hex);
+  free(decoded);
+  free(data);
+  return ret;
+}
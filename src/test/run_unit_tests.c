@@ -37,7 +37,7 @@
 #include <stdbool.h>
 #include <signal.h>
  
-+include "mxt-app/mxt_app.h"
+#include "mxt-app/mxt_app.h"
 #include "run_unit_tests.h"
 
 	
@@ -48,12 +48,52 @@ int main(int argc, char *argv[])
   /* Test suite */
   const struct CMUnitTest tests[] = {
     unit_test(mxt_convert_hex_test),
+    unit_test(mxt_convert_hex_single_test),
+    unit_test(mxt_hex_round_trip_test),
+    unit_test(mxt_hex_decode_invalid_test),
+    unit_test(mxt_hex_encode_spaced_test),
+    unit_test(mxt_log_async_format_test),
+    unit_test(mxt_log_async_drop_test),
+    unit_test(mxt_log_level_filter_test),
+    unit_test(mxt_stats_record_test),
+    unit_test(mxt_stats_add_test),
+    unit_test(mxt_transport_stats_sysfs_test),
+    unit_test(mxt_trace_span_test),
+    unit_test(mxt_trace_tid_test),
+    unit_test(mxt_frame_layout_test),
+    unit_test(mxt_frame_v4l2_test),
+    unit_test(mxt_conn_refcount_threads_test),
+    unit_test(mxt_device_threads_test),
+    unit_test(mxt_scan_found_test),
+    unit_test(mxt_conn_name_test),
+    unit_test(mxt_sysfs_update_test),
+    unit_test(mxt_snapshot_compare_test),
+    unit_test(mxt_daemon_check_request_test),
+    unit_test(mxt_daemon_request_framing_test),
+    unit_test(mxt_daemon_check_socket_test),
+    unit_test(script_parse_num_test),
+    unit_test(script_parse_object_test),
+    unit_test(script_parse_address_test),
+    unit_test(script_bad_count_test),
     unit_test(validate_sensor_variant_options_test),
     unit_test(get_xyline_data_test),
     unit_test(polyfit_test),
     unit_test(calculate_poly_test),
     unit_test(check_line_test),
     unit_test(sensor_variant_algorithm_test),
+    unit_test(bridge_rx_fragmented_test),
+    unit_test(bridge_rx_concatenated_test),
+    unit_test(bridge_rx_reread_test),
+    unit_test(bridge_rx_line_limit_test),
+    unit_test(bridge_rx_frame_test),
+    unit_test(bridge_rx_closed_test),
+    unit_test(bridge_tx_queue_test),
+    unit_test(bridge_tx_closed_test),
+    unit_test(bridge_msgq_test),
+    unit_test(bridge_rea_merge_fail_test),
+    unit_test(bridge_stream_oversize_test),
+    unit_test(bridge_stats_format_test),
+    unit_test(bridge_stats_format_empty_test),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
@@ -39,9 +39,49 @@ int init_mxt_touchscreen_info_struct(struct mxt_device *mxt,
 
 /* test functions */
 void mxt_convert_hex_test(void **state);
+void mxt_convert_hex_single_test(void **state);
+void mxt_hex_round_trip_test(void **state);
+void mxt_hex_decode_invalid_test(void **state);
+void mxt_hex_encode_spaced_test(void **state);
+void mxt_log_async_format_test(void **state);
+void mxt_log_async_drop_test(void **state);
+void mxt_log_level_filter_test(void **state);
+void mxt_stats_record_test(void **state);
+void mxt_stats_add_test(void **state);
+void mxt_transport_stats_sysfs_test(void **state);
+void mxt_trace_span_test(void **state);
+void mxt_trace_tid_test(void **state);
+void mxt_frame_layout_test(void **state);
+void mxt_frame_v4l2_test(void **state);
+void mxt_conn_refcount_threads_test(void **state);
+void mxt_device_threads_test(void **state);
+void mxt_scan_found_test(void **state);
+void mxt_conn_name_test(void **state);
+void mxt_sysfs_update_test(void **state);
+void mxt_snapshot_compare_test(void **state);
+void mxt_daemon_check_request_test(void **state);
+void mxt_daemon_request_framing_test(void **state);
+void mxt_daemon_check_socket_test(void **state);
+void script_parse_num_test(void **state);
+void script_parse_object_test(void **state);
+void script_parse_address_test(void **state);
+void script_bad_count_test(void **state);
 void validate_sensor_variant_options_test(void **state);
 void get_xyline_data_test(void **state);
 void sensor_variant_algorithm_test(void **state);
 void calculate_poly_test(void **state);
 void check_line_test(void **state);
 void polyfit_test(void **state);
+void bridge_rx_fragmented_test(void **state);
+void bridge_rx_concatenated_test(void **state);
+void bridge_rx_reread_test(void **state);
+void bridge_rx_line_limit_test(void **state);
+void bridge_rx_frame_test(void **state);
+void bridge_rx_closed_test(void **state);
+void bridge_tx_queue_test(void **state);
+void bridge_tx_closed_test(void **state);
+void bridge_msgq_test(void **state);
+void bridge_rea_merge_fail_test(void **state);
+void bridge_stream_oversize_test(void **state);
+void bridge_stats_format_test(void **state);
+void bridge_stats_format_empty_test(void **state);
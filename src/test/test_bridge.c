@@ -0,0 +1,728 @@
+//------------------------------------------------------------------------------
+/// \file   test_bridge.c
+/// \brief  Tests against mxt-app/bridge.h socket buffers
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <endian.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/info_block.h"
+#include "libmaxtouch/log.h"
+
+#include "mxt-app/bridge.h"
+#include "run_unit_tests.h"
+
+struct bridge_test_ctx {
+  struct libmaxtouch_ctx ctx;
+  struct mxt_device mxt;
+  struct bridge_rxbuf rx;
+  struct bridge_txbuf tx;
+  int fds[2];
+};
+
+static void bridge_test_setup(struct bridge_test_ctx *t)
+{
+  int ret;
+
+  t->ctx.log_level = LOG_SILENT;
+  t->ctx.log_fn = mxt_log_stdout;
+  t->mxt.ctx = &t->ctx;
+
+  ret = socketpair(AF_UNIX, SOCK_STREAM, 0, t->fds);
+  assert_int_equal(ret, 0);
+
+  ret = bridge_rx_init(&t->rx, t->fds[1]);
+  assert_int_equal(ret, MXT_SUCCESS);
+
+  bridge_tx_init(&t->tx, t->fds[1]);
+}
+
+static void bridge_test_teardown(struct bridge_test_ctx *t)
+{
+  bridge_rx_free(&t->rx);
+  bridge_tx_free(&t->tx);
+  close(t->fds[0]);
+  close(t->fds[1]);
+}
+
+static void bridge_test_send(struct bridge_test_ctx *t, const void *buf, size_t len)
+{
+  assert_int_equal(write(t->fds[0], buf, len), len);
+}
+
+void bridge_rx_fragmented_test(void **state)
+{
+  struct bridge_test_ctx t;
+  char *line;
+  int ret;
+
+  bridge_test_setup(&t);
+
+  bridge_test_send(&t, "REA 1", 5);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  bridge_test_send(&t, "0 4", 3);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  bridge_test_send(&t, "\nWRI", 4);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "REA 10 4");
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  /* Partial line is kept when buffer is compacted */
+  bridge_test_send(&t, " 5 AB\n", 6);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "WRI 5 AB");
+
+  bridge_test_teardown(&t);
+}
+
+void bridge_rx_concatenated_test(void **state)
+{
+  struct bridge_test_ctx t;
+  const char *input = "SAT\nREA 0 4\r\nWRI 5 AABB\nMSG";
+  char *line;
+  int ret;
+
+  bridge_test_setup(&t);
+
+  bridge_test_send(&t, input, strlen(input));
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "SAT");
+
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "REA 0 4");
+
+  /* CR LF gives an empty line */
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "");
+
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "WRI 5 AABB");
+
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  bridge_test_send(&t, "CFG 0\n", 6);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "MSGCFG 0");
+
+  bridge_test_teardown(&t);
+}
+
+void bridge_rx_reread_test(void **state)
+{
+  struct bridge_test_ctx t;
+  const char *input = "#1 REA 0 4\r\n#2 REA 4 4\n";
+  size_t mark;
+  char *line;
+  int ret;
+
+  bridge_test_setup(&t);
+
+  bridge_test_send(&t, input, strlen(input));
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "#1 REA 0 4");
+
+  /* Look ahead past the empty line and back again */
+  mark = t.rx.start;
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "");
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "#2 REA 4 4");
+  t.rx.start = mark;
+
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "");
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "#2 REA 4 4");
+
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  bridge_test_teardown(&t);
+}
+
+void bridge_rx_line_limit_test(void **state)
+{
+  struct bridge_test_ctx t;
+  char buf[BRIDGE_MAX_LINESIZE + 2];
+  char *line;
+  int ret;
+
+  bridge_test_setup(&t);
+
+  /* Longest allowed line */
+  memset(buf, 'A', BRIDGE_MAX_LINESIZE);
+  buf[BRIDGE_MAX_LINESIZE] = '\n';
+  bridge_test_send(&t, buf, BRIDGE_MAX_LINESIZE + 1);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_int_equal(strlen(line), BRIDGE_MAX_LINESIZE);
+
+  /* One byte too long, terminator already received */
+  memset(buf, 'A', BRIDGE_MAX_LINESIZE + 1);
+  buf[BRIDGE_MAX_LINESIZE + 1] = '\n';
+  bridge_test_send(&t, buf, BRIDGE_MAX_LINESIZE + 2);
+  bridge_test_send(&t, "SAT\n", 4);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_PROTOCOL_FAULT);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "SAT");
+
+  /* Terminator arrives in a later recv, rest of line is discarded */
+  bridge_test_send(&t, buf, BRIDGE_MAX_LINESIZE + 1);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_PROTOCOL_FAULT);
+
+  bridge_test_send(&t, "AAAA", 4);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  bridge_test_send(&t, "AA\nSDT\n", 7);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "SDT");
+
+  bridge_test_teardown(&t);
+}
+
+void bridge_rx_frame_test(void **state)
+{
+  struct bridge_test_ctx t;
+  struct bridge_frame_hdr hdr;
+  uint8_t frame[BRIDGE_FRAME_HDR_LEN + 3];
+  uint8_t *payload;
+  char *line;
+  int ret;
+
+  bridge_test_setup(&t);
+
+  hdr.length = htole16(3);
+  hdr.opcode = BRIDGE_OP_WRI;
+  hdr.status = 0;
+  hdr.seq = htole16(0x1234);
+  hdr.address = htole16(0x0150);
+  hdr.count = htole16(3);
+  memcpy(frame, &hdr, BRIDGE_FRAME_HDR_LEN);
+  memcpy(frame + BRIDGE_FRAME_HDR_LEN, "\x01\x02\x03", 3);
+
+  /* Line followed by start of frame */
+  bridge_test_send(&t, "BIN\n", 4);
+  bridge_test_send(&t, frame, 6);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "BIN");
+  ret = bridge_rx_getframe(&t.mxt, &t.rx, &hdr, &payload);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  /* Header complete, payload split */
+  bridge_test_send(&t, frame + 6, BRIDGE_FRAME_HDR_LEN - 6 + 1);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getframe(&t.mxt, &t.rx, &hdr, &payload);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  /* Remainder plus a second frame with no payload */
+  bridge_test_send(&t, frame + BRIDGE_FRAME_HDR_LEN + 1, 2);
+  frame[0] = 0;
+  frame[2] = BRIDGE_OP_RST;
+  bridge_test_send(&t, frame, BRIDGE_FRAME_HDR_LEN);
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+
+  ret = bridge_rx_getframe(&t.mxt, &t.rx, &hdr, &payload);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_int_equal(hdr.opcode, BRIDGE_OP_WRI);
+  assert_int_equal(hdr.length, 3);
+  assert_int_equal(hdr.seq, 0x1234);
+  assert_int_equal(hdr.address, 0x0150);
+  assert_memory_equal(payload, "\x01\x02\x03", 3);
+
+  ret = bridge_rx_getframe(&t.mxt, &t.rx, &hdr, &payload);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_int_equal(hdr.opcode, BRIDGE_OP_RST);
+  assert_int_equal(hdr.length, 0);
+
+  ret = bridge_rx_getframe(&t.mxt, &t.rx, &hdr, &payload);
+  assert_int_equal(ret, MXT_ERROR_NO_MESSAGE);
+
+  bridge_test_teardown(&t);
+}
+
+void bridge_rx_closed_test(void **state)
+{
+  struct bridge_test_ctx t;
+  char *line;
+  int ret;
+
+  bridge_test_setup(&t);
+
+  bridge_test_send(&t, "SAT\n", 4);
+  close(t.fds[0]);
+
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_SUCCESS);
+  ret = bridge_rx_getline(&t.mxt, &t.rx, &line);
+  assert_int_equal(ret, MXT_SUCCESS);
+  assert_string_equal(line, "SAT");
+
+  ret = bridge_rx_fill(&t.mxt, &t.rx);
+  assert_int_equal(ret, MXT_ERROR_CONNECTION_FAILURE);
+
+  bridge_rx_free(&t.rx);
+  bridge_tx_free(&t.tx);
+  close(t.fds[1]);
+}
+
+void bridge_tx_queue_test(void **state)
+{
+  struct bridge_test_ctx t;
+  struct iovec iov[2];
+  uint8_t hdr[4];
+  uint8_t chunk[1000];
+  uint8_t rxbuf[4096];
+  size_t total = 0;
+  size_t received = 0;
+  ssize_t count;
+  int sndbuf = 4096;
+  int ret;
+  int i, j;
+
+  bridge_test_setup(&t);
+  setsockopt(t.fds[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+  /* Queue far more than the socket accepts, peer not reading */
+  for (i = 0; i < 256; i++) {
+    hdr[0] = i;
+    hdr[1] = i + 1;
+    hdr[2] = i + 2;
+    hdr[3] = i + 3;
+
+    for (j = 0; j < (int)sizeof(chunk); j++)
+      chunk[j] = i + 4 + j;
+
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = chunk;
+    iov[1].iov_len = sizeof(chunk);
+
+    ret = bridge_tx_writev(&t.mxt, &t.tx, iov, 2);
+    assert_int_equal(ret, MXT_SUCCESS);
+    total += sizeof(hdr) + sizeof(chunk);
+  }
+
+  assert_true(bridge_tx_pending(&t.tx) > 0);
+  assert_true(bridge_tx_pending(&t.tx) < total);
+
+  /* Each record is a run of incrementing bytes, check order is kept */
+  while (received < total) {
+    count = read(t.fds[0], rxbuf, sizeof(rxbuf));
+    assert_true(count > 0);
+
+    for (j = 0; j < count; j++) {
+      size_t pos = received + j;
+      uint8_t expected = (pos / 1004) + (pos % 1004);
+      assert_int_equal(rxbuf[j], expected);
+    }
+
+    received += count;
+
+    ret = bridge_tx_flush(&t.mxt, &t.tx);
+    assert_int_equal(ret, MXT_SUCCESS);
+  }
+
+  assert_int_equal(bridge_tx_pending(&t.tx), 0);
+
+  bridge_test_teardown(&t);
+}
+
+void bridge_tx_closed_test(void **state)
+{
+  struct bridge_test_ctx t;
+  struct iovec iov;
+  char reply[] = "RRP ERR\n";
+  int ret;
+
+  bridge_test_setup(&t);
+  close(t.fds[0]);
+
+  iov.iov_base = reply;
+  iov.iov_len = strlen(reply);
+
+  ret = bridge_tx_writev(&t.mxt, &t.tx, &iov, 1);
+  assert_int_equal(ret, MXT_ERROR_CONNECTION_FAILURE);
+  assert_int_equal(bridge_tx_pending(&t.tx), 0);
+
+  bridge_rx_free(&t.rx);
+  bridge_tx_free(&t.tx);
+  close(t.fds[1]);
+}
+
+void bridge_msgq_test(void **state)
+{
+  struct bridge_msgq q;
+  const uint8_t move1[] = { 5, 0x90, 0x10, 0x20 };
+  const uint8_t move2[] = { 5, 0x90, 0x11, 0x21 };
+  const uint8_t move3[] = { 5, 0x90, 0x12, 0x22 };
+  const uint8_t other[] = { 6, 0x90, 0x30, 0x40 };
+  const uint8_t release[] = { 5, 0x20, 0x12, 0x22 };
+  const uint8_t press[] = { 5, 0xC0, 0x13, 0x23 };
+  const uint8_t expected[] = {
+    4, 5, 0x90, 0x12, 0x22,
+    4, 6, 0x90, 0x30, 0x40,
+    4, 5, 0x20, 0x12, 0x22,
+    4, 5, 0xC0, 0x13, 0x23,
+    4, 5, 0x90, 0x12, 0x22,
+  };
+  uint8_t big[BRIDGE_MSG_MAX + 1] = { 0 };
+  int i;
+
+  memset(&q, 0, sizeof(q));
+
+  assert_int_equal(bridge_msgq_add(&q, move1, sizeof(move1), true), MXT_SUCCESS);
+  assert_int_equal(bridge_msgq_add(&q, other, sizeof(other), true), MXT_SUCCESS);
+  assert_int_equal(bridge_msgq_add(&q, move2, sizeof(move2), true), MXT_SUCCESS);
+  assert_int_equal(bridge_msgq_add(&q, move3, sizeof(move3), true), MXT_SUCCESS);
+  assert_int_equal(q.count, 2);
+  assert_int_equal(q.merged, 2);
+
+  /* Events are kept, and position updates are not merged across them */
+  assert_int_equal(bridge_msgq_add(&q, release, sizeof(release), false), MXT_SUCCESS);
+  assert_int_equal(bridge_msgq_add(&q, press, sizeof(press), false), MXT_SUCCESS);
+  assert_int_equal(bridge_msgq_add(&q, move3, sizeof(move3), true), MXT_SUCCESS);
+  assert_int_equal(q.count, 5);
+  assert_int_equal(q.merged, 2);
+  assert_int_equal(q.length, sizeof(expected));
+  assert_memory_equal(q.data, expected, sizeof(expected));
+
+  assert_int_equal(bridge_msgq_add(&q, big, sizeof(big), false),
+                   MXT_ERROR_BAD_INPUT);
+
+  bridge_msgq_clear(&q);
+  assert_int_equal(q.count, 0);
+  assert_int_equal(q.length, 0);
+  assert_int_equal(q.merged, 2);
+
+  for (i = 0; i < BRIDGE_MSGQ_MAX_MSGS; i++)
+    assert_int_equal(bridge_msgq_add(&q, press, sizeof(press), false),
+                     MXT_SUCCESS);
+
+  assert_int_equal(bridge_msgq_add(&q, press, sizeof(press), false),
+                   MXT_ERROR_NO_MEM);
+}
+
+/* Bridge run against a fake sysfs device, connected to the test as client */
+struct bridge_peer {
+  struct libmaxtouch_ctx *ctx;
+  struct mxt_conn_info *conn;
+  struct mxt_device *mxt;
+  char root[32];
+  char dev[64];
+  char path[80];
+  pthread_t thread;
+  int listenfd;
+  int fd;
+  int ret;
+};
+
+static void *bridge_peer_thread(void *arg)
+{
+  struct bridge_peer *p = arg;
+
+  p->ret = mxt_socket_client_unix(p->mxt, p->path);
+  return NULL;
+}
+
+//******************************************************************************
+/// \brief Start bridge on a device whose mem_access holds mem_len bytes
+static void bridge_peer_start(struct bridge_peer *p, size_t mem_len)
+{
+  struct sockaddr_un addr = { AF_UNIX };
+  struct timeval tv = { 5, 0 };
+  char file[96];
+  uint8_t *mem;
+  FILE *fp;
+  size_t i;
+
+  memset(p, 0, sizeof(*p));
+  strcpy(p->root, "/tmp/mxt_bridge_XXXXXX");
+  assert_non_null(mkdtemp(p->root));
+  snprintf(p->dev, sizeof(p->dev), "%s/atmel_mxt_ts", p->root);
+  assert_int_equal(mkdir(p->dev, 0755), 0);
+  strcat(p->dev, "/2-004a");
+  assert_int_equal(mkdir(p->dev, 0755), 0);
+
+  mem = malloc(mem_len);
+  assert_non_null(mem);
+  for (i = 0; i < mem_len; i++)
+    mem[i] = i;
+
+  snprintf(file, sizeof(file), "%s/mem_access", p->dev);
+  fp = fopen(file, "w");
+  assert_non_null(fp);
+  assert_int_equal(fwrite(mem, 1, mem_len, fp), mem_len);
+  fclose(fp);
+  free(mem);
+
+  snprintf(file, sizeof(file), "%s/debug_enable", p->dev);
+  fp = fopen(file, "w");
+  assert_non_null(fp);
+  fputs("0", fp);
+  fclose(fp);
+
+  assert_int_equal(mxt_new(&p->ctx), MXT_SUCCESS);
+  p->ctx->log_level = LOG_SILENT;
+  p->ctx->sysfs_root = p->root;
+  assert_int_equal(mxt_scan(p->ctx, &p->conn, false), MXT_SUCCESS);
+  assert_int_equal(mxt_new_device(p->ctx, p->conn, &p->mxt), MXT_SUCCESS);
+
+  snprintf(p->path, sizeof(p->path), "%s/bridge.sock", p->root);
+  strcpy(addr.sun_path, p->path);
+  p->listenfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  assert_true(p->listenfd >= 0);
+  assert_int_equal(bind(p->listenfd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+  assert_int_equal(listen(p->listenfd, 1), 0);
+
+  assert_int_equal(pthread_create(&p->thread, NULL, bridge_peer_thread, p), 0);
+
+  p->fd = accept(p->listenfd, NULL, NULL);
+  assert_true(p->fd >= 0);
+  setsockopt(p->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+//******************************************************************************
+/// \brief Read one line from the bridge, without the newline
+static void bridge_peer_getline(struct bridge_peer *p, char *buf, size_t len)
+{
+  size_t i;
+
+  for (i = 0; i < len - 1; i++) {
+    assert_int_equal(read(p->fd, buf + i, 1), 1);
+    if (buf[i] == '\n')
+      break;
+  }
+
+  buf[i] = '\0';
+}
+
+static void bridge_peer_send(struct bridge_peer *p, const char *str)
+{
+  assert_int_equal(write(p->fd, str, strlen(str)), strlen(str));
+}
+
+//******************************************************************************
+/// \brief Disconnect, which ends the bridge, and remove the fake device
+static void bridge_peer_stop(struct bridge_peer *p)
+{
+  char file[96];
+
+  close(p->fd);
+  pthread_join(p->thread, NULL);
+  close(p->listenfd);
+
+  mxt_free_device(p->mxt);
+  mxt_unref_conn(p->conn);
+  mxt_free(p->ctx);
+
+  unlink(p->path);
+  snprintf(file, sizeof(file), "%s/mem_access", p->dev);
+  unlink(file);
+  snprintf(file, sizeof(file), "%s/debug_enable", p->dev);
+  unlink(file);
+  rmdir(p->dev);
+  *strrchr(p->dev, '/') = '\0';
+  rmdir(p->dev);
+  rmdir(p->root);
+}
+
+void bridge_rea_merge_fail_test(void **state)
+{
+  struct bridge_peer p;
+  struct mxt_transport_stats stats;
+  char line[64];
+
+  bridge_peer_start(&p, 6);
+
+  bridge_peer_getline(&p, line, sizeof(line));
+  assert_string_equal(line, "CAT");
+
+  bridge_peer_send(&p, "PIPE\n");
+  bridge_peer_getline(&p, line, sizeof(line));
+  assert_string_equal(line, BRIDGE_PIPE_OK);
+
+  /* Each read is in range, but the merged read runs past the end */
+  bridge_peer_send(&p, "#a REA 0 4\n#b REA 4 4\n");
+  bridge_peer_getline(&p, line, sizeof(line));
+  assert_string_equal(line, "#a RRP ERR");
+  bridge_peer_getline(&p, line, sizeof(line));
+  assert_string_equal(line, "#b RRP ERR");
+
+  /* The failed read was not repeated request by request */
+  mxt_get_transport_stats(p.mxt, &stats);
+  assert_int_equal(stats.latency[MXT_STATS_READ].count, 1);
+
+  bridge_peer_send(&p, "#c REA 2 4\n");
+  bridge_peer_getline(&p, line, sizeof(line));
+  assert_string_equal(line, "#c RRP 02030405");
+
+  bridge_peer_stop(&p);
+  assert_int_equal(p.ret, MXT_SUCCESS);
+}
+
+//******************************************************************************
+/// \brief Send binary request frame with no payload
+static void bridge_peer_send_frame(struct bridge_peer *p, uint8_t opcode,
+                                   uint16_t seq, uint16_t address)
+{
+  struct bridge_frame_hdr hdr;
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.opcode = opcode;
+  hdr.seq = htole16(seq);
+  hdr.address = htole16(address);
+  assert_int_equal(write(p->fd, &hdr, BRIDGE_FRAME_HDR_LEN),
+                   BRIDGE_FRAME_HDR_LEN);
+}
+
+//******************************************************************************
+/// \brief Receive binary reply frame header, discarding any payload
+static void bridge_peer_get_frame(struct bridge_peer *p,
+                                  struct bridge_frame_hdr *hdr)
+{
+  uint8_t payload[64];
+
+  assert_int_equal(read(p->fd, hdr, BRIDGE_FRAME_HDR_LEN),
+                   BRIDGE_FRAME_HDR_LEN);
+  assert_true(le16toh(hdr->length) <= sizeof(payload));
+  if (hdr->length)
+    assert_int_equal(read(p->fd, payload, le16toh(hdr->length)),
+                     le16toh(hdr->length));
+}
+
+void bridge_stream_oversize_test(void **state)
+{
+  struct bridge_peer p;
+  struct bridge_frame_hdr hdr;
+  struct mxt_id_info id;
+  struct mxt_object objects[] = {
+    { GEN_COMMANDPROCESSOR_T6, 0x00, 0x00, 5, 0, 1 },
+    { DEBUG_DIAGNOSTIC_T37, 0x00, 0x01, 129, 0, 0 },
+  };
+  char line[64];
+
+  bridge_peer_start(&p, 4);
+
+  /* 200 x 200 values do not fit in one binary frame */
+  memset(&id, 0, sizeof(id));
+  id.family = 0xA4;
+  id.matrix_x_size = 200;
+  id.matrix_y_size = 200;
+  id.num_objects = 2;
+  p.mxt->info.id = &id;
+  p.mxt->info.objects = objects;
+  assert_int_equal(mxt_frame_set_v4l2_node(p.mxt, ""), MXT_SUCCESS);
+
+  bridge_peer_getline(&p, line, sizeof(line));
+  assert_string_equal(line, "CAT");
+
+  bridge_peer_send(&p, "BIN\n");
+  bridge_peer_getline(&p, line, sizeof(line));
+  assert_string_equal(line, "BIN OK");
+
+  bridge_peer_send_frame(&p, BRIDGE_OP_STREAM, 7, DELTAS_MODE);
+  bridge_peer_get_frame(&p, &hdr);
+  assert_int_equal(hdr.opcode, BRIDGE_OP_STREAMRP);
+  assert_int_equal(hdr.status, BRIDGE_STATUS_ERR);
+  assert_int_equal(le16toh(hdr.seq), 7);
+
+  /* Connection carries on, with no frames pushed */
+  bridge_peer_send_frame(&p, BRIDGE_OP_RST, 8, 0);
+  bridge_peer_get_frame(&p, &hdr);
+  assert_int_equal(hdr.opcode, BRIDGE_OP_RSTRP);
+  assert_int_equal(le16toh(hdr.seq), 8);
+
+  bridge_peer_stop(&p);
+  assert_int_equal(p.ret, MXT_SUCCESS);
+}
@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+/// \file   test_bridge_stats.c
+/// \brief  Tests against mxt-app/bridge_stats.h
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+
+#include "mxt-app/bridge_stats.h"
+#include "run_unit_tests.h"
+
+void bridge_stats_format_test(void **state)
+{
+  struct bridge_stats stats;
+  char buf[512];
+  char small[16];
+  size_t len;
+
+  bridge_stats_init(&stats);
+  assert_int_equal(bridge_stats_timeout(&stats, stats.start_us), -1);
+
+  stats.bytes_in = 10;
+  stats.bytes_out = 20;
+  stats.msgs_pushed = 4;
+  stats.msgs_merged = 3;
+  bridge_stats_record(&stats, BRIDGE_STAT_REA, 12, 3);
+  bridge_stats_record(&stats, BRIDGE_STAT_NONE, 12, 3);
+
+  len = bridge_stats_format(&stats, stats.start_us + 2000000,
+                            buf, sizeof(buf));
+  assert_int_equal(len, strlen(buf));
+  assert_string_equal(buf, "uptime=2.000 in=10 out=20 msgs=4 msg_rate=2.0 merged=3 "
+                      "REA n=1 dev=12/12/12/12 sock=3/3/3/3 "
+                      "dev_hist=0,0,0,1 sock_hist=0,1 "
+                      "WRI n=0 RST n=0 MSGCFG n=0");
+
+  len = bridge_stats_format(&stats, stats.start_us, small, sizeof(small));
+  assert_int_equal(len, sizeof(small) - 1);
+  assert_int_equal(strlen(small), sizeof(small) - 1);
+
+  /* Report due once the interval has passed */
+  assert_int_equal(bridge_stats_timeout(&stats, stats.start_us + 1000),
+                   BRIDGE_STATS_INTERVAL_MS - 1);
+  assert_int_equal(bridge_stats_timeout(&stats, stats.start_us
+                                        + BRIDGE_STATS_INTERVAL_MS * 1000), 0);
+}
+
+void bridge_stats_format_empty_test(void **state)
+{
+  struct bridge_stats stats;
+  char buf[1] = { 'x' };
+
+  bridge_stats_init(&stats);
+
+  /* Nothing is written without room for the terminator */
+  assert_int_equal(bridge_stats_format(&stats, stats.start_us, buf, 0), 0);
+  assert_int_equal(buf[0], 'x');
+
+  assert_int_equal(bridge_stats_format(&stats, stats.start_us, buf, 1), 0);
+  assert_int_equal(buf[0], '\0');
+}
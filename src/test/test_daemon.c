@@ -0,0 +1,186 @@
+//------------------------------------------------------------------------------
+/// \file   test_daemon.c
+/// \brief  Tests against mxt-app daemon requests
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "mxt-app/daemon.h"
+#include "run_unit_tests.h"
+
+void mxt_daemon_check_request_test(void **state)
+{
+  struct daemon_request *req = calloc(1, sizeof(*req));
+
+  assert_non_null(req);
+
+  req->magic = DAEMON_MAGIC;
+  req->cmd = CMD_WRITE;
+  req->argc = 2;
+  memcpy(req->args, "01\0ff", 6);
+  assert_int_equal(daemon_check_request(req), MXT_SUCCESS);
+
+  /* Only short commands are accepted */
+  req->cmd = CMD_FLASH;
+  assert_int_equal(daemon_check_request(req), MXT_ERROR_PROTOCOL_FAULT);
+  req->cmd = CMD_WRITE;
+
+  req->magic = 0;
+  assert_int_equal(daemon_check_request(req), MXT_ERROR_PROTOCOL_FAULT);
+  req->magic = DAEMON_MAGIC;
+
+  /* More arguments than are terminated in the buffer */
+  req->argc = 3;
+  memset(req->args + 6, 'a', sizeof(req->args) - 6);
+  assert_int_equal(daemon_check_request(req), MXT_ERROR_PROTOCOL_FAULT);
+
+  req->argc = sizeof(req->args) + 1;
+  memset(req->args, 0, sizeof(req->args));
+  assert_int_equal(daemon_check_request(req), MXT_ERROR_PROTOCOL_FAULT);
+
+  /* File name is always terminated */
+  req->argc = 0;
+  memset(req->filename, 'a', sizeof(req->filename));
+  assert_int_equal(daemon_check_request(req), MXT_SUCCESS);
+  assert_int_equal(req->filename[sizeof(req->filename) - 1], '\0');
+
+  free(req);
+}
+
+void mxt_daemon_request_framing_test(void **state)
+{
+  struct daemon_request *req = calloc(1, sizeof(*req));
+  struct daemon_request *rx = calloc(1, sizeof(*rx));
+  int sv[2];
+  int out[2];
+  int err[2];
+  int fds[2];
+  int send_fds[2];
+  char buf[8];
+
+  assert_non_null(req);
+  assert_non_null(rx);
+  assert_int_equal(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv), 0);
+  assert_int_equal(pipe(out), 0);
+  assert_int_equal(pipe(err), 0);
+
+  /* The other end of a socket pair is this process */
+  assert_int_equal(daemon_check_peer(sv[1], 0600), MXT_SUCCESS);
+
+  req->magic = DAEMON_MAGIC;
+  req->cmd = CMD_READ;
+  req->object_type = 7;
+  req->count = 4;
+  send_fds[0] = out[1];
+  send_fds[1] = err[1];
+  assert_int_equal(daemon_send_request(sv[0], req, send_fds), MXT_SUCCESS);
+  assert_int_equal(daemon_recv_request(sv[1], rx, fds), MXT_SUCCESS);
+  assert_int_equal(rx->cmd, CMD_READ);
+  assert_int_equal(rx->object_type, 7);
+  assert_int_equal(rx->count, 4);
+
+  /* Descriptors received lead to the sender's pipes */
+  assert_int_equal(write(fds[0], "out", 3), 3);
+  assert_int_equal(write(fds[1], "err", 3), 3);
+  assert_int_equal(read(out[0], buf, sizeof(buf)), 3);
+  assert_memory_equal(buf, "out", 3);
+  assert_int_equal(read(err[0], buf, sizeof(buf)), 3);
+  assert_memory_equal(buf, "err", 3);
+  close(fds[0]);
+  close(fds[1]);
+
+  /* A request which fails the checks is refused */
+  req->cmd = CMD_FLASH;
+  assert_int_equal(daemon_send_request(sv[0], req, send_fds), MXT_SUCCESS);
+  assert_int_equal(daemon_recv_request(sv[1], rx, fds), MXT_ERROR_PROTOCOL_FAULT);
+  assert_int_equal(fds[0], -1);
+  assert_int_equal(fds[1], -1);
+
+  /* So is a short packet, or one without descriptors */
+  assert_int_equal(send(sv[0], req, 16, 0), 16);
+  assert_int_equal(daemon_recv_request(sv[1], rx, fds), MXT_ERROR_PROTOCOL_FAULT);
+
+  req->cmd = CMD_READ;
+  assert_int_equal(send(sv[0], req, sizeof(*req), 0), sizeof(*req));
+  assert_int_equal(daemon_recv_request(sv[1], rx, fds), MXT_ERROR_PROTOCOL_FAULT);
+
+  close(sv[0]);
+  close(sv[1]);
+  close(out[0]);
+  close(out[1]);
+  close(err[0]);
+  close(err[1]);
+  free(rx);
+  free(req);
+}
+
+void mxt_daemon_check_socket_test(void **state)
+{
+  char dir[] = "/tmp/mxt_daemon_XXXXXX";
+  struct sockaddr_un addr = { AF_UNIX };
+  int sockfd;
+
+  assert_non_null(mkdtemp(dir));
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/mxt-app.sock", dir);
+
+  assert_int_equal(daemon_check_socket(addr.sun_path), MXT_ERROR_NO_DEVICE);
+
+  sockfd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  assert_true(sockfd >= 0);
+  assert_int_equal(bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+
+  assert_int_equal(daemon_check_socket(addr.sun_path), MXT_SUCCESS);
+
+  /* Anyone could have put it in a shared directory */
+  assert_int_equal(chmod(dir, 0777), 0);
+  assert_int_equal(daemon_check_socket(addr.sun_path), MXT_ERROR_ACCESS);
+  assert_int_equal(chmod(dir, 01770), 0);
+  assert_int_equal(daemon_check_socket(addr.sun_path), MXT_ERROR_ACCESS);
+  assert_int_equal(chmod(dir, 0700), 0);
+
+  /* Not a socket */
+  close(sockfd);
+  unlink(addr.sun_path);
+  close(creat(addr.sun_path, 0600));
+  assert_int_equal(daemon_check_socket(addr.sun_path), MXT_ERROR_ACCESS);
+
+  unlink(addr.sun_path);
+  rmdir(dir);
+}
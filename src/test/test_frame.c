@@ -0,0 +1,186 @@
+//------------------------------------------------------------------------------
+/// \file   test_frame.c
+/// \brief  Tests against libmaxtouch/frame.h
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/info_block.h"
+#include "run_unit_tests.h"
+
+void mxt_frame_layout_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  struct mxt_device mxt;
+  struct mxt_id_info id;
+  struct mxt_frame_layout layout;
+  struct mxt_object objects[] = {
+    { GEN_COMMANDPROCESSOR_T6, 0x00, 0x01, 5, 0, 1 },
+    { DEBUG_DIAGNOSTIC_T37, 0x00, 0x02, 129, 0, 0 },
+  };
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_SILENT;
+
+  memset(&id, 0, sizeof(id));
+  id.family = 0xA4;
+  id.matrix_x_size = 10;
+  id.matrix_y_size = 8;
+  id.num_objects = 2;
+
+  memset(&mxt, 0, sizeof(mxt));
+  mxt.ctx = &ctx;
+  mxt.info.id = &id;
+  mxt.info.objects = objects;
+
+  assert_int_equal(mxt_frame_acquire_init(&mxt, DELTAS_MODE, &layout),
+                   MXT_SUCCESS);
+  assert_true(mxt.frame.valid);
+  assert_int_equal(mxt.frame.diag_cmd_addr, 0x100 + MXT_T6_DIAGNOSTIC_OFFSET);
+  assert_int_equal(mxt.frame.t37_addr, 0x200);
+  assert_false(layout.self_cap);
+  assert_int_equal(layout.x_size, 10);
+  assert_int_equal(layout.y_size, 8);
+  assert_int_equal(layout.data_values, 80);
+  assert_int_equal(layout.passes, 1);
+  assert_int_equal(layout.page_size, 128);
+  /* 160 bytes of data need two pages */
+  assert_int_equal(layout.pages_per_pass, 2);
+
+  /* Self cap needs T111 */
+  assert_int_equal(mxt_frame_acquire_init(&mxt, SELF_CAP_DELTAS, &layout),
+                   MXT_ERROR_OBJECT_NOT_FOUND);
+  assert_false(mxt.frame.valid);
+
+  assert_int_equal(mxt_frame_acquire(&mxt, 0x42, NULL), MXT_ERROR_BAD_INPUT);
+
+  /* No T37 */
+  id.num_objects = 1;
+  assert_int_equal(mxt_frame_acquire_init(&mxt, REFS_MODE, &layout),
+                   MXT_ERROR_OBJECT_NOT_FOUND);
+}
+
+void mxt_frame_v4l2_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  struct mxt_device mxt;
+  struct mxt_id_info id;
+  struct mxt_frame_layout layout;
+  struct mxt_conn_info *conn;
+  struct mxt_object objects[] = {
+    { GEN_COMMANDPROCESSOR_T6, 0x00, 0x01, 5, 0, 1 },
+    { DEBUG_DIAGNOSTIC_T37, 0x00, 0x02, 129, 0, 0 },
+  };
+  /* Three rows of two values, padded to six bytes per row */
+  const uint8_t frame[] = {
+    0x01, 0x00, 0xff, 0xff, 0xaa, 0xaa,
+    0x02, 0x00, 0xfe, 0xff, 0xaa, 0xaa,
+    0x03, 0x00, 0x00, 0x80, 0xaa, 0xaa,
+  };
+  const int16_t expected[] = { 1, 2, 3, -1, -2, -32768 };
+  int16_t dst[6];
+  char dir[] = "/tmp/mxt_v4l2_XXXXXX";
+  char path[64];
+  char node[64];
+
+  /* Row major frame from the driver becomes X major */
+  v4l2_touch_convert(frame, 2, 3, 6, dst);
+  assert_memory_equal(dst, expected, sizeof(expected));
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_SILENT;
+
+  memset(&id, 0, sizeof(id));
+  id.family = 0xA4;
+  id.matrix_x_size = 10;
+  id.matrix_y_size = 8;
+  id.num_objects = 2;
+
+  memset(&mxt, 0, sizeof(mxt));
+  mxt.ctx = &ctx;
+  mxt.info.id = &id;
+  mxt.info.objects = objects;
+
+  /* Directory stands in for the sysfs device */
+  assert_non_null(mkdtemp(dir));
+  assert_int_equal(mxt_new_conn(&conn, E_SYSFS), MXT_SUCCESS);
+  conn->sysfs.path = strdup(dir);
+  mxt.conn = conn;
+
+  assert_int_equal(v4l2_touch_find(&mxt, node, sizeof(node)),
+                   MXT_ERROR_NO_DEVICE);
+
+  snprintf(path, sizeof(path), "%s/video4linux", dir);
+  assert_int_equal(mkdir(path, 0755), 0);
+  snprintf(path, sizeof(path), "%s/video4linux/v4l-touch97", dir);
+  assert_int_equal(mkdir(path, 0755), 0);
+
+  assert_int_equal(v4l2_touch_find(&mxt, node, sizeof(node)), MXT_SUCCESS);
+  assert_string_equal(node, "/dev/v4l-touch97");
+
+  /* T37 unless V4L2 is asked for */
+  assert_int_equal(mxt_frame_acquire_init(&mxt, DELTAS_MODE, &layout),
+                   MXT_SUCCESS);
+  assert_int_equal(mxt.frame.t37_addr, 0x200);
+
+  /* Node which cannot be opened falls back to T37 */
+  assert_int_equal(mxt_frame_set_v4l2_node(&mxt, MXT_FRAME_V4L2_AUTO),
+                   MXT_SUCCESS);
+  assert_int_equal(mxt_frame_acquire_init(&mxt, DELTAS_MODE, &layout),
+                   MXT_SUCCESS);
+  assert_false(mxt.frame.v4l2.open);
+  assert_int_equal(mxt.frame.t37_addr, 0x200);
+  assert_int_equal(layout.page_size, 128);
+
+  /* T37 only */
+  assert_int_equal(mxt_frame_set_v4l2_node(&mxt, ""), MXT_SUCCESS);
+  assert_false(mxt.frame.valid);
+  assert_int_equal(mxt_frame_acquire_init(&mxt, REFS_MODE, &layout),
+                   MXT_SUCCESS);
+  assert_int_equal(layout.pages_per_pass, 2);
+
+  mxt_frame_release(&mxt);
+  assert_null(mxt.frame.v4l2_node);
+  mxt_unref_conn(conn);
+
+  rmdir(path);
+  snprintf(path, sizeof(path), "%s/video4linux", dir);
+  rmdir(path);
+  rmdir(dir);
+}
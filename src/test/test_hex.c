@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+/// \file   test_hex.c
+/// \brief  Tests against libmaxtouch/hex.h
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/hex.h"
+#include "run_unit_tests.h"
+
+/* Long enough to cover several vector blocks and every tail length */
+#define HEX_TEST_LEN 70
+
+void mxt_hex_round_trip_test(void **state)
+{
+  uint8_t data[HEX_TEST_LEN];
+  uint8_t decoded[HEX_TEST_LEN];
+  char hex[HEX_TEST_LEN * 2 + 1];
+  char expected[HEX_TEST_LEN * 2 + 1];
+  char *end;
+  size_t len;
+  int i, j;
+
+  for (i = 0; i < 256; i += HEX_TEST_LEN / 2) {
+    for (j = 0; j < HEX_TEST_LEN; j++)
+      data[j] = (i + j * 37) & 0xFF;
+
+    for (len = 0; len <= HEX_TEST_LEN; len++) {
+      for (j = 0; j < (int)len; j++)
+        sprintf(expected + 2 * j, "%02X", data[j]);
+
+      memset(hex, 'x', sizeof(hex));
+      end = mxt_hex_encode(hex, data, len);
+      assert_true(end == hex + 2 * len);
+      assert_memory_equal(hex, expected, 2 * len);
+      assert_int_equal(hex[2 * len], 'x');
+
+      memset(decoded, 0, sizeof(decoded));
+      assert_int_equal(mxt_hex_decode(decoded, hex, len), MXT_SUCCESS);
+      assert_memory_equal(decoded, data, len);
+    }
+  }
+
+  /* Every byte value, both cases */
+  for (i = 0; i < 256; i++) {
+    data[0] = i;
+    sprintf(hex, "%02x", i);
+    assert_int_equal(mxt_hex_decode(decoded, hex, 1), MXT_SUCCESS);
+    assert_int_equal(decoded[0], i);
+
+    mxt_hex_encode(hex, data, 1);
+    sprintf(expected, "%02X", i);
+    assert_memory_equal(hex, expected, 2);
+  }
+}
+
+void mxt_hex_decode_invalid_test(void **state)
+{
+  const char valid[] = "0123456789ABCDEFabcdef";
+  uint8_t decoded[HEX_TEST_LEN];
+  char hex[HEX_TEST_LEN * 2];
+  int c, pos;
+
+  for (c = 0; c < 256; c++) {
+    if (strchr(valid, c))
+      continue;
+
+    /* Invalid character in vector block and in tail */
+    for (pos = 0; pos < (int)sizeof(hex); pos += 13) {
+      memset(hex, 'a', sizeof(hex));
+      hex[pos] = c;
+      assert_int_equal(mxt_hex_decode(decoded, hex, HEX_TEST_LEN),
+                       MXT_ERROR_BAD_INPUT);
+    }
+  }
+}
+
+void mxt_hex_encode_spaced_test(void **state)
+{
+  const uint8_t data[] = { 0x00, 0x5A, 0xFF };
+  char hex[16];
+  char *end;
+
+  end = mxt_hex_encode_spaced(hex, data, sizeof(data));
+  *end = '\0';
+  assert_string_equal(hex, "00 5A FF ");
+
+  end = mxt_hex_encode_spaced(hex, data, 0);
+  assert_true(end == hex);
+}
@@ -0,0 +1,220 @@
+//------------------------------------------------------------------------------
+/// \file   test_log.c
+/// \brief  Tests against libmaxtouch/log.h
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/log.h"
+#include "run_unit_tests.h"
+
+/* Messages logged while the log thread falls behind */
+#define LOG_TEST_BURST 20000
+
+//******************************************************************************
+/// \brief Read back everything written to file
+static char *log_test_read(FILE *fp)
+{
+  long size;
+  char *buf;
+
+  fflush(fp);
+  size = ftell(fp);
+  assert_true(size >= 0);
+
+  buf = malloc(size + 1);
+  assert_non_null(buf);
+
+  rewind(fp);
+  assert_int_equal(fread(buf, 1, size, fp), size);
+  buf[size] = '\0';
+
+  return buf;
+}
+
+void mxt_log_async_format_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  const char *null_str = NULL;
+  char long_str[600];
+  char expected[2048];
+  size_t len = 0;
+  char *out;
+  FILE *fp;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_INFO;   /* No time stamps */
+
+  memset(long_str, 'x', sizeof(long_str) - 1);
+  long_str[sizeof(long_str) - 1] = '\0';
+
+  fp = tmpfile();
+  assert_non_null(fp);
+
+  assert_int_equal(mxt_log_async_start(&ctx, fileno(fp)), MXT_SUCCESS);
+  assert_true(ctx.log_fn == mxt_log_async);
+
+#define LOG_AND_EXPECT(arg...) \
+  do { \
+    mxt_log(&ctx, LOG_INFO, arg); \
+    len += snprintf(expected + len, sizeof(expected) - len, arg); \
+    expected[len++] = '\n'; \
+  } while (0)
+
+  LOG_AND_EXPECT("plain");
+  LOG_AND_EXPECT("int %d %u %x %04X %c %hhu %hd", -5, 7u, 255, 0xAB, 'q',
+                 300, 70000);
+  LOG_AND_EXPECT("long %ld %lu %lld %llx %zu %jd %td", -1L, 2UL, -3LL,
+                 0x123456789ULL, (size_t)42, (intmax_t)-6, (ptrdiff_t)9);
+  LOG_AND_EXPECT("double %.3f %e %g %Lf", 3.14159, 1e-9, 2.5, 1.5L);
+  LOG_AND_EXPECT("str %s|%-6s|%.2s|", "abc", "de", "fgh");
+  LOG_AND_EXPECT("star %*d|%-*.*f|%.*s", 5, 1, 8, 2, 1.25, 3, "abcdef");
+  LOG_AND_EXPECT("percent 100%% %p", (void *)&ctx);
+  LOG_AND_EXPECT("%s %d", "mixed", 1);
+
+#undef LOG_AND_EXPECT
+
+  mxt_log(&ctx, LOG_INFO, "null %s", null_str);
+  len += sprintf(expected + len, "null (null)\n");
+
+  /* Strings which do not fit in one record are truncated */
+  mxt_log(&ctx, LOG_INFO, "%s", long_str);
+
+  mxt_log_async_stop(&ctx);
+  assert_true(ctx.log_fn == mxt_log_stderr);
+  assert_null(ctx.log_ring);
+
+  out = log_test_read(fp);
+  expected[len] = '\0';
+  assert_memory_equal(out, expected, len);
+
+  /* Truncated line is all 'x' */
+  assert_true(strlen(out + len) > 400);
+  assert_true(strlen(out + len) < sizeof(long_str));
+  assert_int_equal(strspn(out + len, "x"), strlen(out + len) - 1);
+
+  free(out);
+  fclose(fp);
+}
+
+void mxt_log_async_drop_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  unsigned long dropped;
+  unsigned long lines = 0;
+  unsigned long reported = 0;
+  unsigned long n;
+  char *out, *p;
+  FILE *fp;
+  int i;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_INFO;
+
+  fp = tmpfile();
+  assert_non_null(fp);
+
+  assert_int_equal(mxt_log_async_start(&ctx, fileno(fp)), MXT_SUCCESS);
+
+  for (i = 0; i < LOG_TEST_BURST; i++)
+    mxt_info(&ctx, "message %d", i);
+
+  dropped = mxt_log_async_dropped(&ctx);
+  mxt_log_async_stop(&ctx);
+
+  out = log_test_read(fp);
+
+  /* Every message is either output or counted as dropped */
+  for (p = strtok(out, "\n"); p; p = strtok(NULL, "\n")) {
+    if (sscanf(p, "Log: %lu messages dropped", &n) == 1)
+      reported += n;
+    else if (!strncmp(p, "message ", 8))
+      lines++;
+  }
+
+  assert_int_equal(lines + dropped, LOG_TEST_BURST);
+  assert_int_equal(reported, dropped);
+
+  free(out);
+  fclose(fp);
+}
+
+static int log_test_evaluated;
+
+//******************************************************************************
+/// \brief Count evaluations of a log argument
+static int log_test_arg(void)
+{
+  return ++log_test_evaluated;
+}
+
+//******************************************************************************
+/// \brief Discard log output
+static void log_test_discard(struct libmaxtouch_ctx *ctx,
+                             enum mxt_log_level level,
+                             const char *format, va_list args)
+{
+}
+
+void mxt_log_level_filter_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  const unsigned char data[] = { 0x12, 0x34 };
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = log_test_discard;
+  ctx.log_level = LOG_WARN;
+
+  log_test_evaluated = 0;
+
+  /* Filtered messages must not evaluate their arguments */
+  mxt_verb(&ctx, "%d", log_test_arg());
+  mxt_dbg(&ctx, "%d", log_test_arg());
+  mxt_info(&ctx, "%d", log_test_arg());
+  mxt_log_buffer(&ctx, LOG_DEBUG, "TX:", data, sizeof(data));
+  assert_int_equal(log_test_evaluated, 0);
+
+  mxt_err(&ctx, "%d", log_test_arg());
+  assert_int_equal(log_test_evaluated, MXT_LOG_MIN_LEVEL <= LOG_ERROR);
+
+  ctx.log_level = LOG_VERBOSE;
+  mxt_info(&ctx, "%d", log_test_arg());
+  assert_int_equal(log_test_evaluated,
+                   (MXT_LOG_MIN_LEVEL <= LOG_ERROR)
+                   + (MXT_LOG_MIN_LEVEL <= LOG_INFO));
+}
@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+/// \file   test_scan.c
+/// \brief  Tests against mxt_scan_all() support in libmaxtouch/libmaxtouch.h
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "run_unit_tests.h"
+
+void mxt_scan_found_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  struct mxt_conn_info *conn = NULL;
+  struct mxt_conn_info *found[3];
+  int i;
+
+  memset(&ctx, 0, sizeof(ctx));
+
+  /* Single device scan stops at the first device */
+  assert_int_equal(mxt_new_conn(&found[0], E_I2C_DEV), MXT_SUCCESS);
+  assert_int_equal(mxt_scan_found(&ctx, &conn, found[0]), MXT_SUCCESS);
+  assert_true(conn == found[0]);
+  mxt_unref_conn(conn);
+
+  /* Scanning for all devices carries on and collects each one */
+  ctx.scan_all = true;
+  for (i = 0; i < 3; i++) {
+    assert_int_equal(mxt_new_conn(&found[i], E_I2C_DEV), MXT_SUCCESS);
+    found[i]->i2c_dev.address = 0x4a + i;
+    assert_int_equal(mxt_scan_found(&ctx, NULL, found[i]),
+                     MXT_ERROR_NO_DEVICE);
+  }
+
+  assert_int_equal(ctx.scan_list_len, 3);
+  for (i = 0; i < 3; i++)
+    assert_true(ctx.scan_list[i] == found[i]);
+
+  mxt_free_conn_list(ctx.scan_list, ctx.scan_list_len);
+}
+
+void mxt_conn_name_test(void **state)
+{
+  struct mxt_conn_info *conn;
+  char name[64];
+
+  assert_int_equal(mxt_new_conn(&conn, E_I2C_DEV), MXT_SUCCESS);
+  conn->i2c_dev.adapter = 2;
+  conn->i2c_dev.address = 0x4a;
+  assert_int_equal(mxt_conn_name(conn, name, sizeof(name)), MXT_SUCCESS);
+  assert_string_equal(name, "i2c-dev:2-004a");
+
+  /* Truncation is an error rather than a wrong device string */
+  assert_int_equal(mxt_conn_name(conn, name, 8), MXT_ERROR_NO_MEM);
+  mxt_unref_conn(conn);
+
+  assert_int_equal(mxt_new_conn(&conn, E_HIDRAW), MXT_SUCCESS);
+  strcpy(conn->hidraw.node, "/dev/hidraw0");
+  assert_int_equal(mxt_conn_name(conn, name, sizeof(name)), MXT_SUCCESS);
+  assert_string_equal(name, "hidraw:/dev/hidraw0");
+  mxt_unref_conn(conn);
+}
@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------
+/// \file   test_script.c
+/// \brief  Unit tests for script command parsing
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/info_block.h"
+#include "mxt-app/mxt_app.h"
+#include "mxt-app/script.h"
+#include "run_unit_tests.h"
+
+void script_parse_num_test(void **state)
+{
+  unsigned long value;
+
+  assert_int_equal(script_parse_num("0", 10, &value), MXT_SUCCESS);
+  assert_int_equal(value, 0);
+  assert_int_equal(script_parse_num("255", UINT8_MAX, &value), MXT_SUCCESS);
+  assert_int_equal(value, 255);
+  assert_int_equal(script_parse_num("0x1F", UINT8_MAX, &value), MXT_SUCCESS);
+  assert_int_equal(value, 0x1f);
+
+  /* Out of range */
+  assert_int_equal(script_parse_num("256", UINT8_MAX, &value),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_num("0x10000", UINT16_MAX, &value),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_num("99999999999999999999999", ULONG_MAX,
+                                    &value), MXT_ERROR_BAD_INPUT);
+
+  /* Malformed */
+  assert_int_equal(script_parse_num("", UINT16_MAX, &value),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_num("12a", UINT16_MAX, &value),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_num("0x", UINT16_MAX, &value),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_num("ff", UINT16_MAX, &value),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_num("1 ", UINT16_MAX, &value),
+                   MXT_ERROR_BAD_INPUT);
+}
+
+void script_parse_object_test(void **state)
+{
+  uint16_t type;
+  uint8_t instance;
+
+  assert_int_equal(script_parse_object("T7", &type, &instance), MXT_SUCCESS);
+  assert_int_equal(type, 7);
+  assert_int_equal(instance, 0);
+
+  assert_int_equal(script_parse_object("t100:1", &type, &instance),
+                   MXT_SUCCESS);
+  assert_int_equal(type, 100);
+  assert_int_equal(instance, 1);
+
+  assert_int_equal(script_parse_object("T100:0xff", &type, &instance),
+                   MXT_SUCCESS);
+  assert_int_equal(instance, 255);
+
+  /* Instance out of range */
+  assert_int_equal(script_parse_object("T100:256", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_object("T100:", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_object("T100:1:2", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+
+  /* Malformed type */
+  assert_int_equal(script_parse_object("7", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_object("T", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_object("T0", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_object("T65536", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_object("Tx7", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_object("T000000000000007", &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+}
+
+void script_parse_address_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  struct mxt_device mxt;
+  struct mxt_id_info id;
+  struct mxt_object objects[] = {
+    { GEN_POWERCONFIG_T7, 0x00, 0x01, 3, 0, 0 },
+    { TOUCH_MULTITOUCHSCREEN_T100, 0x00, 0x02, 9, 1, 6 },
+  };
+  char args[3][16];
+  char *argv[3] = { args[0], args[1], args[2] };
+  uint16_t address;
+  uint16_t type;
+  uint8_t instance;
+  int used;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_SILENT;
+
+  memset(&id, 0, sizeof(id));
+  id.num_objects = 2;
+
+  memset(&mxt, 0, sizeof(mxt));
+  mxt.ctx = &ctx;
+  mxt.info.id = &id;
+  mxt.info.objects = objects;
+
+  /* Object with offset, which is relative to the object */
+  strcpy(args[0], "T100:1");
+  strcpy(args[1], "0x5");
+  strcpy(args[2], "3");
+  assert_int_equal(script_parse_address(&mxt, 3, argv, &used, &address,
+                                        &type, &instance), MXT_SUCCESS);
+  assert_int_equal(used, 2);
+  assert_int_equal(address, 5);
+  assert_int_equal(type, TOUCH_MULTITOUCHSCREEN_T100);
+  assert_int_equal(instance, 1);
+
+  /* Object alone */
+  assert_int_equal(script_parse_address(&mxt, 1, argv, &used, &address,
+                                        &type, &instance), MXT_SUCCESS);
+  assert_int_equal(used, 1);
+  assert_int_equal(address, 0);
+
+  /* Plain register address */
+  strcpy(args[0], "0x0104");
+  assert_int_equal(script_parse_address(&mxt, 2, argv, &used, &address,
+                                        &type, &instance), MXT_SUCCESS);
+  assert_int_equal(used, 1);
+  assert_int_equal(address, 0x104);
+  assert_int_equal(type, 0);
+  assert_int_equal(instance, 0);
+
+  /* Unknown object and instance out of range */
+  strcpy(args[0], "T9");
+  assert_int_equal(script_parse_address(&mxt, 1, argv, &used, &address,
+                                        &type, &instance),
+                   MXT_ERROR_OBJECT_NOT_FOUND);
+  strcpy(args[0], "T100:2");
+  assert_int_equal(script_parse_address(&mxt, 1, argv, &used, &address,
+                                        &type, &instance),
+                   MXT_ERROR_OBJECT_NOT_FOUND);
+  strcpy(args[0], "T7:1");
+  assert_int_equal(script_parse_address(&mxt, 1, argv, &used, &address,
+                                        &type, &instance),
+                   MXT_ERROR_OBJECT_NOT_FOUND);
+
+  /* Malformed offset or address */
+  strcpy(args[0], "T7");
+  strcpy(args[1], "0x10000");
+  assert_int_equal(script_parse_address(&mxt, 2, argv, &used, &address,
+                                        &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  strcpy(args[0], "reg");
+  assert_int_equal(script_parse_address(&mxt, 1, argv, &used, &address,
+                                        &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(script_parse_address(&mxt, 0, argv, &used, &address,
+                                        &type, &instance),
+                   MXT_ERROR_BAD_INPUT);
+}
+
+static int run_script_line(struct mxt_device *mxt, const char *line)
+{
+  char path[] = "/tmp/mxt_script_XXXXXX";
+  int fd;
+  int ret;
+
+  fd = mkstemp(path);
+  assert_true(fd >= 0);
+  assert_int_equal(write(fd, line, strlen(line)), strlen(line));
+  close(fd);
+
+  ret = mxt_run_script(mxt, path);
+  unlink(path);
+
+  return ret;
+}
+
+void script_bad_count_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  struct mxt_device mxt;
+  struct mxt_id_info id;
+  struct mxt_object objects[] = {
+    { GEN_POWERCONFIG_T7, 0x00, 0x01, 3, 0, 0 },
+  };
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_SILENT;
+
+  memset(&id, 0, sizeof(id));
+  id.num_objects = 1;
+
+  memset(&mxt, 0, sizeof(mxt));
+  mxt.ctx = &ctx;
+  mxt.info.id = &id;
+  mxt.info.objects = objects;
+
+  /* Rejected before the device is touched */
+  assert_int_equal(run_script_line(&mxt, "read 0x104\n"),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(run_script_line(&mxt, "read 0x104 0\n"),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(run_script_line(&mxt, "read T7 0 0\n"),
+                   MXT_ERROR_BAD_INPUT);
+  assert_int_equal(run_script_line(&mxt, "dump deltas 0 out.csv\n"),
+                   MXT_ERROR_BAD_INPUT);
+}
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+/// \file   test_snapshot.c
+/// \brief  Tests against memory snapshots in mxt-app/snapshot
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "mxt-app/snapshot.h"
+#include "run_unit_tests.h"
+
+#define TEST_INFO_SIZE    (7 + 2 * 6 + 3)
+#define TEST_IMAGE_SIZE   0x50
+
+//******************************************************************************
+/// \brief Write snapshot file with T7 at 0x30 and two instances of T9 at 0x40
+static void write_snapshot(const char *path, uint64_t sec,
+                           const uint8_t *image)
+{
+  const uint8_t info[TEST_INFO_SIZE] = {
+    0xA4, 0x1A, 0x10, 0xAA, 0x20, 0x18, 0x02,
+    7, 0x30, 0x00, 3, 0, 0,
+    9, 0x40, 0x00, 7, 1, 10,
+    0x12, 0x34, 0x56
+  };
+  struct mxt_snapshot_header hdr = { SNAPSHOT_MAGIC };
+  FILE *fp;
+
+  hdr.time_sec = htole64(sec);
+  hdr.info_size = htole32(sizeof(info));
+  hdr.image_size = htole32(TEST_IMAGE_SIZE);
+
+  fp = fopen(path, "w");
+  assert_non_null(fp);
+  assert_int_equal(fwrite(&hdr, sizeof(hdr), 1, fp), 1);
+  assert_int_equal(fwrite(info, sizeof(info), 1, fp), 1);
+  assert_int_equal(fwrite(image, TEST_IMAGE_SIZE, 1, fp), 1);
+  fclose(fp);
+}
+
+void mxt_snapshot_compare_test(void **state)
+{
+  struct libmaxtouch_ctx *ctx;
+  struct mxt_snapshot a;
+  struct mxt_snapshot b;
+  uint8_t image[TEST_IMAGE_SIZE];
+  char path_a[] = "/tmp/mxt_snap_a_XXXXXX";
+  char path_b[] = "/tmp/mxt_snap_b_XXXXXX";
+  char out[512];
+  size_t len;
+  int changes;
+  FILE *fp;
+
+  assert_int_equal(mxt_new(&ctx), MXT_SUCCESS);
+  ctx->log_level = LOG_SILENT;
+
+  close(mkstemp(path_a));
+  close(mkstemp(path_b));
+
+  memset(image, 0x11, sizeof(image));
+  write_snapshot(path_a, 100, image);
+
+  image[0x20] = 0x22;             /* Outside any object */
+  image[0x31] = 0x22;             /* T7 byte 1 */
+  image[0x47] = 0x22;             /* Last byte of T9 instance 0... */
+  image[0x48] = 0x22;             /* ...and first of instance 1 */
+  image[0x4A] = 0x22;             /* T9 instance 1 bytes 2 to 3 */
+  image[0x4B] = 0x33;
+  write_snapshot(path_b, 101, image);
+
+  assert_int_equal(mxt_snapshot_open(ctx, path_a, &a), MXT_SUCCESS);
+  assert_int_equal(mxt_snapshot_open(ctx, path_b, &b), MXT_SUCCESS);
+  assert_int_equal(a.info_size, TEST_INFO_SIZE);
+  assert_int_equal(a.image_size, TEST_IMAGE_SIZE);
+  assert_int_equal(b.time_sec, 101);
+
+  fp = tmpfile();
+  assert_non_null(fp);
+  assert_int_equal(mxt_snapshot_compare(&a, &b, fp, &changes), MXT_SUCCESS);
+  assert_int_equal(changes, 5);
+
+  rewind(fp);
+  len = fread(out, 1, sizeof(out) - 1, fp);
+  out[len] = '\0';
+  fclose(fp);
+
+  assert_non_null(strstr(out, "@32: 11 -> 22\n"));
+  assert_non_null(strstr(out, "T7[0] 1: 11 -> 22\n"));
+  assert_non_null(strstr(out, "T9[0] 7: 11 -> 22\n"));
+  assert_non_null(strstr(out, "T9[1] 0: 11 -> 22\n"));
+  assert_non_null(strstr(out, "T9[1] 2-3: 11 11 -> 22 33\n"));
+
+  mxt_snapshot_close(&a);
+  mxt_snapshot_close(&b);
+
+  /* A truncated file is rejected */
+  assert_int_equal(truncate(path_b, 40), 0);
+  assert_int_equal(mxt_snapshot_open(ctx, path_b, &b), MXT_ERROR_FILE_FORMAT);
+
+  unlink(path_a);
+  unlink(path_b);
+  mxt_free(ctx);
+}
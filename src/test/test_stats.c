@@ -0,0 +1,179 @@
+//------------------------------------------------------------------------------
+/// \file   test_stats.c
+/// \brief  Tests against libmaxtouch/stats.h
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/stats.h"
+#include "run_unit_tests.h"
+
+void mxt_stats_record_test(void **state)
+{
+  struct mxt_transport_stats stats;
+  struct mxt_transport_stats total;
+  const struct mxt_stats_histogram *hist = &stats.latency[MXT_STATS_READ];
+
+  memset(&stats, 0, sizeof(stats));
+  memset(&total, 0, sizeof(total));
+
+  /* Time since boot is slower than the last bucket */
+  mxt_stats_record(&stats, MXT_STATS_READ, mxt_stats_now_us(), MXT_SUCCESS);
+  mxt_stats_record(&stats, MXT_STATS_READ, 0, MXT_ERROR_IO);
+
+  assert_int_equal(hist->count, 2);
+  assert_int_equal(hist->errors, 1);
+  assert_int_equal(hist->buckets[MXT_STATS_BUCKETS - 1], 1);
+  assert_true(hist->max_us >= 1ULL << (MXT_STATS_BUCKETS - 1));
+  assert_int_equal(mxt_stats_percentile(hist, 100), hist->max_us);
+  assert_int_equal(stats.latency[MXT_STATS_WRITE].count, 0);
+
+  stats.bytes_read = 10;
+  stats.syscalls = 3;
+  stats.naks = 1;
+
+  mxt_stats_merge(&total, &stats);
+  mxt_stats_merge(&total, &stats);
+
+  assert_int_equal(total.latency[MXT_STATS_READ].count, 4);
+  assert_int_equal(total.latency[MXT_STATS_READ].errors, 2);
+  assert_int_equal(total.latency[MXT_STATS_READ].max_us, hist->max_us);
+  assert_int_equal(total.bytes_read, 20);
+  assert_int_equal(total.syscalls, 6);
+  assert_int_equal(total.naks, 2);
+
+  mxt_stats_errno(&total, EAGAIN);
+  mxt_stats_errno(&total, EREMOTEIO);
+  mxt_stats_errno(&total, EIO);
+  assert_int_equal(total.eagain, 1);
+  assert_int_equal(total.naks, 3);
+
+  assert_string_equal(mxt_stats_op_name(MXT_STATS_BOOTLOADER), "bootloader");
+}
+
+void mxt_stats_add_test(void **state)
+{
+  struct mxt_stats_histogram hist;
+  int i;
+
+  memset(&hist, 0, sizeof(hist));
+
+  assert_int_equal(mxt_stats_percentile(&hist, 50), 0);
+
+  mxt_stats_add(&hist, 0);
+  mxt_stats_add(&hist, 1);
+  mxt_stats_add(&hist, 2);
+  mxt_stats_add(&hist, 3);
+  mxt_stats_add(&hist, 1000);
+  mxt_stats_add(&hist, 100000000);
+
+  assert_int_equal(hist.count, 6);
+  assert_int_equal(hist.buckets[0], 2);
+  assert_int_equal(hist.buckets[1], 2);
+  assert_int_equal(hist.buckets[9], 1);
+  assert_int_equal(hist.buckets[MXT_STATS_BUCKETS - 1], 1);
+  assert_int_equal(hist.max_us, 100000000);
+  assert_int_equal(hist.total_us, 100001006);
+
+  /* Upper bound of bucket, or the maximum if that is smaller */
+  assert_int_equal(mxt_stats_percentile(&hist, 50), 4);
+  assert_int_equal(mxt_stats_percentile(&hist, 70), 1024);
+  assert_int_equal(mxt_stats_percentile(&hist, 99), 100000000);
+
+  memset(&hist, 0, sizeof(hist));
+  for (i = 0; i < 100; i++)
+    mxt_stats_add(&hist, 5);
+
+  assert_int_equal(mxt_stats_percentile(&hist, 99), 5);
+}
+
+void mxt_transport_stats_sysfs_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  struct mxt_conn_info conn;
+  struct mxt_device mxt;
+  struct mxt_transport_stats stats;
+  char path[] = "/tmp/mxt_stats_XXXXXX";
+  uint8_t data[64];
+  uint8_t buf[16];
+  int fd;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_SILENT;
+
+  memset(&conn, 0, sizeof(conn));
+  conn.type = E_SYSFS;
+
+  /* Plain file stands in for the mem_access attribute */
+  fd = mkstemp(path);
+  assert_true(fd >= 0);
+  memset(data, 0x5A, sizeof(data));
+  assert_int_equal(write(fd, data, sizeof(data)), sizeof(data));
+  close(fd);
+
+  memset(&mxt, 0, sizeof(mxt));
+  mxt.ctx = &ctx;
+  mxt.conn = &conn;
+  mxt.sysfs.mem_access_path = path;
+
+  assert_int_equal(mxt_read_register(&mxt, buf, 8, sizeof(buf)), MXT_SUCCESS);
+  assert_int_equal(mxt_write_register(&mxt, buf, 0, 4), MXT_SUCCESS);
+
+  mxt_get_transport_stats(&mxt, &stats);
+  assert_int_equal(stats.latency[MXT_STATS_READ].count, 1);
+  assert_int_equal(stats.latency[MXT_STATS_WRITE].count, 1);
+  assert_int_equal(stats.bytes_read, sizeof(buf));
+  assert_int_equal(stats.bytes_written, 4);
+  /* open, lseek, read/write, close each */
+  assert_int_equal(stats.syscalls, 8);
+  assert_int_equal(stats.retries, 0);
+
+  /* Failures are recorded against the operation */
+  unlink(path);
+  assert_int_equal(mxt_read_register(&mxt, buf, 0, sizeof(buf)),
+                   MXT_ERROR_NOENT);
+
+  mxt_get_transport_stats(&mxt, &stats);
+  assert_int_equal(stats.latency[MXT_STATS_READ].count, 2);
+  assert_int_equal(stats.latency[MXT_STATS_READ].errors, 1);
+  assert_int_equal(stats.bytes_read, sizeof(buf));
+
+  mxt_reset_transport_stats(&mxt);
+  mxt_get_transport_stats(&mxt, &stats);
+  assert_int_equal(stats.latency[MXT_STATS_READ].count, 0);
+  assert_int_equal(stats.syscalls, 0);
+}
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+/// \file   test_sysfs.c
+/// \brief  Tests against kernel driver updates in libmaxtouch/sysfs
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "run_unit_tests.h"
+
+//******************************************************************************
+/// \brief Create file in directory with contents
+static void write_file(const char *dir, const char *name,
+                       const void *data, size_t len)
+{
+  char path[256];
+  FILE *fp;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  fp = fopen(path, "w");
+  assert_non_null(fp);
+  assert_int_equal(fwrite(data, 1, len, fp), len);
+  fclose(fp);
+}
+
+void mxt_sysfs_update_test(void **state)
+{
+  struct libmaxtouch_ctx *ctx;
+  struct mxt_conn_info *conn = NULL;
+  struct mxt_device *mxt;
+  const uint8_t id[7] = { 0xA4, 0x1A, 0x10, 0xAA, 0x20, 0x18, 0x05 };
+  char root[] = "/tmp/mxt_sysfs_XXXXXX";
+  char driver[64];
+  char dev[80];
+  char fwdir[64];
+  const char raw[] = "OBP_RAW V1\nA4 1A 10 AA 20 18 05\n000000\n000000\n"
+                     "0007 0000 0004 01 02 03 04\n";
+  char path[128];
+  char cfg[96];
+  char buf[64];
+  FILE *fp;
+
+  /* Fake sysfs tree with one device bound to the driver */
+  assert_non_null(mkdtemp(root));
+  snprintf(driver, sizeof(driver), "%s/atmel_mxt_ts", root);
+  assert_int_equal(mkdir(driver, 0755), 0);
+  snprintf(dev, sizeof(dev), "%s/2-004a", driver);
+  assert_int_equal(mkdir(dev, 0755), 0);
+  snprintf(fwdir, sizeof(fwdir), "%s/firmware", root);
+  assert_int_equal(mkdir(fwdir, 0755), 0);
+
+  write_file(dev, "mem_access", id, sizeof(id));
+  write_file(dev, "debug_enable", "0", 1);
+  write_file(dev, "update_fw", "", 0);
+
+  assert_int_equal(mxt_new(&ctx), MXT_SUCCESS);
+  ctx->log_level = LOG_SILENT;
+  ctx->sysfs_root = root;
+  ctx->firmware_dir = fwdir;
+
+  assert_int_equal(mxt_scan(ctx, &conn, false), MXT_SUCCESS);
+  assert_int_equal(conn->type, E_SYSFS);
+  assert_string_equal(conn->sysfs.path, dev);
+
+  assert_int_equal(mxt_new_device(ctx, conn, &mxt), MXT_SUCCESS);
+
+  assert_true(sysfs_has_attr(mxt, "update_fw"));
+  assert_false(sysfs_has_attr(mxt, "update_cfg"));
+
+  /* Without update_cfg the caller writes the config itself */
+  assert_int_equal(mxt_kernel_load_config(mxt, "missing.raw"),
+                   MXT_ERROR_NOT_SUPPORTED);
+
+  assert_int_equal(sysfs_firmware_path(mxt, SYSFS_FW_NAME, path, sizeof(path)),
+                   MXT_SUCCESS);
+  snprintf(buf, sizeof(buf), "/firmware/%s", SYSFS_FW_NAME);
+  assert_string_equal(path + strlen(root), buf);
+  assert_int_equal(sysfs_firmware_path(mxt, SYSFS_FW_NAME, buf, 8),
+                   MXT_ERROR_NO_MEM);
+
+  /* The driver is given the staged name and the device answers again */
+  assert_int_equal(sysfs_update(mxt, "update_fw", SYSFS_FW_NAME), MXT_SUCCESS);
+
+  snprintf(path, sizeof(path), "%s/update_fw", dev);
+  fp = fopen(path, "r");
+  assert_non_null(fp);
+  memset(buf, 0, sizeof(buf));
+  assert_non_null(fgets(buf, sizeof(buf), fp));
+  fclose(fp);
+  assert_string_equal(buf, SYSFS_FW_NAME);
+
+  assert_int_equal(sysfs_update(mxt, "update_cfg", SYSFS_CFG_NAME),
+                   MXT_ERROR_NOENT);
+
+  /* A firmware directory which cannot be written falls back to writing the
+   * config directly, as does a driver which rejects the file */
+  write_file(dev, "update_cfg", "", 0);
+  write_file(root, "test.raw", raw, strlen(raw));
+  snprintf(cfg, sizeof(cfg), "%s/test.raw", root);
+  snprintf(buf, sizeof(buf), "%s/none", root);
+  ctx->firmware_dir = buf;
+  assert_int_equal(mxt_kernel_load_config(mxt, cfg), MXT_ERROR_NOT_SUPPORTED);
+
+  snprintf(path, sizeof(path), "%s/update_cfg", dev);
+  chmod(path, 0444);
+  ctx->firmware_dir = fwdir;
+  if (access(path, W_OK))
+    assert_int_equal(mxt_kernel_load_config(mxt, cfg), MXT_ERROR_NOT_SUPPORTED);
+
+  unlink(path);
+  unlink(cfg);
+  snprintf(path, sizeof(path), "%s/%s", fwdir, SYSFS_CFG_NAME);
+  unlink(path);
+  snprintf(path, sizeof(path), "%s/update_fw", dev);
+
+  mxt_free_device(mxt);
+  mxt_unref_conn(conn);
+  mxt_free(ctx);
+
+  unlink(path);
+  snprintf(path, sizeof(path), "%s/mem_access", dev);
+  unlink(path);
+  snprintf(path, sizeof(path), "%s/debug_enable", dev);
+  unlink(path);
+  rmdir(dev);
+  rmdir(driver);
+  rmdir(fwdir);
+  rmdir(root);
+}
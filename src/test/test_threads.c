@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+/// \file   test_threads.c
+/// \brief  Tests against concurrent use of libmaxtouch devices
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "run_unit_tests.h"
+
+#define STRESS_WRITERS    4
+#define STRESS_ITERATIONS 500
+#define STRESS_BLOCK      16
+
+struct stress_thread {
+  pthread_t thread;
+  struct mxt_device *mxt;
+  struct mxt_conn_info *conn;
+  int index;
+  int failures;
+};
+
+static void *conn_ref_thread(void *arg)
+{
+  struct stress_thread *t = arg;
+  int i;
+
+  for (i = 0; i < 10000; i++) {
+    mxt_ref_conn(t->conn);
+    mxt_unref_conn(t->conn);
+  }
+
+  return NULL;
+}
+
+void mxt_conn_refcount_threads_test(void **state)
+{
+  struct stress_thread threads[STRESS_WRITERS];
+  struct mxt_conn_info *conn;
+  int i;
+
+  assert_int_equal(mxt_new_conn(&conn, E_I2C_DEV), MXT_SUCCESS);
+
+  for (i = 0; i < STRESS_WRITERS; i++) {
+    threads[i].conn = conn;
+    assert_int_equal(pthread_create(&threads[i].thread, NULL,
+                                    conn_ref_thread, &threads[i]), 0);
+  }
+
+  for (i = 0; i < STRESS_WRITERS; i++)
+    pthread_join(threads[i].thread, NULL);
+
+  assert_int_equal(conn->refcount, 1);
+  assert_null(mxt_unref_conn(conn));
+}
+
+/* Each writer owns one block of registers and checks it reads back */
+static void *register_thread(void *arg)
+{
+  struct stress_thread *t = arg;
+  int start = t->index * STRESS_BLOCK;
+  uint8_t out[STRESS_BLOCK];
+  uint8_t in[STRESS_BLOCK];
+  int i;
+
+  for (i = 0; i < STRESS_ITERATIONS; i++) {
+    memset(out, (t->index << 4) | (i & 0xf), sizeof(out));
+
+    if (mxt_write_register(t->mxt, out, start, sizeof(out))
+        || mxt_read_register(t->mxt, in, start, sizeof(in))
+        || memcmp(in, out, sizeof(in)))
+      t->failures++;
+  }
+
+  return NULL;
+}
+
+/* Other device calls share the sysfs path buffer and statistics */
+static void *observer_thread(void *arg)
+{
+  struct stress_thread *t = arg;
+  struct mxt_transport_stats stats;
+  bool debug;
+  int i;
+
+  for (i = 0; i < STRESS_ITERATIONS; i++) {
+    mxt_get_transport_stats(t->mxt, &stats);
+
+    if (mxt_get_debug(t->mxt, &debug) || !debug)
+      t->failures++;
+  }
+
+  return NULL;
+}
+
+void mxt_device_threads_test(void **state)
+{
+  struct stress_thread threads[STRESS_WRITERS + 1];
+  struct libmaxtouch_ctx *ctx;
+  struct mxt_conn_info *conn;
+  struct mxt_device *mxt;
+  struct mxt_transport_stats stats;
+  char dir[] = "/tmp/mxt_threads_XXXXXX";
+  char path[64];
+  uint8_t data[STRESS_WRITERS * STRESS_BLOCK];
+  FILE *fp;
+  int ops;
+  int i;
+
+  /* Directory stands in for the sysfs device */
+  assert_non_null(mkdtemp(dir));
+
+  snprintf(path, sizeof(path), "%s/mem_access", dir);
+  fp = fopen(path, "w");
+  assert_non_null(fp);
+  memset(data, 0, sizeof(data));
+  assert_int_equal(fwrite(data, 1, sizeof(data), fp), sizeof(data));
+  fclose(fp);
+
+  snprintf(path, sizeof(path), "%s/debug_enable", dir);
+  fp = fopen(path, "w");
+  assert_non_null(fp);
+  fputs("1", fp);
+  fclose(fp);
+
+  assert_int_equal(mxt_new(&ctx), MXT_SUCCESS);
+  ctx->log_level = LOG_SILENT;
+  assert_int_equal(mxt_trace_start(ctx, 1024), MXT_SUCCESS);
+
+  assert_int_equal(mxt_new_conn(&conn, E_SYSFS), MXT_SUCCESS);
+  conn->sysfs.path = strdup(dir);
+  assert_int_equal(mxt_new_device(ctx, conn, &mxt), MXT_SUCCESS);
+  mxt_unref_conn(conn);
+
+  for (i = 0; i <= STRESS_WRITERS; i++) {
+    threads[i].mxt = mxt;
+    threads[i].index = i;
+    threads[i].failures = 0;
+    assert_int_equal(pthread_create(&threads[i].thread, NULL,
+                                    i < STRESS_WRITERS ? register_thread
+                                                       : observer_thread,
+                                    &threads[i]), 0);
+  }
+
+  for (i = 0; i <= STRESS_WRITERS; i++) {
+    pthread_join(threads[i].thread, NULL);
+    assert_int_equal(threads[i].failures, 0);
+  }
+
+  ops = STRESS_WRITERS * STRESS_ITERATIONS;
+
+  mxt_get_transport_stats(mxt, &stats);
+  assert_int_equal(stats.latency[MXT_STATS_READ].count, ops);
+  assert_int_equal(stats.latency[MXT_STATS_WRITE].count, ops);
+  assert_int_equal(stats.bytes_read, ops * STRESS_BLOCK);
+  assert_int_equal(stats.bytes_written, ops * STRESS_BLOCK);
+
+  /* Every span was either recorded once or counted as dropped */
+  assert_int_equal(ctx->trace->count, 1024);
+  assert_int_equal(ctx->trace->count + ctx->trace->dropped, ops * 2);
+
+  mxt_free_device(mxt);
+  assert_int_equal(ctx->transport_stats.latency[MXT_STATS_READ].count, ops);
+  mxt_free(ctx);
+
+  unlink(path);
+  snprintf(path, sizeof(path), "%s/mem_access", dir);
+  unlink(path);
+  rmdir(dir);
+}
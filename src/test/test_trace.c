@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+/// \file   test_trace.c
+/// \brief  Tests against libmaxtouch/trace.h
+//------------------------------------------------------------------------------
+// Copyright 2026 The mxt-app contributors. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+//    2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ''AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "libmaxtouch/libmaxtouch.h"
+#include "libmaxtouch/trace.h"
+#include "run_unit_tests.h"
+
+void mxt_trace_span_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  char path[] = "/tmp/mxt_trace_XXXXXX";
+  char buf[1024];
+  size_t len;
+  int outer, inner, open_span;
+  FILE *fp;
+  int fd;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_SILENT;
+
+  /* Nothing recorded while tracing is off */
+  assert_int_equal(mxt_trace_begin(&ctx, "off", 1), -1);
+  assert_int_equal(mxt_trace_write(&ctx, path), MXT_ERROR_NOT_SUPPORTED);
+
+  assert_int_equal(mxt_trace_start(&ctx, 3), MXT_SUCCESS);
+  assert_non_null(ctx.trace);
+
+  outer = mxt_trace_begin(&ctx, "outer", MXT_TRACE_NO_ARG);
+  inner = mxt_trace_begin(&ctx, "inner", 7);
+  mxt_trace_end(&ctx, inner);
+  mxt_trace_end(&ctx, outer);
+  open_span = mxt_trace_begin(&ctx, "open", 0);
+
+  assert_int_equal(outer, 0);
+  assert_int_equal(inner, 1);
+  assert_int_equal(open_span, 2);
+  assert_true(ctx.trace->spans[inner].start_us
+              >= ctx.trace->spans[outer].start_us);
+  assert_true(ctx.trace->spans[outer].end_us
+              >= ctx.trace->spans[inner].end_us);
+  assert_int_equal(ctx.trace->spans[open_span].end_us, 0);
+
+  /* Buffer full */
+  assert_int_equal(mxt_trace_begin(&ctx, "dropped", 0), -1);
+  assert_int_equal(ctx.trace->dropped, 1);
+
+  fd = mkstemp(path);
+  assert_true(fd >= 0);
+  close(fd);
+
+  assert_int_equal(mxt_trace_write(&ctx, path), MXT_SUCCESS);
+
+  fp = fopen(path, "r");
+  assert_non_null(fp);
+  len = fread(buf, 1, sizeof(buf) - 1, fp);
+  buf[len] = '\0';
+  fclose(fp);
+  unlink(path);
+
+  assert_true(strncmp(buf, "{\"traceEvents\":[", 16) == 0);
+  assert_non_null(strstr(buf, "{\"name\":\"outer\",\"ph\":\"X\""));
+  assert_non_null(strstr(buf, "\"args\":{\"n\":7}}"));
+  assert_non_null(strstr(buf, "{\"name\":\"open\""));
+  assert_null(strstr(buf, "\"name\":\"dropped\""));
+  assert_non_null(strstr(buf, "\"otherData\":{\"dropped\":1}}\n"));
+
+  mxt_trace_stop(&ctx);
+  assert_null(ctx.trace);
+}
+
+static void *trace_thread(void *arg)
+{
+  mxt_trace_begin((struct libmaxtouch_ctx *)arg, "thread", 0);
+  return NULL;
+}
+
+void mxt_trace_tid_test(void **state)
+{
+  struct libmaxtouch_ctx ctx;
+  pthread_t thread;
+  int main_span;
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.log_fn = mxt_log_stderr;
+  ctx.log_level = LOG_SILENT;
+
+  assert_int_equal(mxt_trace_start(&ctx, 2), MXT_SUCCESS);
+
+  main_span = mxt_trace_begin(&ctx, "main", 0);
+  assert_int_equal(pthread_create(&thread, NULL, trace_thread, &ctx), 0);
+  pthread_join(thread, NULL);
+
+  /* Each span carries the thread that began it */
+  assert_int_equal(ctx.trace->count, 2);
+  assert_int_equal(ctx.trace->spans[main_span].tid, syscall(SYS_gettid));
+  assert_true(ctx.trace->spans[1].tid != ctx.trace->spans[main_span].tid);
+
+  mxt_trace_stop(&ctx);
+}
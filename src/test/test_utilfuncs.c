@@ -80,3 +80,16 @@ void mxt_convert_hex_test(void **state)
   ret = mxt_convert_hex(hex, databuf, &count, sizeof(databuf));
   assert_int_equal(ret, MXT_ERROR_BAD_INPUT);
 }
+
+void mxt_convert_hex_single_test(void **state)
+{
+  uint8_t databuf[5] = {0};
+  char hex[5];
+  uint16_t count;
+
+  strcpy(hex, "09");
+  assert_int_equal(mxt_convert_hex(hex, databuf, &count, sizeof(databuf)),
+                   MXT_SUCCESS);
+  assert_int_equal(databuf[0], 9);
+  assert_int_equal(count, 1);
+}